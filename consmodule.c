@@ -1,11 +1,9 @@
 /****
  * Consider these all "maybes" for now:
  *
- * TODO: provide map and reduce (foldl,foldr) functions
  * TODO: add to_str, to_tuple, to_bytes (?)
- * TODO: make cons iterable, so it can be unpacked into a 2-tuple
- * TODO: provide a to_list_iter method, which iterates over each member of a proper cons list
- *       - see tupleobject.c, PyTupleIter_Type
+ * TODO: make cons pairs unpackable into a 2-tuple; iterating yields a proper list's
+ *       items, and raises TypeError for an improper list such as cons(1, 2)
  *
  ****/
 
@@ -14,27 +12,314 @@
 #include <structmember.h>
 #include <stdbool.h>
 
-#define IS_LIST(ptr) (((ConsObject *)ptr)->is_list)
+/* Python 3.12 has no critical sections; with the GIL they're no-ops anyway */
+#ifndef Py_BEGIN_CRITICAL_SECTION
+#define Py_BEGIN_CRITICAL_SECTION(op) {
+#define Py_END_CRITICAL_SECTION() }
+#endif
+
+/* Cells are immutable once built, except for their cached hash, and the tail of a
+   stream or chunked cell, which is replaced the first time it's needed (under the
+   cell's lock, see stream_force and chunk_force). In free-threaded builds, a replaced
+   tail is published with a release store and read with an acquire load, so a thread
+   that sees the new cell sees it filled in, and cached hashes are accessed atomically.
+   Elsewhere these are plain accesses. */
+#ifdef Py_GIL_DISABLED
+#define LOAD_TAIL(ptr) ((PyObject *)_Py_atomic_load_ptr_acquire(&((ConsObject *)ptr)->tail))
+#define PUBLISH_TAIL(op, value) _Py_atomic_store_ptr_release(&((ConsObject *)op)->tail, value)
+#define LOAD_SSIZE(field) _Py_atomic_load_ssize_relaxed(&(field))
+#define STORE_SSIZE(field, value) _Py_atomic_store_ssize_relaxed(&(field), value)
+#else
+#define LOAD_TAIL(ptr) CDR(ptr)
+#define PUBLISH_TAIL(op, value) SET_CDR(op, value)
+#define LOAD_SSIZE(field) (field)
+#define STORE_SSIZE(field, value) ((field) = (value))
+#endif
+
+#define IS_LIST(ptr) (((ConsObject *)ptr)->length > 0)
+#define IS_STREAM(ptr) (((ConsObject *)ptr)->length < 0)
+/* A cell of a proper list whose tail is a chunk of the rest of its items, see ChunkObject */
+#define IS_CHUNKED(ptr) (LENGTH(ptr) > 1 && !Py_IS_TYPE(LOAD_TAIL(ptr), Py_TYPE(ptr)))
+#define LENGTH(ptr) (((ConsObject *)ptr)->length)
 #define CAR(ptr) (((ConsObject *)ptr)->head)
 #define CDR(ptr) (((ConsObject *)ptr)->tail)
 #define SET_CAR(op, value) ((ConsObject *)op)->head = value
 #define SET_CDR(op, value) ((ConsObject *)op)->tail = value
-#define SET_IS_LIST(op, b) ((ConsObject *)op)->is_list = b
-#define Cons_NEW(cons_type) PyObject_GC_New(ConsObject, (PyTypeObject *)cons_type)
-#define Cons_NEW_PY(cons_type) \
-    (PyObject *)PyObject_GC_New(ConsObject, (PyTypeObject *)cons_type)
+#define SET_LENGTH(op, n) ((ConsObject *)op)->length = n
+#define Cons_NEW(state) cons_alloc(state)
+#define Cons_NEW_PY(state) (PyObject *)cons_alloc(state)
+
+/* Upper bound on the number of dead cells kept for reuse by each module instance. The
+   free-list is shared by all threads, so free-threaded builds do without it, and
+   allocate from the interpreter's per-thread heaps instead. */
+#ifndef CONS_MAXFREELIST
+#ifdef Py_GIL_DISABLED
+#define CONS_MAXFREELIST 0
+#else
+#define CONS_MAXFREELIST 8192
+#endif
+#endif
 
-// ((PyObject *)x, (PyObject *)ConsType, (PyObject *)nil) -> (PyObject *)y
-typedef PyObject *(*cmapfn_t)(PyObject *, PyObject *, PyObject *);
+/* Lists built in bulk with at least this many items are stored in a chunk */
+#ifndef CONS_CHUNK_MIN
+#define CONS_CHUNK_MIN 16
+#endif
 
-static struct PyModuleDef consmodule;
+/* Build with -DCONS_STATS=0 to compile out the counters reported by stats(). In
+   free-threaded builds, counters shared by every thread would have them all contend for
+   the same cache lines, so they're off unless asked for with -DCONS_STATS=1. */
+#ifndef CONS_STATS
+#ifdef Py_GIL_DISABLED
+#define CONS_STATS 0
+#else
+#define CONS_STATS 1
+#endif
+#endif
+
+/* The Cons type */
+typedef struct {
+    PyObject_HEAD PyObject *head;
+    PyObject *tail;
+    /* Number of cells up to the terminating nil for proper lists, -1 for streams (lists
+       whose tail may not have been computed yet, see cons_tail), 0 otherwise */
+    Py_ssize_t length;
+    /* Cached structural hash, -1 until computed */
+    Py_hash_t hash;
+    /* Lazily built data about the list starting at this cell (a ConsCacheObject), or NULL */
+    PyObject *cache;
+} ConsObject;
+
+/* A positional index over a list's spine, built by indexed() */
+typedef struct {
+    Py_ssize_t length;
+    /* The first 'split' cells of the list. They're borrowed, as the list keeps them. */
+    PyObject **cells;
+    Py_ssize_t split;
+    /* If the list is chunked after them, the rest of its items, from chunk->items[start]
+       on. The chunk is held on to, since making its cells drops the list's reference. */
+    struct ChunkObject *chunk;
+    Py_ssize_t start;
+} consindex;
+
+/* Cells are immutable, so anything derived from a list can be computed once and kept on
+   its first cell. */
+typedef struct {
+    PyObject_HEAD
+    /* dict mapping each key of an association list to its first pair, Py_None if the
+       list has unhashable keys, or NULL until built */
+    PyObject *assoc_index;
+    /* The list's positional index, or NULL until built */
+    consindex *index;
+} ConsCacheObject;
+
+/* The tail of a stream cell that hasn't been computed yet: the rest of the stream, still
+   to be drawn from an iterator. Forcing it replaces it in the cell, and it moves on to
+   the tail of the new cell, so each thunk belongs to exactly one cell. */
+typedef struct {
+    PyObject_HEAD
+    PyObject *it;
+    /* Set while drawing from it, to catch the iterator forcing its own stream */
+    bool forcing;
+} ThunkObject;
+
+/* The items of a list built in bulk, stored contiguously rather than one per cell
+   (cdr-coding). Such a list is a single cell whose tail is the chunk: a cell of length
+   n with a chunk tail stands for the last n items of the chunk, its head being the
+   first of them. The cells after it are only made when its tail is asked for, see
+   chunk_force; code that just reads the items walks the chunk instead, see conswalk. */
+typedef struct ChunkObject {
+    PyObject_VAR_HEAD
+    /* Py_SIZE items, filled in front to back by the builder */
+    PyObject *items[1];
+} ChunkObject;
+
+/* Counters reported by stats(). Updating one is a plain add on the module state, cheap
+   enough to leave on; CONS_STATS=0 compiles the updates out. */
+typedef struct {
+    Py_ssize_t cells_allocated;
+    Py_ssize_t cells_freed;
+    Py_ssize_t live_cells;
+    Py_ssize_t peak_live_cells;
+    /* Allocation requests for a known number of cells (cons_alloc_n), and the cells
+       they made */
+    Py_ssize_t bulk_allocs;
+    Py_ssize_t bulk_cells;
+    /* Lists built in bulk whose items were kept in a chunk */
+    Py_ssize_t chunked_lists;
+    /* Cells left untracked by the GC, see cons_track */
+    Py_ssize_t untracked_cells;
+    /* Calls, and pairs examined by them */
+    Py_ssize_t assoc_calls;
+    Py_ssize_t assoc_probes;
+    Py_ssize_t assp_calls;
+    Py_ssize_t assp_probes;
+    Py_ssize_t compare_calls;
+    Py_ssize_t hash_calls;
+    Py_ssize_t hash_max_depth;
+    Py_ssize_t lift_max_depth;
+} consstats;
 
 typedef struct {
     PyObject *NilType;
     PyObject *nil;
     PyObject *ConsType;
+    PyObject *ConsIterType;
+    PyObject *ConsBuilderType;
+    PyObject *ConsIndexType;
+    PyObject *ConsCacheType;
+    PyObject *ThunkType;
+    PyObject *ChunkType;
+    PyObject *HamtType;
+    PyObject *HamtNodeType;
+    PyObject *HamtIterType;
+    PyObject *PredicateType;
+    /* array.array, whose items from_xs reads straight from its buffer */
+    PyObject *ArrayType;
+    /* Dead cells waiting to be reused, linked through their tail pointers */
+    ConsObject *free_list;
+    Py_ssize_t numfree;
+    /* Free-list counters, reported by freelist_info() */
+    Py_ssize_t freelist_hits;
+    Py_ssize_t freelist_misses;
+    Py_ssize_t bulk_allocs;
+    consstats stats;
 } consmodule_state;
 
+/* Whether two cached hashes, either of which may not have been computed yet (-1), show
+   their objects can't be equal */
+static inline bool
+hashes_differ(Py_hash_t a, Py_hash_t b)
+{
+    return a != -1 && b != -1 && a != b;
+}
+
+/* Add n to a counter, returning its new value */
+static inline Py_ssize_t
+counter_add(Py_ssize_t *counter, Py_ssize_t n)
+{
+#ifdef Py_GIL_DISABLED
+    return _Py_atomic_add_ssize(counter, n) + n;
+#else
+    return *counter += n;
+#endif
+}
+
+static inline void
+counter_max(Py_ssize_t *counter, Py_ssize_t value)
+{
+#ifdef Py_GIL_DISABLED
+    Py_ssize_t old = _Py_atomic_load_ssize_relaxed(counter);
+    while (value > old && !_Py_atomic_compare_exchange_ssize(counter, &old, value))
+        ;
+#else
+    if (value > *counter)
+        *counter = value;
+#endif
+}
+
+/* The free-list counters are always kept with the GIL, and only with the stats in
+   free-threaded builds, for the same reason */
+#if CONS_STATS || !defined(Py_GIL_DISABLED)
+#define FREELIST_COUNT(state, name) ((void)counter_add(&(state)->name, 1))
+#else
+#define FREELIST_COUNT(state, name) ((void)0)
+#endif
+
+#if CONS_STATS
+#define STAT_ADD(state, name, n) ((void)counter_add(&(state)->stats.name, (n)))
+#define STAT_MAX(state, name, value) counter_max(&(state)->stats.name, (value))
+#else
+#define STAT_ADD(state, name, n) ((void)0)
+#define STAT_MAX(state, name, value) ((void)0)
+#endif
+#define STAT_INC(state, name) STAT_ADD(state, name, 1)
+
+// ((PyObject *)x, (consmodule_state *)state) -> (PyObject *)y, a new reference
+typedef PyObject *(*cmapfn_t)(PyObject *, consmodule_state *);
+
+static struct PyModuleDef consmodule;
+
+/* A growable stack of borrowed pointers, used in place of C recursion when walking
+   arbitrarily long or deeply nested structures. Starts out in a small inline buffer. */
+typedef struct {
+    PyObject **items;
+    Py_ssize_t size;
+    Py_ssize_t capacity;
+    PyObject *small[64];
+} ptrstack;
+
+static inline void
+ptrstack_init(ptrstack *stack)
+{
+    stack->items = stack->small;
+    stack->size = 0;
+    stack->capacity = Py_ARRAY_LENGTH(stack->small);
+}
+
+static int
+ptrstack_push(ptrstack *stack, PyObject *op)
+{
+    if (stack->size == stack->capacity) {
+        Py_ssize_t capacity = stack->capacity * 2;
+        PyObject **items;
+        if (stack->items == stack->small) {
+            items = PyMem_New(PyObject *, (size_t)capacity);
+            if (items != NULL)
+                memcpy(items, stack->small, sizeof(stack->small));
+        }
+        else {
+            items = stack->items;
+            PyMem_Resize(items, PyObject *, (size_t)capacity);
+        }
+        if (items == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        stack->items = items;
+        stack->capacity = capacity;
+    }
+    stack->items[stack->size++] = op;
+    return 0;
+}
+
+static inline PyObject *
+ptrstack_pop(ptrstack *stack)
+{
+    return stack->items[--stack->size];
+}
+
+static inline void
+ptrstack_fini(ptrstack *stack)
+{
+    if (stack->items != stack->small)
+        PyMem_Free(stack->items);
+}
+
+/* Grow a stack of frames that starts out in the inline buffer 'small', if it's full.
+   Returns the (possibly moved) frames, or NULL on failure. */
+static void *
+framestack_reserve(void *frames, void *small, Py_ssize_t size, Py_ssize_t *capacity,
+                   size_t framesize)
+{
+    if (size < *capacity)
+        return frames;
+    Py_ssize_t new_capacity = *capacity * 2;
+    void *grown;
+    if (frames == small) {
+        grown = PyMem_Malloc((size_t)new_capacity * framesize);
+        if (grown != NULL)
+            memcpy(grown, small, (size_t)size * framesize);
+    }
+    else
+        grown = PyMem_Realloc(frames, (size_t)new_capacity * framesize);
+    if (grown == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    *capacity = new_capacity;
+    return grown;
+}
+
 /* The Nil type */
 typedef struct {
     PyObject_HEAD
@@ -69,12 +354,58 @@ Nil_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
     return self;
 }
 
+/* The result of comparing two structures whose first difference is that one of them
+   ended (at nil) while the other carried on (with a cons): the shorter one is smaller. */
+static PyObject *
+richcompare_shorter(int op, bool self_is_shorter)
+{
+    switch (op) {
+    case Py_EQ:
+        Py_RETURN_FALSE;
+    case Py_NE:
+        Py_RETURN_TRUE;
+    case Py_LT:
+    case Py_LE:
+        return PyBool_FromLong(self_is_shorter);
+    default:
+        return PyBool_FromLong(!self_is_shorter);
+    }
+}
+
+/* nil() is the empty list, so it orders before any cons, like () before a tuple */
+static PyObject *
+Nil_richcompare(PyObject *self, PyObject *other, int op)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    if (Py_Is(other, self))
+        Py_RETURN_RICHCOMPARE(0, 0, op);
+    else if (Py_IS_TYPE(other, (PyTypeObject *)state->ConsType))
+        return richcompare_shorter(op, true);
+    Py_RETURN_NOTIMPLEMENTED;
+}
+
+/* A defined richcompare stops the hash being inherited. nil() is a singleton, so any
+   constant will do. */
+static Py_hash_t
+Nil_hash(PyObject *self)
+{
+    return 0x6e696c;
+}
+
 static int
 Nil_bool(PyObject *self)
 {
     return 0;
 }
 
+static Py_ssize_t
+Nil_length(PyObject *self)
+{
+    return 0;
+}
+
 static PyObject *
 Nil_to_list(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
             Py_ssize_t nargs, PyObject *kwnames)
@@ -86,20 +417,61 @@ Nil_to_list(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
     return PyList_New(0);
 }
 
+static PyObject *
+cons_indexed(consmodule_state *, PyObject *);
+
+PyDoc_STRVAR(indexed_doc, "indexed()\n\
+\n\
+Return a view of the list with O(1) indexing, len() and slicing. The view's index\n\
+is built on the first call and cached on the list's first cell.");
+
+/* nil.indexed() and cons.indexed() */
+PyObject *
+Cons_indexed(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
+             Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 0 || kwnames != NULL) {
+        PyErr_SetString(PyExc_TypeError, "indexed() takes no arguments");
+        return NULL;
+    }
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+    return cons_indexed(state, self);
+}
+
+static PyObject *
+ConsIter_new(consmodule_state *, PyObject *);
+
+static PyObject *
+Nil_iter(PyObject *self)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    return ConsIter_new(state, NULL);
+}
+
 PyDoc_STRVAR(Nil_doc, "Get the singleton nil object");
 PyDoc_STRVAR(Nil_to_list_doc, "Convert nil to an empty Python list");
 
 static PyMethodDef Nil_methods[] = {
     {"to_list", (PyCFunction)Nil_to_list, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
      Nil_to_list_doc},
+    {"indexed", (PyCFunction)Cons_indexed, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     indexed_doc},
     {NULL, NULL}};
 
 static PyType_Slot Nil_Type_Slots[] = {
     {Py_tp_doc, (void *)Nil_doc},
     {Py_tp_new, Nil_new},
     {Py_tp_repr, Nil_repr},
+    {Py_tp_iter, Nil_iter},
+    {Py_tp_richcompare, Nil_richcompare},
+    {Py_tp_hash, Nil_hash},
     {Py_tp_traverse, Nil_traverse},
     {Py_nb_bool, Nil_bool},
+    {Py_sq_length, Nil_length},
     {Py_tp_methods, Nil_methods},
     {0, NULL},
 };
@@ -111,53 +483,128 @@ static PyType_Spec Nil_Type_Spec = {
     .slots = Nil_Type_Slots,
 };
 
-/* The Cons type */
-typedef struct {
-    PyObject_HEAD PyObject *head;
-    PyObject *tail;
-    bool is_list;
-} ConsObject;
+/* Cell allocation
 
-PyObject *
-Cons_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+   Cells are recycled through a per-module free-list, in the same way tupleobject.c
+   recycles small tuples. A cell on the free-list is untracked, holds no references
+   (not even to its type) and is linked to the next free cell through its tail.
+*/
+static ConsObject *
+cons_alloc(consmodule_state *state)
 {
-    consmodule_state *state = PyType_GetModuleState(type);
-    if (state == NULL)
-        return NULL;
-    PyTypeObject *cons_type = (PyTypeObject *)state->ConsType;
-
-    PyObject *head = NULL, *tail = NULL;
-    static char *kwlist[] = {"head", "tail", NULL};
-
-    // Parse arguments BEFORE allocating the object, so we don't need
-    // to decref etc. if this fails.
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO", kwlist, &head, &tail))
-        return NULL;
+    ConsObject *op = state->free_list;
+    if (op == NULL) {
+        FREELIST_COUNT(state, freelist_misses);
+        op = PyObject_GC_New(ConsObject, (PyTypeObject *)state->ConsType);
+        if (op == NULL)
+            return NULL;
+    }
+    else {
+        state->free_list = (ConsObject *)op->tail;
+        state->numfree--;
+        FREELIST_COUNT(state, freelist_hits);
+        PyObject_Init((PyObject *)op, (PyTypeObject *)state->ConsType);
+    }
+    STAT_INC(state, cells_allocated);
+    /* live_cells is only counted along with the other stats */
+    STAT_MAX(state, peak_live_cells, counter_add(&state->stats.live_cells, 1));
+    op->hash = -1;
+    op->cache = NULL;
+    return op;
+}
 
-    // Now allocate the object
-    ConsObject *self = Cons_NEW(cons_type);
-    if (self == NULL)
-        return NULL;
+/* Release a chain made by cons_alloc_n, along with any heads already filled in */
+static void
+cons_release_chain(ConsObject *chain)
+{
+    while (chain != NULL) {
+        ConsObject *next = (ConsObject *)chain->tail;
+        Py_CLEAR(chain->head);
+        chain->tail = NULL;
+        Py_DECREF(chain);
+        chain = next;
+    }
+}
 
-    // Initialize fields
-    self->head = NULL;
-    self->tail = NULL;
-    self->is_list = false;
+/* Allocate n cells in one go for builders that know the length of their result up
+   front. The cells are returned linked through their tails (the last tail is NULL),
+   with heads set to NULL; take them off the chain with cons_take. Returns NULL and
+   sets an exception on failure. */
+static ConsObject *
+cons_alloc_n(consmodule_state *state, Py_ssize_t n)
+{
+    ConsObject *chain = NULL;
+    FREELIST_COUNT(state, bulk_allocs);
+    STAT_INC(state, bulk_allocs);
+    STAT_ADD(state, bulk_cells, n);
+    for (Py_ssize_t i = 0; i < n; i++) {
+        ConsObject *op = cons_alloc(state);
+        if (op == NULL) {
+            cons_release_chain(chain);
+            return NULL;
+        }
+        op->head = NULL;
+        op->tail = (PyObject *)chain;
+        chain = op;
+    }
+    return chain;
+}
 
-    PyObject_GC_Track(self);
+/* Pop a cell from a chain made by cons_alloc_n, falling back to a single allocation
+   if the chain has run out. */
+static inline ConsObject *
+cons_take(consmodule_state *state, ConsObject **chain)
+{
+    ConsObject *op = *chain;
+    if (op == NULL) {
+        if ((op = cons_alloc(state)) != NULL)
+            op->head = op->tail = NULL;
+        return op;
+    }
+    *chain = (ConsObject *)op->tail;
+    return op;
+}
 
-    if (Py_Is(tail, state->nil))
-        self->is_list = true;
-    else if (Py_IS_TYPE(tail, cons_type))
-        self->is_list = IS_LIST(tail);
+/* Whether op can never be part of a reference cycle: it isn't a container, or it's an
+   immutable one that was left untracked because it can't be either. This is CPython's
+   own test for tuples (_PyObject_GC_MAY_BE_TRACKED), extended to cells and chunks.
+   Other untracked containers, like empty dicts, may be tracked later. */
+static inline bool
+cons_is_atom(consmodule_state *state, PyObject *op)
+{
+    if (!PyObject_IS_GC(op))
+        return true;
+    PyTypeObject *tp = Py_TYPE(op);
+    if (tp == &PyTuple_Type || tp == (PyTypeObject *)state->ConsType ||
+        tp == (PyTypeObject *)state->ChunkType)
+        return !PyObject_GC_IsTracked(op);
+    return false;
+}
 
-    Py_INCREF(head);
-    self->head = head;
-    Py_INCREF(tail);
-    self->tail = tail;
+/* Track a freshly built cell with the GC, unless its head and tail are atoms, like cells
+   of a list of ints or strings: those can never be part of a cycle, so collections can
+   skip them. A cell's head and tail don't change once it's built, except that a lazy
+   tail is replaced by the cell it stands for, which is an atom if it was, so a cell left
+   untracked stays untracked. Streams are always tracked, as their thunks are. */
+static inline void
+cons_track(consmodule_state *state, PyObject *cell)
+{
+    if (cons_is_atom(state, CAR(cell)) && cons_is_atom(state, CDR(cell)))
+        STAT_INC(state, untracked_cells);
+    else
+        PyObject_GC_Track(cell);
+}
 
-    return (PyObject *)self;
-};
+static void
+cons_freelist_clear(consmodule_state *state)
+{
+    while (state->free_list != NULL) {
+        ConsObject *op = state->free_list;
+        state->free_list = (ConsObject *)op->tail;
+        PyObject_GC_Del(op);
+    }
+    state->numfree = 0;
+}
 
 static int
 Cons_traverse(ConsObject *self, visitproc visit, void *arg)
@@ -165,6 +612,7 @@ Cons_traverse(ConsObject *self, visitproc visit, void *arg)
     Py_VISIT(Py_TYPE(self));
     Py_VISIT(self->head);
     Py_VISIT(self->tail);
+    Py_VISIT(self->cache);
     return 0;
 }
 
@@ -173,557 +621,6374 @@ Cons_clear(PyObject *self)
 {
     Py_CLEAR(CAR(self));
     Py_CLEAR(CDR(self));
+    Py_CLEAR(((ConsObject *)self)->cache);
     return 0;
 }
 
-void
-Cons_dealloc(ConsObject *self)
-{
-    PyObject_ClearWeakRefs((PyObject *)self);
-    PyObject_GC_UnTrack(self);
-    Py_TRASHCAN_BEGIN(self, Cons_dealloc);
-    Cons_clear((PyObject *)self);
-    Py_TYPE(self)->tp_free(self);
-    Py_TRASHCAN_END;
-}
+/* Cells released by Cons_dealloc that it holds the only reference to, whose head and
+   tail it still has to release */
+#define CONS_RELEASE_INLINE 64
 
-static inline PyObject *
-identity(PyObject *op, PyObject *cons_type, PyObject *nil)
+typedef struct {
+    PyObject **items;
+    Py_ssize_t size, capacity;
+    PyObject *inline_items[CONS_RELEASE_INLINE];
+} releasestack;
+
+/* Whether the caller holds the only reference to a cell, so no one else can see it being
+   taken apart */
+static inline bool
+cons_is_unique(PyObject *op, PyTypeObject *tp)
 {
-    return op;
+    if (op == NULL || !Py_IS_TYPE(op, tp))
+        return false;
+#ifdef Py_GIL_DISABLED
+    return _Py_IsOwnedByCurrentThread(op) && op->ob_ref_local == 1 &&
+           _Py_atomic_load_ssize_relaxed(&op->ob_ref_shared) == 0;
+#else
+    return Py_REFCNT(op) == 1;
+#endif
 }
 
-PyObject *
-Cons_from_fast_with(PyObject *xs, PyObject *cons_type, PyObject *nil, cmapfn_t f)
+/* Release a reference to a cell's head or tail, deferring it to the stack if it's a cell
+   that would be destroyed along with its own head and tail */
+static void
+cons_release(releasestack *stack, PyObject *child, PyTypeObject *tp)
 {
-    Py_ssize_t len = PySequence_Fast_GET_SIZE(xs);
-
-    PyObject *result = nil;
-    Py_INCREF(nil);
-    PyObject *item = NULL, *current = NULL, *tmp = NULL;
-    for (Py_ssize_t i = len - 1; i >= 0; i--) {
-        item = PySequence_Fast_GET_ITEM(xs, i);
-        Py_INCREF(item);
-        current = Cons_NEW_PY(cons_type);
-        if (current == NULL) {
-            Py_DECREF(item);
-            Py_DECREF(result);
-            return NULL;
-        }
-
-        tmp = f(item, cons_type, nil);
-        if (tmp == NULL) {
-            Py_DECREF(item);
-            Py_DECREF(result);
-            return NULL;
+    if (!cons_is_unique(child, tp)) {
+        Py_XDECREF(child);
+        return;
+    }
+    if (stack->size == stack->capacity) {
+        Py_ssize_t capacity = stack->capacity * 2;
+        PyObject **items = stack->items == stack->inline_items
+                               ? PyMem_Malloc((size_t)capacity * sizeof(PyObject *))
+                               : PyMem_Realloc(stack->items,
+                                               (size_t)capacity * sizeof(PyObject *));
+        if (items == NULL) {
+            /* Out of memory: fall back on releasing it recursively */
+            Py_DECREF(child);
+            return;
         }
-        SET_CAR(current, tmp);
-        SET_CDR(current, result);
-        PyObject_GC_Track(current);
-        SET_IS_LIST(current, true);
-        result = current;
+        if (stack->items == stack->inline_items)
+            memcpy(items, stack->inline_items, sizeof(stack->inline_items));
+        stack->items = items;
+        stack->capacity = capacity;
     }
-
-    return result;
+    stack->items[stack->size++] = child;
 }
 
-PyObject *
-Cons_from_gen_with(PyObject *xs, PyObject *cons_type, PyObject *nil, cmapfn_t f)
+/* Destroying a cell releases its tail, which may destroy the next cell and so on: with
+   plain recursion, freeing a long list would overflow the C stack. Instead, the
+   outermost Cons_dealloc takes apart every cell it holds the only reference to itself,
+   with an explicit stack, so the deallocs of those cells have nothing left to release
+   and freeing a chain of any length or depth takes constant C stack. Cells that are
+   shared are just decref'd. Tails are pushed before heads, so the stack only grows with
+   the nesting of heads. */
+void
+Cons_dealloc(ConsObject *self)
 {
-    PyObject *head = NULL, *current = NULL, *item = NULL, *tmp = NULL;
-    while ((item = PyIter_Next(xs)) != NULL) {
-        tmp = Cons_NEW_PY(cons_type);
-        if (tmp == NULL) {
-            Py_DECREF(item);
-            return NULL;
-        }
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_ClearWeakRefs((PyObject *)self);
+    PyObject_GC_UnTrack(self);
+    Py_CLEAR(self->cache);
 
-        PyObject *_item = f(item, cons_type, nil);
-        if (_item == NULL) {
-            Py_DECREF(item);
-            return NULL;
-        }
-        SET_CAR(tmp, _item);
-        SET_IS_LIST(tmp, true);
+    if (CAR(self) != NULL || CDR(self) != NULL) {
+        releasestack stack = {
+            .items = stack.inline_items, .size = 0, .capacity = CONS_RELEASE_INLINE};
+        PyObject *cell = (PyObject *)self;
+        for (;;) {
+            PyObject *head = CAR(cell), *tail = CDR(cell);
+            SET_CAR(cell, NULL);
+            SET_CDR(cell, NULL);
+            cons_release(&stack, tail, tp);
+            cons_release(&stack, head, tp);
+            if (!Py_Is(cell, (PyObject *)self))
+                Py_DECREF(cell);
 
-        if (head == NULL)
-            head = current = tmp;
-        else {
-            SET_CDR(current, tmp);
-            PyObject_GC_Track(current);
-            current = tmp;
+            /* Releasing the other cells may have run code that took a new reference to
+               one still on the stack, through a weakref, in which case it's left whole */
+            while (stack.size > 0 && !cons_is_unique(stack.items[stack.size - 1], tp))
+                Py_DECREF(stack.items[--stack.size]);
+            if (stack.size == 0)
+                break;
+            cell = stack.items[--stack.size];
         }
+        if (stack.items != stack.inline_items)
+            PyMem_Free(stack.items);
     }
 
-    if (current == NULL) {
-        if (PyErr_Occurred())
-            return NULL;
-        else {
-            /* Empty generator */
-            Py_INCREF(nil);
-            return nil;
-        }
+    consmodule_state *state = PyType_GetModuleState(tp);
+    if (state != NULL) {
+        STAT_INC(state, cells_freed);
+        STAT_ADD(state, live_cells, -1);
+    }
+    if (state != NULL && state->numfree < CONS_MAXFREELIST) {
+        SET_CDR(self, (PyObject *)state->free_list);
+        state->free_list = self;
+        state->numfree++;
+    }
+    else
+        tp->tp_free(self);
+    Py_DECREF(tp);
+}
+
+/* Fill in the lengths of a freshly built proper list of n cells, for builders that
+   link their cells front to back and only know n at the end, and track them. A cell
+   must be tracked if its head or any head after it isn't an atom (see cons_track), so
+   this is every cell up to the last such head. */
+static void
+cons_finish_spine(consmodule_state *state, PyObject *head, Py_ssize_t n)
+{
+    Py_ssize_t tracked = 0;
+    PyObject *cell = head;
+    for (Py_ssize_t i = 0; i < n; i++, cell = CDR(cell)) {
+        SET_LENGTH(cell, n - i);
+        if (!cons_is_atom(state, CAR(cell)))
+            tracked = i + 1;
     }
+    cell = head;
+    for (Py_ssize_t i = 0; i < tracked; i++, cell = CDR(cell))
+        PyObject_GC_Track(cell);
+    STAT_ADD(state, untracked_cells, n - tracked);
+}
 
-    Py_IncRef(nil);
-    SET_CDR(current, nil);
-    PyObject_GC_Track(current);
-    return head;
+/* The length to store in a cell with the given tail: one more than the tail's if it's a
+   proper list, -1 if it's a stream, or 0 */
+static inline Py_ssize_t
+cons_length_with_tail(consmodule_state *state, PyObject *tail)
+{
+    if (Py_Is(tail, state->nil))
+        return 1;
+    else if (!Py_IS_TYPE(tail, (PyTypeObject *)state->ConsType))
+        return 0;
+    else if (IS_STREAM(tail))
+        return -1;
+    return IS_LIST(tail) ? LENGTH(tail) + 1 : 0;
 }
 
-PyObject *
-Cons_from_xs(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
-             Py_ssize_t nargs, PyObject *kwnames)
+/* A new cell with the given head and tail */
+static PyObject *
+cons_new_pair(consmodule_state *state, PyObject *head, PyObject *tail)
 {
-    if (nargs != 1) {
-        PyErr_SetString(PyExc_TypeError, "cons.from_xs takes exactly one argument");
+    ConsObject *self = Cons_NEW(state);
+    if (self == NULL)
         return NULL;
-    }
+    self->head = Py_NewRef(head);
+    self->tail = Py_NewRef(tail);
+    self->length = cons_length_with_tail(state, tail);
+    cons_track(state, (PyObject *)self);
+    return (PyObject *)self;
+}
 
-    consmodule_state *state = PyType_GetModuleState(defining_class);
+PyObject *
+Cons_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    consmodule_state *state = PyType_GetModuleState(type);
     if (state == NULL)
         return NULL;
 
-    PyObject *xs = args[0], *result = NULL;
-    if (PyGen_Check(xs))
-        result = Cons_from_gen_with(xs, state->ConsType, state->nil, &identity);
-    else if ((xs = PySequence_Fast(xs, "Expected a sequence or iterable")) != NULL)
-        result = Cons_from_fast_with(xs, state->ConsType, state->nil, &identity);
-    else
+    PyObject *head = NULL, *tail = NULL;
+    static char *kwlist[] = {"head", "tail", NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OO", kwlist, &head, &tail))
         return NULL;
-
-    Py_DECREF(xs);
-    return result;
+    return cons_new_pair(state, head, tail);
 }
 
+/* cons(head, tail) skips building an argument tuple. Calls with keywords, or the wrong
+   number of arguments, go through Cons_new to be parsed and reported the usual way. */
 static PyObject *
-lift(PyObject *, PyObject *, PyObject *);
-
-static PyObject *
-lift_dict(PyObject *op, PyObject *cons_type, PyObject *nil)
+Cons_vectorcall(PyObject *type, PyObject *const *args, size_t nargsf, PyObject *kwnames)
 {
-    Py_ssize_t nitems = PyObject_Size(op);
-    if (nitems < 0)
+    Py_ssize_t nargs = PyVectorcall_NARGS(nargsf);
+    consmodule_state *state = PyType_GetModuleState((PyTypeObject *)type);
+    if (state == NULL)
         return NULL;
-    else if (nitems == 0) {
-        Py_INCREF(nil);
-        return nil;
-    }
+    if (nargs == 2 && kwnames == NULL)
+        return cons_new_pair(state, args[0], args[1]);
 
-    PyObject *key, *value;
-    Py_ssize_t pos = 0;
-    PyObject *head = NULL, *current = NULL;
-    while (PyDict_Next(op, &pos, &key, &value)) {
-        PyObject *car = NULL, *cdr = NULL, *tmp = NULL;
-        if ((car = lift(key, cons_type, nil)) == NULL)
-            return NULL;
-        if ((cdr = lift(value, cons_type, nil)) == NULL) {
-            Py_DECREF(car);
-            return NULL;
+    PyObject *result = NULL, *kwds = NULL;
+    PyObject *tuple = PyTuple_New(nargs);
+    if (tuple == NULL)
+        return NULL;
+    for (Py_ssize_t i = 0; i < nargs; i++)
+        PyTuple_SET_ITEM(tuple, i, Py_NewRef(args[i]));
+    if (kwnames != NULL) {
+        if ((kwds = PyDict_New()) == NULL)
+            goto done;
+        for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(kwnames); i++) {
+            if (PyDict_SetItem(kwds, PyTuple_GET_ITEM(kwnames, i), args[nargs + i]) < 0)
+                goto done;
         }
+    }
+    result = Cons_new((PyTypeObject *)type, tuple, kwds);
 
-        PyObject *pair = Cons_NEW_PY(cons_type);
-        if (pair == NULL) {
-            Py_DECREF(car);
-            Py_DECREF(cdr);
+done:
+    Py_DECREF(tuple);
+    Py_XDECREF(kwds);
+    return result;
+}
+
+/* Streams
+
+   A stream cell's tail starts out as a thunk. The first time it's needed, the next item
+   is drawn from the thunk's iterator and the thunk is replaced with a new stream cell
+   holding it (and the thunk), or with nil once the iterator is exhausted. */
+static PyObject *
+stream_force_locked(consmodule_state *state, PyObject *cell)
+{
+    PyObject *tail = CDR(cell);
+    if (!Py_IS_TYPE(tail, (PyTypeObject *)state->ThunkType))
+        return tail;
+
+    ThunkObject *thunk = (ThunkObject *)tail;
+    if (thunk->forcing) {
+        PyErr_SetString(PyExc_RuntimeError, "stream tail needed while it was being computed");
+        return NULL;
+    }
+
+    /* Allocate first, so an item is never drawn and then dropped */
+    PyObject *next = Cons_NEW_PY(state);
+    if (next == NULL)
+        return NULL;
+    SET_CAR(next, NULL);
+    SET_CDR(next, NULL);
+
+    thunk->forcing = true;
+    PyObject *item = PyIter_Next(thunk->it);
+    thunk->forcing = false;
+    if (item == NULL) {
+        Py_DECREF(next);
+        if (PyErr_Occurred())
             return NULL;
+        PUBLISH_TAIL(cell, Py_NewRef(state->nil));
+        Py_DECREF(thunk);
+        return state->nil;
+    }
+
+    /* The cell's reference to the thunk moves to the new cell */
+    SET_CAR(next, item);
+    SET_CDR(next, (PyObject *)thunk);
+    SET_LENGTH(next, -1);
+    PyObject_GC_Track(next);
+    PUBLISH_TAIL(cell, next);
+    return next;
+}
+
+static PyObject *
+stream_force(PyObject *cell)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(cell));
+    if (state == NULL)
+        return NULL;
+    /* Only the first thread to get here forces the tail, the others see the new cell */
+    PyObject *tail = LOAD_TAIL(cell);
+    if (!Py_IS_TYPE(tail, (PyTypeObject *)state->ThunkType))
+        return tail;
+    Py_BEGIN_CRITICAL_SECTION(cell);
+    tail = stream_force_locked(state, cell);
+    Py_END_CRITICAL_SECTION();
+    return tail;
+}
+
+/* Chunks
+
+   A chunked cell's tail is made from the chunk the first time it's needed, and replaces
+   the chunk in the cell. The cell's reference to the chunk moves on to the new cell,
+   which is chunked in turn unless it's the last. */
+static PyObject *
+chunk_force_locked(consmodule_state *state, PyObject *cell)
+{
+    if (!IS_CHUNKED(cell))
+        return CDR(cell);
+    ChunkObject *chunk = (ChunkObject *)CDR(cell);
+    Py_ssize_t length = LENGTH(cell) - 1;
+
+    PyObject *next = Cons_NEW_PY(state);
+    if (next == NULL)
+        return NULL;
+    SET_CAR(next, Py_NewRef(chunk->items[Py_SIZE(chunk) - length]));
+    SET_CDR(next, length > 1 ? (PyObject *)chunk : Py_NewRef(state->nil));
+    SET_LENGTH(next, length);
+    cons_track(state, next);
+    PUBLISH_TAIL(cell, next);
+    if (length == 1)
+        Py_DECREF(chunk);
+    return next;
+}
+
+static PyObject *
+chunk_force(PyObject *cell)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(cell));
+    if (state == NULL)
+        return NULL;
+    PyObject *tail;
+    Py_BEGIN_CRITICAL_SECTION(cell);
+    tail = chunk_force_locked(state, cell);
+    Py_END_CRITICAL_SECTION();
+    return tail;
+}
+
+/* If cell is chunked, return a new reference to its chunk and set *start to the index of
+   the item after the cell's head, else return NULL. Another thread making the cell's
+   tail would hand the cell's reference to the chunk on to the new cell, so the chunk is
+   taken under the cell's lock. */
+static inline ChunkObject *
+cons_chunk_ref(PyObject *cell, Py_ssize_t *start)
+{
+    ChunkObject *chunk = NULL;
+    if (IS_CHUNKED(cell)) {
+        Py_BEGIN_CRITICAL_SECTION(cell);
+        if (IS_CHUNKED(cell)) {
+            chunk = (ChunkObject *)Py_NewRef(CDR(cell));
+            *start = Py_SIZE(chunk) - LENGTH(cell) + 1;
+        }
+        Py_END_CRITICAL_SECTION();
+    }
+    return chunk;
+}
+
+/* The tail of a cell, forced first if it's a stream cell or made from the chunk if it's
+   a chunked cell. Returns a borrowed reference, or NULL on error. Pairs and cells that
+   already have their tail only pay for the length checks. */
+static inline PyObject *
+cons_tail(PyObject *cell)
+{
+    if (IS_STREAM(cell))
+        return stream_force(cell);
+    else if (IS_CHUNKED(cell))
+        return chunk_force(cell);
+    return LOAD_TAIL(cell);
+}
+
+/* A cursor over the items of a list that reads chunks directly rather than making their
+   cells, and forces streams an item ahead. Making a chunk's cells may drop the list's
+   reference to it, so the cursor keeps the chunk it's reading alive, which also keeps
+   the items it has returned alive; release it with conswalk_fini. */
+typedef struct {
+    /* The cell holding the next item, or once the walk is done, the terminating object */
+    PyObject *cell;
+    /* The chunk being read, from the item at index on */
+    ChunkObject *chunk;
+    Py_ssize_t index;
+} conswalk;
+
+#define CONSWALK_INIT(op) {(op), NULL, 0}
+
+static inline bool
+conswalk_in_chunk(conswalk *walk)
+{
+    return walk->chunk != NULL && walk->index < Py_SIZE(walk->chunk);
+}
+
+/* Whether the walk has reached the object terminating the list, now in walk->cell */
+static inline bool
+conswalk_done(consmodule_state *state, conswalk *walk)
+{
+    return !conswalk_in_chunk(walk) &&
+           !Py_IS_TYPE(walk->cell, (PyTypeObject *)state->ConsType);
+}
+
+/* Set *item to a borrowed reference to the next item. Returns 1 if there is one, 0 at
+   the end of the list, or -1 on error (only when forcing a stream). */
+static inline int
+conswalk_next(consmodule_state *state, conswalk *walk, PyObject **item)
+{
+    if (conswalk_in_chunk(walk)) {
+        *item = walk->chunk->items[walk->index++];
+        return 1;
+    }
+    PyObject *cell = walk->cell;
+    if (!Py_IS_TYPE(cell, (PyTypeObject *)state->ConsType))
+        return 0;
+    *item = CAR(cell);
+    Py_ssize_t start;
+    ChunkObject *chunk = cons_chunk_ref(cell, &start);
+    if (chunk != NULL) {
+        /* The rest of the list is in the chunk */
+        Py_XSETREF(walk->chunk, chunk);
+        walk->index = start;
+        walk->cell = state->nil;
+    }
+    else if ((walk->cell = cons_tail(cell)) == NULL)
+        return -1;
+    return 1;
+}
+
+/* Set *item to a borrowed reference to the next item without moving past it, so a
+   stream's next tail isn't forced. Returns 1 if there is one, or 0 at the end. */
+static inline int
+conswalk_peek(consmodule_state *state, conswalk *walk, PyObject **item)
+{
+    if (conswalk_in_chunk(walk)) {
+        *item = walk->chunk->items[walk->index];
+        return 1;
+    }
+    else if (!Py_IS_TYPE(walk->cell, (PyTypeObject *)state->ConsType))
+        return 0;
+    *item = CAR(walk->cell);
+    return 1;
+}
+
+/* A new cell for the items of a chunk from index on, sharing the chunk */
+static PyObject *
+chunk_cell_at(consmodule_state *state, ChunkObject *chunk, Py_ssize_t index)
+{
+    Py_ssize_t length = Py_SIZE(chunk) - index;
+    PyObject *cell = Cons_NEW_PY(state);
+    if (cell == NULL)
+        return NULL;
+    SET_CAR(cell, Py_NewRef(chunk->items[index]));
+    SET_CDR(cell, Py_NewRef(length > 1 ? (PyObject *)chunk : state->nil));
+    SET_LENGTH(cell, length);
+    cons_track(state, cell);
+    return cell;
+}
+
+/* A new reference to the rest of the list being walked. In the middle of a chunk, this
+   is a new cell sharing it. */
+static PyObject *
+conswalk_rest(consmodule_state *state, conswalk *walk)
+{
+    if (!conswalk_in_chunk(walk))
+        return Py_NewRef(walk->cell);
+    return chunk_cell_at(state, walk->chunk, walk->index);
+}
+
+static inline void
+conswalk_fini(conswalk *walk)
+{
+    Py_CLEAR(walk->chunk);
+}
+
+static inline PyObject *
+identity(PyObject *op, consmodule_state *state)
+{
+    return Py_NewRef(op);
+}
+
+/* Builds a proper list front to back, for producers that don't know their length up
+   front. The cells are tracked, if need be, once the list is finished. */
+typedef struct {
+    PyObject *head;
+    PyObject *last;
+    Py_ssize_t n;
+} consbuilder;
+
+#define CONSBUILDER_INIT {NULL, NULL, 0}
+
+/* Append item to the list under construction, stealing the reference */
+static int
+consbuilder_append(consmodule_state *state, consbuilder *builder, PyObject *item)
+{
+    PyObject *cell = Cons_NEW_PY(state);
+    if (cell == NULL) {
+        Py_DECREF(item);
+        return -1;
+    }
+    SET_CAR(cell, item);
+    SET_CDR(cell, NULL);
+
+    if (builder->head == NULL)
+        builder->head = cell;
+    else
+        SET_CDR(builder->last, cell);
+    builder->last = cell;
+    builder->n++;
+    return 0;
+}
+
+/* Terminate the list with nil and return it, or nil if nothing was appended */
+static PyObject *
+consbuilder_finish(consmodule_state *state, consbuilder *builder)
+{
+    if (builder->head == NULL)
+        return Py_NewRef(state->nil);
+
+    SET_CDR(builder->last, Py_NewRef(state->nil));
+    cons_finish_spine(state, builder->head, builder->n);
+    PyObject *result = builder->head;
+    builder->head = builder->last = NULL;
+    builder->n = 0;
+    return result;
+}
+
+/* Release the cells built so far. They end in a NULL tail, which dealloc tolerates. */
+static void
+consbuilder_abort(consbuilder *builder)
+{
+    Py_CLEAR(builder->head);
+    builder->last = NULL;
+    builder->n = 0;
+}
+
+/* Build the cells of a spine in front of tail, stealing the references to the items and
+   the tail */
+static PyObject *
+cons_from_spine(consmodule_state *state, PyObject *const *items, Py_ssize_t n,
+                PyObject *tail)
+{
+    ConsObject *chain = cons_alloc_n(state, n);
+    if (chain == NULL && n > 0) {
+        for (Py_ssize_t i = 0; i < n; i++)
+            Py_DECREF(items[i]);
+        Py_DECREF(tail);
+        return NULL;
+    }
+
+    PyObject *result = tail;
+    for (Py_ssize_t i = n - 1; i >= 0; i--) {
+        PyObject *cell = (PyObject *)cons_take(state, &chain);
+        SET_CAR(cell, items[i]);
+        SET_CDR(cell, result);
+        SET_LENGTH(cell, cons_length_with_tail(state, result));
+        cons_track(state, cell);
+        result = cell;
+    }
+    return result;
+}
+
+/* Start a chunk with room for capacity items. It's untracked until cons_from_chunk
+   makes it part of a list, so it can be resized while it's filled in. */
+static ChunkObject *
+chunk_new(consmodule_state *state, Py_ssize_t capacity)
+{
+    ChunkObject *chunk =
+        PyObject_GC_NewVar(ChunkObject, (PyTypeObject *)state->ChunkType, capacity);
+    if (chunk != NULL)
+        Py_SET_SIZE(chunk, 0);
+    return chunk;
+}
+
+/* Add item to a chunk with room for it, stealing the reference */
+static inline void
+chunk_push(ChunkObject *chunk, PyObject *item)
+{
+    chunk->items[Py_SIZE(chunk)] = item;
+    Py_SET_SIZE(chunk, Py_SIZE(chunk) + 1);
+}
+
+/* Add item to a chunk with room for *capacity items, stealing the reference and growing
+   the chunk if it's full */
+static int
+chunk_append(ChunkObject **chunk, Py_ssize_t *capacity, PyObject *item)
+{
+    Py_ssize_t n = Py_SIZE(*chunk);
+    if (n == *capacity) {
+        Py_ssize_t new_capacity = n + (n >> 1) + 16;
+        ChunkObject *grown = NULL;
+        if (new_capacity > PY_SSIZE_T_MAX / (Py_ssize_t)sizeof(PyObject *))
+            PyErr_NoMemory();
+        else
+            grown = PyObject_GC_Resize(ChunkObject, *chunk, new_capacity);
+        if (grown == NULL) {
+            Py_DECREF(item);
+            return -1;
         }
+        Py_SET_SIZE(grown, n);
+        *chunk = grown;
+        *capacity = new_capacity;
+    }
+    chunk_push(*chunk, item);
+    return 0;
+}
+
+/* Make a list of the items filled in to a chunk, stealing the reference to it. Lists
+   too short to be worth a chunk are built from cells. */
+static PyObject *
+cons_from_chunk(consmodule_state *state, ChunkObject *chunk)
+{
+    Py_ssize_t n = Py_SIZE(chunk);
+    if (n < CONS_CHUNK_MIN) {
+        /* The cells take over the chunk's references to its items */
+        Py_SET_SIZE(chunk, 0);
+        PyObject *result = cons_from_spine(state, chunk->items, n, Py_NewRef(state->nil));
+        Py_DECREF(chunk);
+        return result;
+    }
+
+    /* Give back the room a builder didn't need */
+    ChunkObject *fitted = PyObject_GC_Resize(ChunkObject, chunk, n);
+    if (fitted == NULL) {
+        Py_DECREF(chunk);
+        return NULL;
+    }
+    PyObject *cell = Cons_NEW_PY(state);
+    if (cell == NULL) {
+        Py_DECREF(fitted);
+        return NULL;
+    }
+    SET_CAR(cell, Py_NewRef(fitted->items[0]));
+    SET_CDR(cell, (PyObject *)fitted);
+    SET_LENGTH(cell, n);
+    /* Like a cell, a chunk of atoms is left untracked, and so are the cells made from it */
+    for (Py_ssize_t i = 0; i < n; i++) {
+        if (!cons_is_atom(state, fitted->items[i])) {
+            PyObject_GC_Track(fitted);
+            break;
+        }
+    }
+    cons_track(state, cell);
+    STAT_INC(state, chunked_lists);
+    return cell;
+}
 
-        /* car and cdr returned from recursive lift calls, so refcount already set */
-        SET_CAR(pair, car);
-        SET_CDR(pair, cdr);
-        SET_IS_LIST(pair, false);
-        PyObject_GC_Track(pair);
+static PyObject *
+cons_from_fast_locked(PyObject *xs, consmodule_state *state, cmapfn_t f)
+{
+    Py_ssize_t len = PySequence_Fast_GET_SIZE(xs);
+    if (len < CONS_CHUNK_MIN) {
+        /* Short lists are built from cells anyway, so skip the chunk */
+        PyObject *items[CONS_CHUNK_MIN];
+        for (Py_ssize_t i = 0; i < len; i++) {
+            if ((items[i] = f(PySequence_Fast_GET_ITEM(xs, i), state)) == NULL) {
+                while (--i >= 0)
+                    Py_DECREF(items[i]);
+                return NULL;
+            }
+        }
+        return cons_from_spine(state, items, len, Py_NewRef(state->nil));
+    }
 
-        tmp = Cons_NEW_PY(cons_type);
-        if (tmp == NULL) {
-            Py_DECREF(pair);
-            Py_XDECREF(head);
+    ChunkObject *chunk = chunk_new(state, len);
+    if (chunk == NULL)
+        return NULL;
+    for (Py_ssize_t i = 0; i < len; i++) {
+        PyObject *item = f(PySequence_Fast_GET_ITEM(xs, i), state);
+        if (item == NULL) {
+            Py_DECREF(chunk);
             return NULL;
         }
-        SET_CAR(tmp, pair);
-        SET_IS_LIST(tmp, true);
+        chunk_push(chunk, item);
+    }
+    return cons_from_chunk(state, chunk);
+}
 
-        if (head == NULL)
-            head = current = tmp;
-        else {
-            SET_CDR(current, tmp);
-            PyObject_GC_Track(current);
-            current = tmp;
+/* Build a list from a list or tuple. In free-threaded builds the list is locked while its
+   items are read, as PySequence_Fast callers in CPython do. */
+PyObject *
+Cons_from_fast_with(PyObject *xs, consmodule_state *state, cmapfn_t f)
+{
+    PyObject *result;
+    Py_BEGIN_CRITICAL_SECTION(xs);
+    result = cons_from_fast_locked(xs, state, f);
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+/* Build a list from an iterator front to back. 'hint' is the expected number of items,
+   used to size the chunk they're collected in. */
+PyObject *
+Cons_from_iter_with(PyObject *it, consmodule_state *state, cmapfn_t f, Py_ssize_t hint)
+{
+    Py_ssize_t capacity = Py_MAX(hint, CONS_CHUNK_MIN);
+    ChunkObject *chunk = chunk_new(state, capacity);
+    if (chunk == NULL)
+        return NULL;
+
+    PyObject *item = NULL;
+    while ((item = PyIter_Next(it)) != NULL) {
+        PyObject *_item = f(item, state);
+        Py_DECREF(item);
+        if (_item == NULL || chunk_append(&chunk, &capacity, _item) < 0) {
+            Py_DECREF(chunk);
+            return NULL;
         }
     }
 
-    /* If PyDict_Next failed on the first iteration, current will be NULL */
-    if (current == NULL)
+    if (PyErr_Occurred()) {
+        Py_DECREF(chunk);
         return NULL;
+    }
+    return cons_from_chunk(state, chunk);
+}
+
+/* Get the start, step and length of a range. Returns 1 if its items all fit in a
+   Py_ssize_t, 0 if they don't, or -1 on error. */
+static int
+range_bounds(PyObject *range, Py_ssize_t *start, Py_ssize_t *step, Py_ssize_t *len)
+{
+    static const char *const names[] = {"start", "stop", "step"};
+    Py_ssize_t values[3];
+    for (size_t i = 0; i < Py_ARRAY_LENGTH(names); i++) {
+        PyObject *value = PyObject_GetAttrString(range, names[i]);
+        if (value == NULL)
+            return -1;
+        int overflow;
+        long long v = PyLong_AsLongLongAndOverflow(value, &overflow);
+        Py_DECREF(value);
+        if (v == -1 && PyErr_Occurred())
+            return -1;
+        else if (overflow || v < PY_SSIZE_T_MIN || v > PY_SSIZE_T_MAX)
+            return 0;
+        values[i] = (Py_ssize_t)v;
+    }
 
-    Py_IncRef(nil);
-    SET_CDR(current, nil);
-    PyObject_GC_Track(current);
-    return head;
+    /* Every item lies between start and stop, so fits if they do */
+    *start = values[0];
+    *step = values[2];
+    *len = PyObject_Size(range);
+    return *len < 0 ? -1 : 1;
 }
 
+/* Build a list of the items of a range, without going through its iterator */
 static PyObject *
-lift(PyObject *op, PyObject *cons_type, PyObject *nil)
+Cons_from_range(consmodule_state *state, Py_ssize_t start, Py_ssize_t step, Py_ssize_t len)
 {
-    if (PyDict_Check(op))
-        return lift_dict(op, cons_type, nil);
-    else if (PyGen_Check(op))
-        return Cons_from_gen_with(op, cons_type, nil, &lift);
-    else if (PyList_Check(op) || PyTuple_Check(op))
-        return Cons_from_fast_with(op, cons_type, nil, &lift);
-    else {
-        Py_INCREF(op);
-        return op;
+    ChunkObject *chunk = chunk_new(state, len);
+    if (chunk == NULL)
+        return NULL;
+    for (Py_ssize_t i = 0; i < len; i++) {
+        /* i * step may overflow even though the sum doesn't, so wrap around */
+        Py_ssize_t value = (Py_ssize_t)((size_t)start + (size_t)i * (size_t)step);
+        PyObject *item = PyLong_FromSsize_t(value);
+        if (item == NULL) {
+            Py_DECREF(chunk);
+            return NULL;
+        }
+        chunk_push(chunk, item);
     }
+    return cons_from_chunk(state, chunk);
 }
 
-PyObject *
-Cons_lift(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
-          Py_ssize_t nargs, PyObject *kwnames)
+// (const char *)p -> (PyObject *)x, a new reference to the item stored at p
+typedef PyObject *(*unpackfn_t)(const char *);
+
+#define DEFINE_UNPACK(name, type, convert)                                                 \
+    static PyObject *name(const char *p)                                                   \
+    {                                                                                      \
+        type x;                                                                            \
+        memcpy(&x, p, sizeof(x));                                                          \
+        return convert(x);                                                                 \
+    }
+
+DEFINE_UNPACK(unpack_b, signed char, PyLong_FromLong)
+DEFINE_UNPACK(unpack_B, unsigned char, PyLong_FromLong)
+DEFINE_UNPACK(unpack_h, short, PyLong_FromLong)
+DEFINE_UNPACK(unpack_H, unsigned short, PyLong_FromLong)
+DEFINE_UNPACK(unpack_i, int, PyLong_FromLong)
+DEFINE_UNPACK(unpack_I, unsigned int, PyLong_FromUnsignedLong)
+DEFINE_UNPACK(unpack_l, long, PyLong_FromLong)
+DEFINE_UNPACK(unpack_L, unsigned long, PyLong_FromUnsignedLong)
+DEFINE_UNPACK(unpack_q, long long, PyLong_FromLongLong)
+DEFINE_UNPACK(unpack_Q, unsigned long long, PyLong_FromUnsignedLongLong)
+DEFINE_UNPACK(unpack_n, Py_ssize_t, PyLong_FromSsize_t)
+DEFINE_UNPACK(unpack_N, size_t, PyLong_FromSize_t)
+DEFINE_UNPACK(unpack_f, float, PyFloat_FromDouble)
+DEFINE_UNPACK(unpack_d, double, PyFloat_FromDouble)
+DEFINE_UNPACK(unpack_bool, _Bool, PyBool_FromLong)
+
+#undef DEFINE_UNPACK
+
+static PyObject *
+unpack_c(const char *p)
 {
-    if (nargs != 1) {
-        PyErr_SetString(PyExc_TypeError, "cons.lift takes exactly one argument");
+    return PyBytes_FromStringAndSize(p, 1);
+}
+
+/* The function converting items of a buffer with the given struct format to the
+   objects its exporter's iterator would produce, or NULL if the format isn't a single
+   native-sized item we know how to read */
+static unpackfn_t
+buffer_unpacker(const char *format, Py_ssize_t itemsize)
+{
+    if (format == NULL)
+        format = "B";
+    else if (format[0] == '@')
+        format++;
+    if (format[0] == '\0' || format[1] != '\0')
+        return NULL;
+
+#define UNPACK_CASE(code, type, fn)                                                       \
+    case code:                                                                             \
+        return itemsize == sizeof(type) ? fn : NULL;
+
+    switch (format[0]) {
+        UNPACK_CASE('b', signed char, unpack_b)
+        UNPACK_CASE('B', unsigned char, unpack_B)
+        UNPACK_CASE('c', char, unpack_c)
+        UNPACK_CASE('h', short, unpack_h)
+        UNPACK_CASE('H', unsigned short, unpack_H)
+        UNPACK_CASE('i', int, unpack_i)
+        UNPACK_CASE('I', unsigned int, unpack_I)
+        UNPACK_CASE('l', long, unpack_l)
+        UNPACK_CASE('L', unsigned long, unpack_L)
+        UNPACK_CASE('q', long long, unpack_q)
+        UNPACK_CASE('Q', unsigned long long, unpack_Q)
+        UNPACK_CASE('n', Py_ssize_t, unpack_n)
+        UNPACK_CASE('N', size_t, unpack_N)
+        UNPACK_CASE('f', float, unpack_f)
+        UNPACK_CASE('d', double, unpack_d)
+        UNPACK_CASE('?', _Bool, unpack_bool)
+    default:
         return NULL;
     }
 
-    consmodule_state *state = PyType_GetModuleState(defining_class);
-    if (state == NULL)
+#undef UNPACK_CASE
+}
+
+/* Build a list of the items of a one-dimensional buffer, reading its memory directly.
+   Returns NULL without an exception set if the buffer's layout or format isn't
+   supported, so the caller can fall back to iterating over xs. */
+static PyObject *
+Cons_from_buffer(PyObject *xs, consmodule_state *state)
+{
+    Py_buffer view;
+    if (PyObject_GetBuffer(xs, &view, PyBUF_RECORDS_RO) < 0) {
+        PyErr_Clear();
         return NULL;
+    }
 
-    PyObject *op = args[0];
-    return lift(op, state->ConsType, state->nil);
+    unpackfn_t unpack = buffer_unpacker(view.format, view.itemsize);
+    if (unpack == NULL || view.ndim != 1) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    Py_ssize_t len = view.shape[0];
+    Py_ssize_t stride = view.strides[0];
+    ChunkObject *chunk = chunk_new(state, len);
+    if (chunk == NULL) {
+        PyBuffer_Release(&view);
+        return NULL;
+    }
+
+    for (Py_ssize_t i = 0; i < len; i++) {
+        PyObject *item = unpack((const char *)view.buf + i * stride);
+        if (item == NULL) {
+            Py_CLEAR(chunk);
+            break;
+        }
+        chunk_push(chunk, item);
+    }
+
+    PyBuffer_Release(&view);
+    return chunk == NULL ? NULL : cons_from_chunk(state, chunk);
 }
 
-Py_ssize_t
-cons_len(PyObject *op, PyObject *nil)
+/* Exporters whose iterators produce the same items as reading their buffer does */
+static inline bool
+is_known_buffer(consmodule_state *state, PyObject *xs)
 {
-    Py_ssize_t len = 0;
-    for (PyObject *pair = op; !Py_Is(pair, nil); len++, pair = CDR(pair))
-        ;
-    return len;
+    return PyBytes_CheckExact(xs) || PyByteArray_CheckExact(xs) || PyMemoryView_Check(xs) ||
+           Py_IS_TYPE(xs, (PyTypeObject *)state->ArrayType);
 }
 
 PyObject *
-Cons_to_list(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
+Cons_from_xs(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
              Py_ssize_t nargs, PyObject *kwnames)
 {
-    if (nargs != 0) {
-        PyErr_SetString(PyExc_TypeError, "expected zero arguments");
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "cons.from_xs takes exactly one argument");
         return NULL;
     }
-    else if (!IS_LIST(self)) {
-        PyErr_SetString(PyExc_ValueError, "expected proper cons list");
+
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+
+    PyObject *xs = args[0], *result = NULL;
+    if (PyList_Check(xs) || PyTuple_Check(xs))
+        return Cons_from_fast_with(xs, state, &identity);
+    else if (PyRange_Check(xs)) {
+        Py_ssize_t start, step, len;
+        int fits = range_bounds(xs, &start, &step, &len);
+        if (fits < 0)
+            return NULL;
+        else if (fits)
+            return Cons_from_range(state, start, step, len);
+    }
+    else if (is_known_buffer(state, xs)) {
+        if ((result = Cons_from_buffer(xs, state)) != NULL || PyErr_Occurred())
+            return result;
+    }
+    else if (Py_TYPE(xs)->tp_iter == NULL && !PySequence_Check(xs)) {
+        PyErr_SetString(PyExc_TypeError, "Expected a sequence or iterable");
+        return NULL;
+    }
+
+    /* Anything else is walked forwards, so it needn't be copied into a list first */
+    Py_ssize_t hint = PyObject_LengthHint(xs, 0);
+    if (hint < 0)
+        return NULL;
+    PyObject *it = PyObject_GetIter(xs);
+    if (it == NULL)
+        return NULL;
+    result = Cons_from_iter_with(it, state, &identity, hint);
+    Py_DECREF(it);
+    return result;
+}
+
+PyObject *
+Cons_stream(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
+            Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 1 || kwnames != NULL) {
+        PyErr_SetString(PyExc_TypeError, "cons.stream takes exactly one argument");
         return NULL;
     }
+
     consmodule_state *state = PyType_GetModuleState(defining_class);
     if (state == NULL)
         return NULL;
 
-    Py_ssize_t len = cons_len(self, state->nil);
-    PyObject *list = PyList_New(len);
-    PyObject *next = self, *head = NULL;
-    for (Py_ssize_t i = 0; i < len; i++, next = CDR(next)) {
-        head = CAR(next);
-        Py_INCREF(head);  // PyList_SET_ITEM steals a reference
-        PyList_SET_ITEM(list, i, head);
+    PyObject *it = PyObject_GetIter(args[0]);
+    if (it == NULL)
+        return NULL;
+    PyObject *first = PyIter_Next(it);
+    if (first == NULL) {
+        Py_DECREF(it);
+        return PyErr_Occurred() ? NULL : Py_NewRef(state->nil);
     }
-    return list;
+
+    ThunkObject *thunk = PyObject_GC_New(ThunkObject, (PyTypeObject *)state->ThunkType);
+    if (thunk == NULL) {
+        Py_DECREF(it);
+        Py_DECREF(first);
+        return NULL;
+    }
+    thunk->it = it;
+    thunk->forcing = false;
+    PyObject_GC_Track(thunk);
+
+    PyObject *cell = Cons_NEW_PY(state);
+    if (cell == NULL) {
+        Py_DECREF(thunk);
+        Py_DECREF(first);
+        return NULL;
+    }
+    SET_CAR(cell, first);
+    SET_CDR(cell, (PyObject *)thunk);
+    SET_LENGTH(cell, -1);
+    PyObject_GC_Track(cell);
+    return cell;
 }
 
-PyObject *
-Cons_repr(PyObject *self)
+static PyObject *
+lift(PyObject *, consmodule_state *, bool);
+
+static PyObject *
+lower(PyObject *, consmodule_state *, bool, bool);
+
+static int
+parse_kwargs(PyObject *const *, Py_ssize_t, PyObject *, const char *, const char *const *,
+             PyObject **);
+
+PyObject *
+Cons_lift(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
+          Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "cons.lift takes exactly one positional argument");
+        return NULL;
+    }
+
+    static const char *const kwlist[] = {"hamt", NULL};
+    PyObject *kwvalues[] = {NULL};
+    if (parse_kwargs(args, nargs, kwnames, "lift", kwlist, kwvalues) < 0)
+        return NULL;
+    int use_hamt = kwvalues[0] == NULL ? 0 : PyObject_IsTrue(kwvalues[0]);
+    if (use_hamt < 0)
+        return NULL;
+
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+
+    PyObject *op = args[0];
+    return lift(op, state, use_hamt);
+}
+
+PyObject *
+Cons_lower(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
+           Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "cons.lower takes exactly one positional argument");
+        return NULL;
+    }
+
+    static const char *const kwlist[] = {"tuples", "alists", NULL};
+    PyObject *kwvalues[] = {NULL, NULL};
+    if (parse_kwargs(args, nargs, kwnames, "lower", kwlist, kwvalues) < 0)
+        return NULL;
+    int tuples = kwvalues[0] == NULL ? 0 : PyObject_IsTrue(kwvalues[0]);
+    int alists = kwvalues[1] == NULL ? 0 : PyObject_IsTrue(kwvalues[1]);
+    if (tuples < 0 || alists < 0)
+        return NULL;
+
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+
+    return lower(args[0], state, tuples, alists);
+}
+
+PyObject *
+Cons_to_list(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
+             Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 0) {
+        PyErr_SetString(PyExc_TypeError, "expected zero arguments");
+        return NULL;
+    }
+    else if (IS_STREAM(self))
+        return PySequence_List(self);
+    else if (!IS_LIST(self)) {
+        PyErr_SetString(PyExc_ValueError, "expected proper cons list");
+        return NULL;
+    }
+
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+    Py_ssize_t len = LENGTH(self);
+    PyObject *list = PyList_New(len);
+    if (list == NULL)
+        return NULL;
+    conswalk walk = CONSWALK_INIT(self);
+    PyObject *head = NULL;
+    for (Py_ssize_t i = 0; i < len && conswalk_next(state, &walk, &head) > 0; i++) {
+        Py_INCREF(head);  // PyList_SET_ITEM steals a reference
+        PyList_SET_ITEM(list, i, head);
+    }
+    conswalk_fini(&walk);
+    return list;
+}
+
+/* Pickle a cell as its spine's items and terminating tail, so pickling a long list
+   doesn't recurse once per cell. The spine stops early at a tail that is referenced
+   from elsewhere too, which is pickled on its own so that the pickle memo keeps it
+   shared. */
+static PyObject *
+Cons_reduce(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
+            Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 0) {
+        PyErr_SetString(PyExc_TypeError, "expected zero arguments");
+        return NULL;
+    }
+
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+
+    /* Find the end of the spine, forcing streams on the way. A chunk's items have no
+       cells for anything else to refer to, so the spine takes all of them. */
+    Py_ssize_t n = 1;
+    PyObject *tail;
+    for (PyObject *cell = self;; cell = tail, n++) {
+        if (IS_CHUNKED(cell)) {
+            n += LENGTH(cell) - 1;
+            tail = state->nil;
+            break;
+        }
+        else if ((tail = cons_tail(cell)) == NULL)
+            return NULL;
+        else if (!Py_IS_TYPE(tail, defining_class) || Py_REFCNT(tail) > 1)
+            break;
+    }
+
+    PyObject *module = PyType_GetModule(defining_class);
+    if (module == NULL)
+        return NULL;
+    PyObject *from_spine = PyObject_GetAttrString(module, "_from_spine");
+    if (from_spine == NULL)
+        return NULL;
+    PyObject *spine = PyTuple_New(n);
+    if (spine == NULL) {
+        Py_DECREF(from_spine);
+        return NULL;
+    }
+    conswalk walk = CONSWALK_INIT(self);
+    PyObject *item;
+    for (Py_ssize_t i = 0; i < n && conswalk_next(state, &walk, &item) > 0; i++)
+        PyTuple_SET_ITEM(spine, i, Py_NewRef(item));
+    conswalk_fini(&walk);
+    return Py_BuildValue("N(NO)", from_spine, spine, tail);
+}
+
+/* Iteration over proper lists - see tupleobject.c, PyTupleIter_Type */
+typedef struct {
+    PyObject_HEAD
+    /* The cell holding the next item, or NULL when exhausted or reading a chunk */
+    PyObject *cell;
+    /* Once a chunked cell is reached, the chunk the rest of the items are read from */
+    ChunkObject *chunk;
+    Py_ssize_t index;
+    /* Streams only: cell's item has already been returned. A stream's tail is only
+       forced when the item after it is asked for. */
+    bool advance;
+} ConsIterObject;
+
+static PyObject *
+ConsIter_new(consmodule_state *state, PyObject *cell)
+{
+    ConsIterObject *it = PyObject_GC_New(ConsIterObject, (PyTypeObject *)state->ConsIterType);
+    if (it == NULL)
+        return NULL;
+    it->cell = Py_XNewRef(cell);
+    it->chunk = NULL;
+    it->index = 0;
+    it->advance = false;
+    PyObject_GC_Track(it);
+    return (PyObject *)it;
+}
+
+static int
+ConsIter_traverse(ConsIterObject *it, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(it));
+    Py_VISIT(it->cell);
+    Py_VISIT(it->chunk);
+    return 0;
+}
+
+static void
+ConsIter_dealloc(ConsIterObject *it)
+{
+    PyTypeObject *tp = Py_TYPE(it);
+    PyObject_GC_UnTrack(it);
+    Py_XDECREF(it->cell);
+    Py_XDECREF(it->chunk);
+    PyObject_GC_Del(it);
+    Py_DECREF(tp);
+}
+
+static PyObject *
+ConsIter_next(ConsIterObject *it)
+{
+    if (it->chunk != NULL) {
+        if (it->index < Py_SIZE(it->chunk))
+            return Py_NewRef(it->chunk->items[it->index++]);
+        Py_CLEAR(it->chunk);
+        return NULL;
+    }
+
+    PyObject *cell = it->cell;
+    if (cell == NULL)
+        return NULL;
+    else if (IS_STREAM(cell)) {
+        if (it->advance) {
+            PyObject *tail = cons_tail(cell);
+            if (tail == NULL)
+                return NULL;
+            it->cell = Py_IS_TYPE(tail, Py_TYPE(cell)) ? Py_NewRef(tail) : NULL;
+            Py_DECREF(cell);
+            if ((cell = it->cell) == NULL)
+                return NULL;
+        }
+        it->advance = true;
+        return Py_NewRef(CAR(cell));
+    }
+
+    PyObject *item = Py_NewRef(CAR(cell));
+    if ((it->chunk = cons_chunk_ref(cell, &it->index)) != NULL) {
+        /* Read the rest of the items straight from the chunk, without making cells */
+        it->cell = NULL;
+        Py_DECREF(cell);
+        return item;
+    }
+    /* The list is proper, so the spine is cons cells up to the terminating nil */
+    PyObject *tail = LOAD_TAIL(cell);
+    it->cell = Py_IS_TYPE(tail, Py_TYPE(cell)) ? Py_NewRef(tail) : NULL;
+    Py_DECREF(cell);
+    return item;
+}
+
+static PyObject *
+ConsIter_length_hint(ConsIterObject *it, PyObject *Py_UNUSED(ignored))
+{
+    if (it->chunk != NULL)
+        return PyLong_FromSsize_t(Py_SIZE(it->chunk) - it->index);
+    return PyLong_FromSsize_t(it->cell == NULL ? 0 : Py_MAX(LENGTH(it->cell), 0));
+}
+
+PyDoc_STRVAR(length_hint_doc, "Private method returning an estimate of len(list(it)).");
+
+static PyMethodDef ConsIter_methods[] = {
+    {"__length_hint__", (PyCFunction)ConsIter_length_hint, METH_NOARGS, length_hint_doc},
+    {NULL, NULL},
+};
+
+static PyType_Slot ConsIter_Type_Slots[] = {
+    {Py_tp_dealloc, ConsIter_dealloc},
+    {Py_tp_traverse, ConsIter_traverse},
+    {Py_tp_iter, PyObject_SelfIter},
+    {Py_tp_iternext, ConsIter_next},
+    {Py_tp_methods, ConsIter_methods},
+    {0, NULL},
+};
+
+static PyType_Spec ConsIter_Type_Spec = {
+    .name = "fastcons.cons_iterator",
+    .basicsize = sizeof(ConsIterObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = ConsIter_Type_Slots,
+};
+
+static PyObject *
+Cons_iter(PyObject *self)
+{
+    if (!IS_LIST(self) && !IS_STREAM(self)) {
+        PyErr_SetString(PyExc_TypeError, "improper cons list is not iterable");
+        return NULL;
+    }
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    return ConsIter_new(state, self);
+}
+
+/* Repr writing
+
+   repr() and write_repr() share one writer, which walks nested lists with an explicit
+   stack rather than calling repr() on each head, and formats common atoms inline. Cells
+   can't form cycles on their own, so only the outermost list needs Py_ReprEnter; cycles
+   through mutable containers are caught by the containers' own reprs. */
+
+/* write_repr() hands its text to the file in pieces of about this many characters */
+#ifndef CONS_REPR_CHUNK
+#define CONS_REPR_CHUNK 65536
+#endif
+
+typedef struct {
+    _PyUnicodeWriter writer;
+    /* The file's write method for write_repr(), or NULL to collect the text for repr() */
+    PyObject *write;
+    /* Whether the file takes UTF-8 bytes rather than str, or -1 before the first write */
+    int binary;
+} reprsink;
+
+/* A list being written: the next cell whose head to show, or the rest of a chunk */
+typedef struct {
+    PyObject *cell;
+    ChunkObject *chunk;
+    Py_ssize_t index;
+    /* An improper list's final tail, shown after " . " */
+    PyObject *last;
+    /* Whether the list ends in a stream's unforced tail, shown as " ..." */
+    bool unforced;
+    bool first;
+} reprframe;
+
+#define REPR_STACK_INLINE 16
+
+static void
+reprsink_init(reprsink *sink, PyObject *write, int binary)
+{
+    _PyUnicodeWriter_Init(&sink->writer);
+    sink->writer.overallocate = 1;
+    sink->write = write;
+    sink->binary = binary;
+}
+
+/* Hand the text written so far to the file. A file whose first write refuses str with
+   a TypeError is given UTF-8 bytes from then on. */
+static int
+reprsink_flush(reprsink *sink)
+{
+    if (sink->writer.pos == 0)
+        return 0;
+    PyObject *text = _PyUnicodeWriter_Finish(&sink->writer);
+    reprsink_init(sink, sink->write, sink->binary);
+    if (text == NULL)
+        return -1;
+    PyObject *result = NULL, *refused = NULL;
+    if (sink->binary <= 0) {
+        result = PyObject_CallOneArg(sink->write, text);
+        if (result != NULL)
+            sink->binary = 0;
+        else if (sink->binary < 0 && PyErr_ExceptionMatches(PyExc_TypeError)) {
+            refused = PyErr_GetRaisedException();
+            sink->binary = 1;
+        }
+    }
+    if (sink->binary > 0) {
+        PyObject *data = PyUnicode_AsUTF8String(text);
+        if (data != NULL) {
+            result = PyObject_CallOneArg(sink->write, data);
+            Py_DECREF(data);
+        }
+        /* If bytes are refused too, report the error from writing str */
+        if (result == NULL && refused != NULL && PyErr_ExceptionMatches(PyExc_TypeError)) {
+            PyErr_SetRaisedException(refused);
+            refused = NULL;
+        }
+        Py_XDECREF(refused);
+    }
+    Py_DECREF(text);
+    if (result == NULL)
+        return -1;
+    Py_DECREF(result);
+    return 0;
+}
+
+/* Whether a str's repr is the str itself in single quotes: it's printable ASCII with no
+   quotes or backslashes to escape */
+static bool
+str_repr_is_quoted(PyObject *op)
+{
+    if (!PyUnicode_IS_ASCII(op))
+        return false;
+    const Py_UCS1 *data = PyUnicode_1BYTE_DATA(op);
+    for (Py_ssize_t i = 0, n = PyUnicode_GET_LENGTH(op); i < n; i++) {
+        if (data[i] < ' ' || data[i] >= 0x7f || data[i] == '\'' || data[i] == '\\')
+            return false;
+    }
+    return true;
+}
+
+/* Write the repr of anything but a cell, formatting nil, small ints, floats, plain
+   strings, bools and None without calling repr() */
+static int
+reprsink_write_atom(consmodule_state *state, reprsink *sink, PyObject *op)
+{
+    _PyUnicodeWriter *writer = &sink->writer;
+    if (Py_Is(op, state->nil))
+        return _PyUnicodeWriter_WriteASCIIString(writer, "nil()", 5);
+    else if (PyLong_CheckExact(op)) {
+        int overflow;
+        long long value = PyLong_AsLongLongAndOverflow(op, &overflow);
+        if (!overflow) {
+            char buf[24], *end = buf + sizeof(buf), *p = end;
+            unsigned long long digits =
+                value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+            do {
+                *--p = (char)('0' + digits % 10);
+                digits /= 10;
+            } while (digits != 0);
+            if (value < 0)
+                *--p = '-';
+            return _PyUnicodeWriter_WriteASCIIString(writer, p, end - p);
+        }
+    }
+    else if (PyFloat_CheckExact(op)) {
+        /* As float.__repr__ does */
+        char *buf = PyOS_double_to_string(PyFloat_AS_DOUBLE(op), 'r', 0,
+                                          Py_DTSF_ADD_DOT_0, NULL);
+        if (buf == NULL)
+            return -1;
+        int err = _PyUnicodeWriter_WriteASCIIString(writer, buf, (Py_ssize_t)strlen(buf));
+        PyMem_Free(buf);
+        return err;
+    }
+    else if (PyUnicode_CheckExact(op) && str_repr_is_quoted(op)) {
+        if (_PyUnicodeWriter_WriteChar(writer, '\'') < 0 ||
+            _PyUnicodeWriter_WriteStr(writer, op) < 0)
+            return -1;
+        return _PyUnicodeWriter_WriteChar(writer, '\'');
+    }
+    else if (Py_IsNone(op))
+        return _PyUnicodeWriter_WriteASCIIString(writer, "None", 4);
+    else if (Py_IsTrue(op))
+        return _PyUnicodeWriter_WriteASCIIString(writer, "True", 4);
+    else if (Py_IsFalse(op))
+        return _PyUnicodeWriter_WriteASCIIString(writer, "False", 5);
+
+    PyObject *repr = PyObject_Repr(op);
+    if (repr == NULL)
+        return -1;
+    int err = _PyUnicodeWriter_WriteStr(writer, repr);
+    Py_DECREF(repr);
+    return err;
+}
+
+/* Move a frame past the head of its current cell */
+static void
+reprframe_advance(consmodule_state *state, reprframe *frame)
+{
+    PyObject *cell = frame->cell;
+    frame->cell = NULL;
+    if ((frame->chunk = cons_chunk_ref(cell, &frame->index)) != NULL)
+        return;
+    PyObject *tail = LOAD_TAIL(cell);
+    if (Py_IS_TYPE(tail, (PyTypeObject *)state->ConsType))
+        frame->cell = tail;
+    else if (Py_IS_TYPE(tail, (PyTypeObject *)state->ThunkType))
+        /* Showing a stream doesn't force it */
+        frame->unforced = true;
+    else if (!Py_Is(tail, state->nil))
+        frame->last = tail;
+}
+
+/* Write the repr of obj. The cells being walked are kept alive by obj, as they're only
+   ever replaced in a cell by forcing, which keeps them; chunks are held on to, since
+   forcing drops them. */
+static int
+cons_write_repr(consmodule_state *state, reprsink *sink, PyObject *obj)
+{
+    if (!Py_IS_TYPE(obj, (PyTypeObject *)state->ConsType))
+        return reprsink_write_atom(state, sink, obj);
+
+    reprframe inline_stack[REPR_STACK_INLINE];
+    reprframe *stack = inline_stack;
+    Py_ssize_t depth = 0, capacity = REPR_STACK_INLINE;
+    int err = -1;
+
+    stack[depth++] = (reprframe){.cell = obj, .first = true};
+    if (_PyUnicodeWriter_WriteChar(&sink->writer, '(') < 0)
+        goto done;
+    while (depth > 0) {
+        reprframe *frame = &stack[depth - 1];
+        PyObject *item = NULL;
+        if (frame->chunk != NULL) {
+            if (frame->index < Py_SIZE(frame->chunk))
+                item = frame->chunk->items[frame->index++];
+            else
+                Py_CLEAR(frame->chunk);
+        }
+        else if (frame->cell != NULL) {
+            item = CAR(frame->cell);
+            reprframe_advance(state, frame);
+        }
+
+        if (item == NULL) {
+            /* The end of the list */
+            if (frame->unforced &&
+                _PyUnicodeWriter_WriteASCIIString(&sink->writer, " ...", 4) < 0)
+                goto done;
+            if (frame->last != NULL &&
+                (_PyUnicodeWriter_WriteASCIIString(&sink->writer, " . ", 3) < 0 ||
+                 reprsink_write_atom(state, sink, frame->last) < 0))
+                goto done;
+            if (_PyUnicodeWriter_WriteChar(&sink->writer, ')') < 0)
+                goto done;
+            depth--;
+            continue;
+        }
+
+        if (!frame->first && _PyUnicodeWriter_WriteChar(&sink->writer, ' ') < 0)
+            goto done;
+        frame->first = false;
+        if (Py_IS_TYPE(item, (PyTypeObject *)state->ConsType)) {
+            if (depth == capacity) {
+                Py_ssize_t size = capacity * 2;
+                reprframe *grown =
+                    stack == inline_stack
+                        ? PyMem_Malloc((size_t)size * sizeof(reprframe))
+                        : PyMem_Realloc(stack, (size_t)size * sizeof(reprframe));
+                if (grown == NULL) {
+                    PyErr_NoMemory();
+                    goto done;
+                }
+                if (stack == inline_stack)
+                    memcpy(grown, inline_stack, sizeof(inline_stack));
+                stack = grown;
+                capacity = size;
+            }
+            stack[depth++] = (reprframe){.cell = item, .first = true};
+            if (_PyUnicodeWriter_WriteChar(&sink->writer, '(') < 0)
+                goto done;
+        }
+        else if (reprsink_write_atom(state, sink, item) < 0)
+            goto done;
+
+        if (sink->write != NULL && sink->writer.pos >= CONS_REPR_CHUNK &&
+            reprsink_flush(sink) < 0)
+            goto done;
+    }
+    err = 0;
+
+done:
+    for (Py_ssize_t i = 0; i < depth; i++)
+        Py_XDECREF(stack[i].chunk);
+    if (stack != inline_stack)
+        PyMem_Free(stack);
+    return err;
+}
+
+PyObject *
+Cons_repr(PyObject *self)
+{
+    PyObject *m = PyType_GetModuleByDef(Py_TYPE(self), &consmodule);
+    if (m == NULL)
+        return NULL;
+    consmodule_state *state = PyModule_GetState(m);
+    if (state == NULL)
+        return NULL;
+
+    int i = Py_ReprEnter(self);
+    if (i != 0)
+        return i > 0 ? PyUnicode_FromString("...") : NULL;
+
+    reprsink sink;
+    reprsink_init(&sink, NULL, 0);
+    sink.writer.min_length = 3;  // "(_)"
+    if (cons_write_repr(state, &sink, self) < 0) {
+        _PyUnicodeWriter_Dealloc(&sink.writer);
+        Py_ReprLeave(self);
+        return NULL;
+    }
+    Py_ReprLeave(self);
+    return _PyUnicodeWriter_Finish(&sink.writer);
+}
+
+static Py_ssize_t
+Cons_length(PyObject *self)
+{
+    if (IS_STREAM(self)) {
+        Py_ssize_t n = 0;
+        for (PyObject *cell = self; Py_IS_TYPE(cell, Py_TYPE(self)); n++)
+            if ((cell = cons_tail(cell)) == NULL)
+                return -1;
+        return n;
+    }
+    else if (!IS_LIST(self)) {
+        PyErr_SetString(PyExc_TypeError, "improper cons list has no len()");
+        return -1;
+    }
+    return LENGTH(self);
+}
+
+/* Defined explicitly, as a cons is truthy even when it is improper and has no len() */
+static int
+Cons_bool(PyObject *self)
+{
+    return 1;
+}
+
+/* The walks over a pair of lists being compared */
+typedef struct {
+    conswalk this;
+    conswalk that;
+} richcompare_frame;
+
+/* Compare two conses lexicographically, like tuples: find the first pair of elements
+   that aren't equal, walking heads depth first and tails in order, and compare those
+   with op. Shared sub-structure is skipped by identity, and nested heads are walked with
+   an explicit stack of pending tail pairs rather than by recursion. Chunks are read
+   directly, without making their cells. */
+PyObject *
+Cons_richcompare(PyObject *self, PyObject *other, int op)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    STAT_INC(state, compare_calls);
+
+    PyObject *nil = state->nil;
+    PyTypeObject *cons = (PyTypeObject *)state->ConsType;
+    if (Py_Is(other, nil))
+        return richcompare_shorter(op, false);
+    else if (!Py_IS_TYPE(other, cons))
+        Py_RETURN_NOTIMPLEMENTED;
+
+    bool equality = op == Py_EQ || op == Py_NE;
+    PyObject *result = NULL;
+    richcompare_frame small[16];
+    richcompare_frame *pending = small;
+    Py_ssize_t npending = 0, capacity = Py_ARRAY_LENGTH(small);
+
+    conswalk this = CONSWALK_INIT(self), that = CONSWALK_INIT(other);
+    for (;;) {
+        /* cdr down both lists until they differ, or one of them ends */
+        for (;;) {
+            if (!conswalk_in_chunk(&this) && !conswalk_in_chunk(&that)) {
+                ConsObject *x = (ConsObject *)this.cell, *y = (ConsObject *)that.cell;
+                if (Py_Is(x, y))
+                    break;
+                /* Proper lists of different lengths, or with different hashes, can't be
+                   equal. The length of a stream isn't known. */
+                if (equality && Py_IS_TYPE(x, cons) && Py_IS_TYPE(y, cons) &&
+                    ((x->length != y->length && x->length >= 0 && y->length >= 0) ||
+                     hashes_differ(LOAD_SSIZE(x->hash), LOAD_SSIZE(y->hash)))) {
+                    result = Py_NewRef(op == Py_EQ ? Py_False : Py_True);
+                    goto done;
+                }
+            }
+
+            bool this_done = conswalk_done(state, &this);
+            bool that_done = conswalk_done(state, &that);
+            if (this_done && Py_Is(this.cell, nil) && !that_done) {
+                result = richcompare_shorter(op, true);
+                goto done;
+            }
+            else if (that_done && Py_Is(that.cell, nil) && !this_done) {
+                result = richcompare_shorter(op, false);
+                goto done;
+            }
+            else if (this_done || that_done) {
+                /* The terminating elements of improper lists */
+                PyObject *a = conswalk_rest(state, &this), *b = NULL;
+                int cmp = -1;
+                if (a != NULL && (b = conswalk_rest(state, &that)) != NULL &&
+                    (cmp = PyObject_RichCompareBool(a, b, Py_EQ)) == 0)
+                    result = PyObject_RichCompare(a, b, op);
+                Py_XDECREF(a);
+                Py_XDECREF(b);
+                if (cmp != 1)
+                    goto done;
+                break;
+            }
+
+            PyObject *a = NULL, *b = NULL;
+            int this_next = conswalk_next(state, &this, &a);
+            int that_next = this_next < 0 ? -1 : conswalk_next(state, &that, &b);
+            if (this_next < 0 || that_next < 0)
+                goto done;
+            else if (this_next == 0 || that_next == 0) {
+                /* Neither walk was done, so both must have had an item */
+                PyErr_SetString(PyExc_SystemError, "cons list ended during comparison");
+                goto done;
+            }
+            if (Py_IS_TYPE(a, cons) && Py_IS_TYPE(b, cons) && !Py_Is(a, b)) {
+                /* Compare the heads first, then carry on with the tails */
+                richcompare_frame *grown = framestack_reserve(pending, small, npending,
+                                                              &capacity, sizeof(*pending));
+                if (grown == NULL)
+                    goto done;
+                pending = grown;
+                pending[npending].this = this;
+                pending[npending++].that = that;
+                this = (conswalk)CONSWALK_INIT(a);
+                that = (conswalk)CONSWALK_INIT(b);
+                continue;
+            }
+
+            int cmp = PyObject_RichCompareBool(a, b, Py_EQ);
+            if (cmp < 0)
+                goto done;
+            else if (!cmp) {
+                if (equality)
+                    result = Py_NewRef(op == Py_EQ ? Py_False : Py_True);
+                else
+                    result = PyObject_RichCompare(a, b, op);
+                goto done;
+            }
+        }
+
+        conswalk_fini(&this);
+        conswalk_fini(&that);
+        if (npending == 0)
+            break;
+        npending--;
+        this = pending[npending].this;
+        that = pending[npending].that;
+    }
+
+    /* Everything compared equal */
+    result = Py_NewRef(op == Py_EQ || op == Py_LE || op == Py_GE ? Py_True : Py_False);
+
+done:
+    conswalk_fini(&this);
+    conswalk_fini(&that);
+    while (npending > 0) {
+        npending--;
+        conswalk_fini(&pending[npending].this);
+        conswalk_fini(&pending[npending].that);
+    }
+    if (pending != small)
+        PyMem_Free(pending);
+    return result;
+}
+
+/* Simplified xxHash - see https://github.com/Cyan4973/xxHash/blob/master/doc/xxhash_spec.md
+   and tupleobject.c
+*/
+#if SIZEOF_PY_UHASH_T > 4
+#define _PyHASH_XXPRIME_1 ((Py_uhash_t)11400714785074694791ULL)
+#define _PyHASH_XXPRIME_2 ((Py_uhash_t)14029467366897019727ULL)
+#define _PyHASH_XXPRIME_5 ((Py_uhash_t)2870177450012600261ULL)
+#define _PyHASH_XXROTATE(x) ((x << 31) | (x >> 33)) /* Rotate left 31 bits */
+#else
+#define _PyHASH_XXPRIME_1 ((Py_uhash_t)2654435761UL)
+#define _PyHASH_XXPRIME_2 ((Py_uhash_t)2246822519UL)
+#define _PyHASH_XXPRIME_5 ((Py_uhash_t)374761393UL)
+#define _PyHASH_XXROTATE(x) ((x << 13) | (x >> 19)) /* Rotate left 13 bits */
+#endif
+
+static inline Py_uhash_t
+cons_hash_combine(Py_uhash_t head_hash, Py_uhash_t tail_hash)
+{
+    Py_uhash_t lanes[2] = {head_hash, tail_hash};
+    Py_uhash_t acc = _PyHASH_XXPRIME_5;
+
+    for (size_t i = 0; i < 2; i++) {
+        acc += lanes[i] * _PyHASH_XXPRIME_2;
+        acc = _PyHASH_XXROTATE(acc);
+        acc *= _PyHASH_XXPRIME_1;
+    }
+    /* Adding the length complicates matters (do cons(1, 2) and cons(1, nil()) have the same
+       length wrt hashing?) so leave it - the xxHash spec allows length to be zero.
+    */
+    if (acc == (Py_uhash_t)-1)
+        return 1546275796;
+    return acc;
+}
+
+#if CONS_STATS
+/* The nesting depth of lists in heads that Cons_hash has reached on this thread, counting
+   the frames of calls it's nested in through other containers */
+static _Thread_local Py_ssize_t hash_depth;
+#endif
+
+/* A spine being hashed: the cells whose hash isn't known yet, which are entries from
+   base to end of the shared cell stack, and the chunk holding the rest of the spine, if
+   any. 'next' counts the heads already checked for nested lists, the cells' first and
+   then the chunk's. */
+typedef struct {
+    Py_ssize_t base;
+    Py_ssize_t end;
+    ChunkObject *chunk;
+    Py_ssize_t start;
+    /* The first cell with a cached hash after the uncached ones, or the terminating
+       object, when there is no chunk */
+    PyObject *last;
+    Py_ssize_t next;
+} hash_frame;
+
+#define HASH_STACK_INLINE 4
+
+/* The cells of the spines being hashed. Cons_hash can still recurse through other
+   containers holding lists, so it keeps its inline buffers small, leaving
+   Py_EnterRecursiveCall to stop deep nesting before the C stack runs out. */
+typedef struct {
+    PyObject **items;
+    Py_ssize_t size;
+    Py_ssize_t capacity;
+    PyObject *small[HASH_STACK_INLINE];
+} hash_cells;
+
+static int
+hash_cells_push(hash_cells *cells, PyObject *cell)
+{
+    PyObject **grown = framestack_reserve(cells->items, cells->small, cells->size,
+                                          &cells->capacity, sizeof(PyObject *));
+    if (grown == NULL)
+        return -1;
+    cells->items = grown;
+    cells->items[cells->size++] = cell;
+    return 0;
+}
+
+/* Collect the uncached cells of the spine starting at cell into a new frame */
+static int
+hash_frame_init(hash_frame *frame, hash_cells *cells, PyObject *cell)
+{
+    PyTypeObject *cons = Py_TYPE(cell);
+    frame->base = cells->size;
+    frame->chunk = NULL;
+    frame->start = 0;
+    frame->next = 0;
+    while (Py_IS_TYPE(cell, cons) && LOAD_SSIZE(((ConsObject *)cell)->hash) == -1) {
+        if (hash_cells_push(cells, cell) < 0)
+            return -1;
+        else if ((frame->chunk = cons_chunk_ref(cell, &frame->start)) != NULL)
+            break;
+        else if ((cell = cons_tail(cell)) == NULL)
+            return -1;
+    }
+    frame->end = cells->size;
+    frame->last = cell;
+    return 0;
+}
+
+/* The next head of the frame's spine that is a list whose hash isn't known yet, or NULL
+   once there are none left */
+static PyObject *
+hash_frame_nested(hash_frame *frame, hash_cells *cells, PyTypeObject *cons)
+{
+    Py_ssize_t ncells = frame->end - frame->base;
+    Py_ssize_t nitems = frame->chunk == NULL ? 0 : Py_SIZE(frame->chunk) - frame->start;
+    for (; frame->next < ncells + nitems; frame->next++) {
+        PyObject *head = frame->next < ncells
+                             ? CAR(cells->items[frame->base + frame->next])
+                             : frame->chunk->items[frame->start + frame->next - ncells];
+        if (Py_IS_TYPE(head, cons) && LOAD_SSIZE(((ConsObject *)head)->hash) == -1)
+            return head;
+    }
+    return NULL;
+}
+
+/* Hash the frame's spine from its end back to the front, caching each cell's hash. The
+   heads that are lists have all been hashed by now, so hashing them doesn't recurse. */
+static Py_hash_t
+hash_frame_finish(consmodule_state *state, hash_frame *frame, hash_cells *cells)
+{
+    PyTypeObject *cons = (PyTypeObject *)state->ConsType;
+    Py_hash_t tail_hash;
+    if (frame->chunk != NULL) {
+        ChunkObject *chunk = frame->chunk;
+        tail_hash = PyObject_Hash(state->nil);
+        for (Py_ssize_t i = Py_SIZE(chunk) - 1; tail_hash != -1 && i >= frame->start; i--) {
+            Py_hash_t head_hash = PyObject_Hash(chunk->items[i]);
+            tail_hash = head_hash == -1 ? -1
+                                        : (Py_hash_t)cons_hash_combine((Py_uhash_t)head_hash,
+                                                                       (Py_uhash_t)tail_hash);
+        }
+    }
+    else if (Py_IS_TYPE(frame->last, cons))
+        tail_hash = LOAD_SSIZE(((ConsObject *)frame->last)->hash);
+    else
+        tail_hash = PyObject_Hash(frame->last);
+
+    for (Py_ssize_t i = frame->end - 1; tail_hash != -1 && i >= frame->base; i--) {
+        ConsObject *op = (ConsObject *)cells->items[i];
+        Py_hash_t head_hash = PyObject_Hash(op->head);
+        if (head_hash == -1)
+            return -1;
+        tail_hash = (Py_hash_t)cons_hash_combine((Py_uhash_t)head_hash, (Py_uhash_t)tail_hash);
+        STORE_SSIZE(op->hash, tail_hash);
+    }
+    return tail_hash;
+}
+
+/* Cells are immutable, so a cell's hash is computed once and cached. Rather than
+   recursing through the tail, collect the cells whose hash isn't known yet, then hash
+   them from the end of the spine back to the front, caching each on the way. Heads that
+   are lists with no cached hash are hashed first, with a stack of frames in place of
+   recursion, so that hashing the spine finds their hashes cached.
+*/
+static Py_hash_t
+Cons_hash(ConsObject *self)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return -1;
+    STAT_INC(state, hash_calls);
+    Py_hash_t cached = LOAD_SSIZE(self->hash);
+    if (cached != -1)
+        return cached;
+    /* Lists can still be nested through other containers, such as tuples */
+    if (Py_EnterRecursiveCall(" while hashing a cons"))
+        return -1;
+#if CONS_STATS
+    Py_ssize_t outer_depth = hash_depth;
+#endif
+
+    hash_cells cells = {.size = 0, .capacity = HASH_STACK_INLINE};
+    cells.items = cells.small;
+    hash_frame small[HASH_STACK_INLINE], *frames = small;
+    Py_ssize_t depth = 0, capacity = HASH_STACK_INLINE;
+    Py_hash_t result = -1;
+
+    PyObject *next = (PyObject *)self;
+    while (next != NULL) {
+        hash_frame *grown =
+            framestack_reserve(frames, small, depth, &capacity, sizeof(hash_frame));
+        if (grown == NULL)
+            goto done;
+        frames = grown;
+        if (hash_frame_init(&frames[depth], &cells, next) < 0) {
+            Py_XDECREF(frames[depth].chunk);
+            goto done;
+        }
+        depth++;
+#if CONS_STATS
+        hash_depth = outer_depth + depth;
+        STAT_MAX(state, hash_max_depth, hash_depth);
+#endif
+        /* Hash the innermost frame whose nested heads are all hashed, and go back to the
+           frame it was nested in */
+        while ((next = hash_frame_nested(&frames[depth - 1], &cells, Py_TYPE(self))) ==
+               NULL) {
+            hash_frame *frame = &frames[depth - 1];
+            result = hash_frame_finish(state, frame, &cells);
+            cells.size = frame->base;
+            Py_CLEAR(frame->chunk);
+            depth--;
+            if (result == -1 || depth == 0)
+                goto done;
+        }
+    }
+
+done:
+    while (depth > 0)
+        Py_XDECREF(frames[--depth].chunk);
+    if (frames != small)
+        PyMem_Free(frames);
+    if (cells.items != cells.small)
+        PyMem_Free(cells.items);
+#if CONS_STATS
+    hash_depth = outer_depth;
+#endif
+    Py_LeaveRecursiveCall();
+    return result;
+}
+
+static PyMemberDef Cons_members[] = {
+    {"head", T_OBJECT_EX, offsetof(ConsObject, head), READONLY, "cons head"},
+    {NULL},
+};
+
+static PyObject *
+Cons_get_tail(PyObject *self, void *closure)
+{
+    return Py_XNewRef(cons_tail(self));
+}
+
+static PyGetSetDef Cons_getset[] = {
+    {"tail", Cons_get_tail, NULL, "cons tail", NULL},
+    {NULL},
+};
+
+/* List builders
+
+   cons.builder() collects items front to back in a chunk that only it can see, appending
+   in place, and hands them over as an ordinary list when built, as from_xs does. */
+typedef struct {
+    PyObject_HEAD
+    /* The items appended so far, or NULL if none */
+    ChunkObject *chunk;
+    Py_ssize_t capacity;
+} ConsBuilderObject;
+
+static int
+ConsBuilder_traverse(ConsBuilderObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(self));
+    /* The chunk is untracked while it's filled in, so visit its items for it */
+    if (self->chunk != NULL) {
+        for (Py_ssize_t i = Py_SIZE(self->chunk); --i >= 0;)
+            Py_VISIT(self->chunk->items[i]);
+    }
+    return 0;
+}
+
+static int
+ConsBuilder_clear(ConsBuilderObject *self)
+{
+    Py_CLEAR(self->chunk);
+    self->capacity = 0;
+    return 0;
+}
+
+static void
+ConsBuilder_dealloc(ConsBuilderObject *self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    ConsBuilder_clear(self);
+    PyObject_GC_Del(self);
+    Py_DECREF(tp);
+}
+
+/* Append item to the builder, stealing the reference */
+static int
+consbuilder_push(consmodule_state *state, ConsBuilderObject *self, PyObject *item)
+{
+    if (self->chunk == NULL) {
+        if ((self->chunk = chunk_new(state, CONS_CHUNK_MIN)) == NULL) {
+            Py_DECREF(item);
+            return -1;
+        }
+        self->capacity = CONS_CHUNK_MIN;
+    }
+    return chunk_append(&self->chunk, &self->capacity, item);
+}
+
+PyDoc_STRVAR(builder_append_doc, "append(item, /)\n\
+\n\
+Add item to the end of the list being built.");
+
+static PyObject *
+ConsBuilder_append(ConsBuilderObject *self, PyObject *item)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    int err;
+    Py_BEGIN_CRITICAL_SECTION(self);
+    err = consbuilder_push(state, self, Py_NewRef(item));
+    Py_END_CRITICAL_SECTION();
+    return err < 0 ? NULL : Py_NewRef(Py_None);
+}
+
+PyDoc_STRVAR(builder_extend_doc, "extend(iterable, /)\n\
+\n\
+Add the items of iterable to the end of the list being built.");
+
+static PyObject *
+ConsBuilder_extend(ConsBuilderObject *self, PyObject *iterable)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    PyObject *it = PyObject_GetIter(iterable);
+    if (it == NULL)
+        return NULL;
+    int err = 0;
+    PyObject *item;
+    Py_BEGIN_CRITICAL_SECTION(self);
+    while (err == 0 && (item = PyIter_Next(it)) != NULL)
+        err = consbuilder_push(state, self, item);
+    Py_END_CRITICAL_SECTION();
+    Py_DECREF(it);
+    return err < 0 || PyErr_Occurred() ? NULL : Py_NewRef(Py_None);
+}
+
+PyDoc_STRVAR(builder_build_doc, "build()\n\
+\n\
+Return the items appended so far as a proper cons list, and start again with an\n\
+empty builder.");
+
+static PyObject *
+ConsBuilder_build(ConsBuilderObject *self, PyObject *Py_UNUSED(ignored))
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    ChunkObject *chunk;
+    Py_BEGIN_CRITICAL_SECTION(self);
+    chunk = self->chunk;
+    self->chunk = NULL;
+    self->capacity = 0;
+    Py_END_CRITICAL_SECTION();
+    return chunk == NULL ? Py_NewRef(state->nil) : cons_from_chunk(state, chunk);
+}
+
+static Py_ssize_t
+ConsBuilder_length(ConsBuilderObject *self)
+{
+    Py_ssize_t n;
+    Py_BEGIN_CRITICAL_SECTION(self);
+    n = self->chunk == NULL ? 0 : Py_SIZE(self->chunk);
+    Py_END_CRITICAL_SECTION();
+    return n;
+}
+
+static PyMethodDef ConsBuilder_methods[] = {
+    {"append", (PyCFunction)ConsBuilder_append, METH_O, builder_append_doc},
+    {"extend", (PyCFunction)ConsBuilder_extend, METH_O, builder_extend_doc},
+    {"build", (PyCFunction)ConsBuilder_build, METH_NOARGS, builder_build_doc},
+    {NULL, NULL},
+};
+
+static PyType_Slot ConsBuilder_Type_Slots[] = {
+    {Py_tp_dealloc, ConsBuilder_dealloc},
+    {Py_tp_traverse, ConsBuilder_traverse},
+    {Py_tp_clear, ConsBuilder_clear},
+    {Py_tp_methods, ConsBuilder_methods},
+    {Py_sq_length, ConsBuilder_length},
+    {0, NULL},
+};
+
+static PyType_Spec ConsBuilder_Type_Spec = {
+    .name = "fastcons.cons_builder",
+    .basicsize = sizeof(ConsBuilderObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = ConsBuilder_Type_Slots,
+};
+
+PyObject *
+Cons_builder(PyObject *self, PyTypeObject *defining_class, PyObject *const *args,
+             Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 0 || kwnames != NULL) {
+        PyErr_SetString(PyExc_TypeError, "cons.builder takes no arguments");
+        return NULL;
+    }
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+    ConsBuilderObject *builder =
+        PyObject_GC_New(ConsBuilderObject, (PyTypeObject *)state->ConsBuilderType);
+    if (builder == NULL)
+        return NULL;
+    builder->chunk = NULL;
+    builder->capacity = 0;
+    PyObject_GC_Track(builder);
+    return (PyObject *)builder;
+}
+
+PyDoc_STRVAR(from_xs_doc, "Create a cons list from a sequence or iterable");
+PyDoc_STRVAR(to_list_doc, "Convert a proper const list to a Python list");
+PyDoc_STRVAR(stream_doc, "stream(xs)\n\
+\n\
+Create a lazy cons list from an iterable. The first item is taken straight away, and\n\
+each following item the first time the tail before it is needed.");
+PyDoc_STRVAR(lift_doc, "lift(obj, *, hamt=False)\n\
+\n\
+Recursively convert lists, tuples, sets, iterators and dicts in obj to conses.\n\
+Dicts become association lists, or hamt maps if 'hamt' is true.");
+PyDoc_STRVAR(builder_doc, "builder()\n\
+\n\
+Return a builder, which makes a proper cons list from items appended to its end.");
+PyDoc_STRVAR(lower_doc, "lower(obj, *, tuples=False, alists=False)\n\
+\n\
+Recursively convert proper cons lists in obj to lists (or tuples, if 'tuples'\n\
+is true), and hamt maps to dicts. If 'alists' is true, association lists with\n\
+hashable keys become dicts too.");
+
+static PyMethodDef Cons_methods[] = {
+    {"from_xs", (PyCFunction)Cons_from_xs,
+     METH_METHOD | METH_FASTCALL | METH_KEYWORDS | METH_CLASS, from_xs_doc},
+    {"to_list", (PyCFunction)Cons_to_list, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     to_list_doc},
+    {"__reduce__", (PyCFunction)Cons_reduce, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     NULL},
+    {"stream", (PyCFunction)Cons_stream, METH_METHOD | METH_FASTCALL | METH_KEYWORDS | METH_CLASS,
+     stream_doc},
+    {"lift", (PyCFunction)Cons_lift, METH_METHOD | METH_FASTCALL | METH_KEYWORDS | METH_CLASS,
+     lift_doc},
+    {"lower", (PyCFunction)Cons_lower, METH_METHOD | METH_FASTCALL | METH_KEYWORDS | METH_CLASS,
+     lower_doc},
+    {"indexed", (PyCFunction)Cons_indexed, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     indexed_doc},
+    {"builder", (PyCFunction)Cons_builder,
+     METH_METHOD | METH_FASTCALL | METH_KEYWORDS | METH_CLASS, builder_doc},
+    {NULL},
+};
+
+PyDoc_STRVAR(cons_doc, "Construct a new immutable pair");
+
+static PyType_Slot Cons_Type_Slots[] = {
+    {Py_tp_doc, (void *)cons_doc},
+    {Py_tp_dealloc, Cons_dealloc},
+    {Py_tp_new, Cons_new},
+    {Py_tp_members, Cons_members},
+    {Py_tp_getset, Cons_getset},
+    {Py_tp_traverse, Cons_traverse},
+    {Py_tp_clear, Cons_clear},
+    {Py_tp_repr, Cons_repr},
+    {Py_tp_iter, Cons_iter},
+    {Py_sq_length, Cons_length},
+    {Py_nb_bool, Cons_bool},
+    {Py_tp_methods, Cons_methods},
+    {Py_tp_richcompare, Cons_richcompare},
+    {Py_tp_hash, Cons_hash},
+    {0, NULL},
+};
+
+static PyType_Spec Cons_Type_Spec = {
+    .name = "fastcons.cons",
+    .basicsize = sizeof(ConsObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_MANAGED_WEAKREF,
+    .slots = Cons_Type_Slots,
+};
+
+/* The per-list cache */
+static void
+consindex_free(consindex *index)
+{
+    Py_XDECREF(index->chunk);
+    PyMem_Free(index->cells);
+    PyMem_Free(index);
+}
+
+static int
+ConsCache_traverse(ConsCacheObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(self));
+    Py_VISIT(self->assoc_index);
+    if (self->index != NULL)
+        Py_VISIT(self->index->chunk);
+    return 0;
+}
+
+/* The index and its chunk are left for dealloc, as views may still be reading them; a
+   cycle through them is broken by clearing the other objects in it. */
+static int
+ConsCache_clear(ConsCacheObject *self)
+{
+    Py_CLEAR(self->assoc_index);
+    return 0;
+}
+
+static void
+ConsCache_dealloc(ConsCacheObject *self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    ConsCache_clear(self);
+    if (self->index != NULL)
+        consindex_free(self->index);
+    PyObject_GC_Del(self);
+    Py_DECREF(tp);
+}
+
+static PyType_Slot ConsCache_Type_Slots[] = {
+    {Py_tp_dealloc, ConsCache_dealloc},
+    {Py_tp_traverse, ConsCache_traverse},
+    {Py_tp_clear, ConsCache_clear},
+    {0, NULL},
+};
+
+static PyType_Spec ConsCache_Type_Spec = {
+    .name = "fastcons._cons_cache",
+    .basicsize = sizeof(ConsCacheObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = ConsCache_Type_Slots,
+};
+
+/* Stream thunks */
+static int
+Thunk_traverse(ThunkObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(self));
+    Py_VISIT(self->it);
+    return 0;
+}
+
+static int
+Thunk_clear(ThunkObject *self)
+{
+    Py_CLEAR(self->it);
+    return 0;
+}
+
+static void
+Thunk_dealloc(ThunkObject *self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    Thunk_clear(self);
+    PyObject_GC_Del(self);
+    Py_DECREF(tp);
+}
+
+static PyType_Slot Thunk_Type_Slots[] = {
+    {Py_tp_dealloc, Thunk_dealloc},
+    {Py_tp_traverse, Thunk_traverse},
+    {Py_tp_clear, Thunk_clear},
+    {0, NULL},
+};
+
+static PyType_Spec Thunk_Type_Spec = {
+    .name = "fastcons._stream_thunk",
+    .basicsize = sizeof(ThunkObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = Thunk_Type_Slots,
+};
+
+/* List chunks */
+static int
+Chunk_traverse(ChunkObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(self));
+    for (Py_ssize_t i = Py_SIZE(self); --i >= 0;)
+        Py_VISIT(self->items[i]);
+    return 0;
+}
+
+static int
+Chunk_clear(ChunkObject *self)
+{
+    for (Py_ssize_t i = Py_SIZE(self); --i >= 0;)
+        Py_CLEAR(self->items[i]);
+    return 0;
+}
+
+static void
+Chunk_dealloc(ChunkObject *self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    Py_TRASHCAN_BEGIN(self, Chunk_dealloc);
+    Chunk_clear(self);
+    PyObject_GC_Del(self);
+    Py_DECREF(tp);
+    Py_TRASHCAN_END;
+}
+
+static PyType_Slot Chunk_Type_Slots[] = {
+    {Py_tp_dealloc, Chunk_dealloc},
+    {Py_tp_traverse, Chunk_traverse},
+    {Py_tp_clear, Chunk_clear},
+    {0, NULL},
+};
+
+static PyType_Spec Chunk_Type_Spec = {
+    .name = "fastcons._cons_chunk",
+    .basicsize = offsetof(ChunkObject, items),
+    .itemsize = sizeof(PyObject *),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = Chunk_Type_Slots,
+};
+
+/* Return the cache of a cell (a borrowed reference), creating it if needed */
+static ConsCacheObject *
+cons_get_cache(consmodule_state *state, PyObject *cell)
+{
+    ConsObject *op = (ConsObject *)cell;
+    ConsCacheObject *result;
+    Py_BEGIN_CRITICAL_SECTION(cell);
+    if (op->cache == NULL) {
+        ConsCacheObject *cache =
+            PyObject_GC_New(ConsCacheObject, (PyTypeObject *)state->ConsCacheType);
+        if (cache != NULL) {
+            cache->assoc_index = NULL;
+            cache->index = NULL;
+            PyObject_GC_Track(cache);
+            if (op->cache == NULL)
+                op->cache = (PyObject *)cache;
+            else
+                Py_DECREF(cache);
+        }
+    }
+    result = (ConsCacheObject *)op->cache;
+    Py_END_CRITICAL_SECTION();
+    return result;
+}
+
+/* Index views
+
+   xs.indexed() records the cells of the list once, in its cache, so positional access
+   doesn't walk the spine. A chunked list only needs its cells up to the chunk, whose
+   items are already indexable. */
+
+/* Build the index of a proper list or stream, forcing the stream */
+static consindex *
+consindex_build(PyObject *list)
+{
+    consindex *index = PyMem_Malloc(sizeof(consindex));
+    if (index == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    *index = (consindex){0};
+    Py_ssize_t capacity = 0;
+    PyObject *cell = list;
+    for (;;) {
+        if (index->split == capacity) {
+            capacity = capacity == 0 ? Py_MIN(Py_MAX(LENGTH(list), 1), 16) : capacity * 2;
+            PyObject **cells = PyMem_Resize(index->cells, PyObject *, (size_t)capacity);
+            if (cells == NULL) {
+                PyErr_NoMemory();
+                goto error;
+            }
+            index->cells = cells;
+        }
+        index->cells[index->split++] = cell;
+        if ((index->chunk = cons_chunk_ref(cell, &index->start)) != NULL) {
+            index->length = index->split + Py_SIZE(index->chunk) - index->start;
+            return index;
+        }
+        PyObject *tail = cons_tail(cell);
+        if (tail == NULL)
+            goto error;
+        else if (!Py_IS_TYPE(tail, Py_TYPE(list))) {
+            /* Proper lists and streams end in nil */
+            index->length = index->split;
+            return index;
+        }
+        cell = tail;
+    }
+
+error:
+    consindex_free(index);
+    return NULL;
+}
+
+/* Build the index of a list and cache it on its first cell, if that wasn't done yet */
+static consindex *
+cons_get_index(ConsCacheObject *cache, PyObject *list)
+{
+    consindex *index;
+    Py_BEGIN_CRITICAL_SECTION(cache);
+    index = cache->index;
+    Py_END_CRITICAL_SECTION();
+    if (index != NULL)
+        return index;
+
+    /* Forcing a stream may run code that indexes it too; the first index made wins */
+    consindex *built = consindex_build(list);
+    if (built == NULL)
+        return NULL;
+    Py_BEGIN_CRITICAL_SECTION(cache);
+    if (cache->index == NULL)
+        cache->index = built;
+    else
+        consindex_free(built);
+    index = cache->index;
+    Py_END_CRITICAL_SECTION();
+    return index;
+}
+
+typedef struct {
+    PyObject_HEAD
+    /* The list, or nil */
+    PyObject *list;
+    /* The list's cache, which owns its index, or NULL for nil */
+    ConsCacheObject *cache;
+    consindex *index;
+} ConsIndexObject;
+
+static int
+ConsIndex_traverse(ConsIndexObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(self));
+    Py_VISIT(self->list);
+    Py_VISIT(self->cache);
+    return 0;
+}
+
+static void
+ConsIndex_dealloc(ConsIndexObject *self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    Py_XDECREF(self->list);
+    Py_XDECREF(self->cache);
+    PyObject_GC_Del(self);
+    Py_DECREF(tp);
+}
+
+static Py_ssize_t
+ConsIndex_length(ConsIndexObject *self)
+{
+    return self->index == NULL ? 0 : self->index->length;
+}
+
+/* The item at position i of an indexed list, a borrowed reference */
+static inline PyObject *
+consindex_item(consindex *index, Py_ssize_t i)
+{
+    return i < index->split ? CAR(index->cells[i])
+                            : index->chunk->items[index->start + i - index->split];
+}
+
+/* A new reference to the rest of an indexed list from position i on. It's the list's own
+   cell if there is one, else a new cell sharing the list's chunk. */
+static PyObject *
+consindex_rest(consmodule_state *state, consindex *index, Py_ssize_t i)
+{
+    if (index == NULL || i >= index->length)
+        return Py_NewRef(state->nil);
+    else if (i < index->split)
+        return Py_NewRef(index->cells[i]);
+    return chunk_cell_at(state, index->chunk, index->start + i - index->split);
+}
+
+static PyObject *
+ConsIndex_item(ConsIndexObject *self, Py_ssize_t i)
+{
+    if (i < 0 || i >= ConsIndex_length(self)) {
+        PyErr_SetString(PyExc_IndexError, "cons index out of range");
+        return NULL;
+    }
+    return Py_NewRef(consindex_item(self->index, i));
+}
+
+static PyObject *
+ConsIndex_subscript(ConsIndexObject *self, PyObject *key)
+{
+    if (PyIndex_Check(key)) {
+        Py_ssize_t i = PyNumber_AsSsize_t(key, PyExc_IndexError);
+        if (i == -1 && PyErr_Occurred())
+            return NULL;
+        if (i < 0)
+            i += ConsIndex_length(self);
+        return ConsIndex_item(self, i);
+    }
+    else if (!PySlice_Check(key)) {
+        PyErr_Format(PyExc_TypeError, "cons indices must be integers or slices, not %.200s",
+                     Py_TYPE(key)->tp_name);
+        return NULL;
+    }
+
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    Py_ssize_t start, stop, step;
+    if (PySlice_Unpack(key, &start, &stop, &step) < 0)
+        return NULL;
+    Py_ssize_t length = ConsIndex_length(self);
+    Py_ssize_t n = PySlice_AdjustIndices(length, &start, &stop, step);
+    if (n == 0)
+        return Py_NewRef(state->nil);
+    else if (step == 1 && stop == length)
+        /* A suffix is a tail of the list */
+        return consindex_rest(state, self->index, start);
+
+    ChunkObject *chunk = chunk_new(state, n);
+    if (chunk == NULL)
+        return NULL;
+    for (Py_ssize_t i = 0, j = start; i < n; i++, j += step)
+        chunk_push(chunk, Py_NewRef(consindex_item(self->index, j)));
+    return cons_from_chunk(state, chunk);
+}
+
+static PyObject *
+ConsIndex_repr(ConsIndexObject *self)
+{
+    return PyUnicode_FromFormat("%R.indexed()", self->list);
+}
+
+static PyObject *
+ConsIndex_get_list(ConsIndexObject *self, void *closure)
+{
+    return Py_NewRef(self->list);
+}
+
+static PyGetSetDef ConsIndex_getset[] = {
+    {"list", (getter)ConsIndex_get_list, NULL, "The indexed list", NULL},
+    {NULL},
+};
+
+static PyType_Slot ConsIndex_Type_Slots[] = {
+    {Py_tp_dealloc, ConsIndex_dealloc},
+    {Py_tp_traverse, ConsIndex_traverse},
+    {Py_tp_repr, ConsIndex_repr},
+    {Py_tp_getset, ConsIndex_getset},
+    {Py_sq_length, ConsIndex_length},
+    {Py_sq_item, ConsIndex_item},
+    {Py_mp_length, ConsIndex_length},
+    {Py_mp_subscript, ConsIndex_subscript},
+    {0, NULL},
+};
+
+static PyType_Spec ConsIndex_Type_Spec = {
+    .name = "fastcons.cons_index",
+    .basicsize = sizeof(ConsIndexObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_DISALLOW_INSTANTIATION | Py_TPFLAGS_SEQUENCE,
+    .slots = ConsIndex_Type_Slots,
+};
+
+/* An index view of a proper list, stream or nil */
+static PyObject *
+cons_indexed(consmodule_state *state, PyObject *list)
+{
+    ConsCacheObject *cache = NULL;
+    consindex *index = NULL;
+    if (!Py_Is(list, state->nil)) {
+        if (!IS_LIST(list) && !IS_STREAM(list)) {
+            PyErr_SetString(PyExc_TypeError, "improper cons list can't be indexed");
+            return NULL;
+        }
+        if ((cache = cons_get_cache(state, list)) == NULL ||
+            (index = cons_get_index(cache, list)) == NULL)
+            return NULL;
+    }
+    ConsIndexObject *view =
+        PyObject_GC_New(ConsIndexObject, (PyTypeObject *)state->ConsIndexType);
+    if (view == NULL)
+        return NULL;
+    view->list = Py_NewRef(list);
+    view->cache = (ConsCacheObject *)Py_XNewRef(cache);
+    view->index = index;
+    PyObject_GC_Track(view);
+    return (PyObject *)view;
+}
+
+/* Parse the keyword arguments of a METH_FASTCALL | METH_KEYWORDS function. 'names' is a
+   NULL terminated array of the accepted keywords; the borrowed value of each keyword that
+   was passed is stored at the same index of 'values'. */
+static int
+parse_kwargs(PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames, const char *func,
+             const char *const *names, PyObject **values)
+{
+    if (kwnames == NULL)
+        return 0;
+
+    for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(kwnames); i++) {
+        PyObject *key = PyTuple_GET_ITEM(kwnames, i);
+        Py_ssize_t j = 0;
+        for (; names[j] != NULL; j++) {
+            if (PyUnicode_CompareWithASCIIString(key, names[j]) == 0) {
+                values[j] = args[nargs + i];
+                break;
+            }
+        }
+        if (names[j] == NULL) {
+            PyErr_Format(PyExc_TypeError, "%s() got an unexpected keyword argument '%U'",
+                         func, key);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* The hamt type
+
+   A persistent, immutable mapping implemented as a hash array mapped trie, after
+   CPython's Python/hamt.c. Each level of the trie consumes 5 bits of a 32 bit hash of
+   the key. Updates copy the path from the root to the changed node and share every other
+   node with the original map.
+
+   Bitmap nodes hold up to 32 slots, one for each value of their 5 bits of the hash, with
+   a bit set in the bitmap for each slot in use. Slots are stored as pairs in the node's
+   array: either (key, value), or (NULL, sub-node) when several keys share the slot.
+   Keys with identical 32 bit hashes end up together in a collision node, an unordered
+   array of (key, value) pairs.
+*/
+
+/* Seven levels of bitmap nodes cover the hash, plus a level of collision nodes */
+#define HAMT_MAX_TREE_DEPTH 8
+
+typedef enum {
+    HAMT_BITMAP,
+    HAMT_COLLISION,
+} hamt_node_kind;
+
+typedef struct {
+    PyObject_VAR_HEAD
+    hamt_node_kind kind;
+    /* HAMT_BITMAP: the slots in use */
+    uint32_t bitmap;
+    /* HAMT_COLLISION: the hash shared by every key in the node */
+    int32_t hash;
+    /* Py_SIZE(node) entries, two per key/value pair or sub-node */
+    PyObject *array[];
+} HamtNodeObject;
+
+typedef struct {
+    PyObject_HEAD
+    HamtNodeObject *root;
+    Py_ssize_t count;
+    /* Cached hash, -1 until computed */
+    Py_hash_t hash;
+} HamtObject;
+
+typedef enum {
+    HAMT_WITHOUT_ERROR,
+    HAMT_WITHOUT_NOT_FOUND,
+    HAMT_WITHOUT_EMPTY,
+    HAMT_WITHOUT_NEWNODE,
+} hamt_without_t;
+
+static inline int32_t
+hamt_hash(PyObject *key)
+{
+    Py_hash_t hash = PyObject_Hash(key);
+    if (hash == -1)
+        return -1;
+#if SIZEOF_PY_HASH_T > 4
+    int32_t folded = (int32_t)(hash & 0xffffffffl) ^ (int32_t)(hash >> 32);
+#else
+    int32_t folded = (int32_t)hash;
+#endif
+    return folded == -1 ? -2 : folded;
+}
+
+static inline uint32_t
+hamt_bitpos(int32_t hash, uint32_t shift)
+{
+    return (uint32_t)1 << (((uint32_t)hash >> shift) & 0x1f);
+}
+
+static inline uint32_t
+hamt_bitcount(uint32_t i)
+{
+    i = i - ((i >> 1) & 0x55555555);
+    i = (i & 0x33333333) + ((i >> 2) & 0x33333333);
+    return (((i + (i >> 4)) & 0xF0F0F0F) * 0x1010101) >> 24;
+}
+
+/* The position of the slot for bit among the slots in use */
+static inline Py_ssize_t
+hamt_bitindex(uint32_t bitmap, uint32_t bit)
+{
+    return (Py_ssize_t)hamt_bitcount(bitmap & (bit - 1));
+}
+
+static HamtNodeObject *
+hamt_node_new(consmodule_state *state, hamt_node_kind kind, Py_ssize_t size)
+{
+    HamtNodeObject *node =
+        PyObject_GC_NewVar(HamtNodeObject, (PyTypeObject *)state->HamtNodeType, size);
+    if (node == NULL)
+        return NULL;
+    node->kind = kind;
+    node->bitmap = 0;
+    node->hash = 0;
+    for (Py_ssize_t i = 0; i < size; i++)
+        node->array[i] = NULL;
+    PyObject_GC_Track(node);
+    return node;
+}
+
+static HamtNodeObject *
+hamt_node_clone(consmodule_state *state, HamtNodeObject *node)
+{
+    HamtNodeObject *clone = hamt_node_new(state, node->kind, Py_SIZE(node));
+    if (clone == NULL)
+        return NULL;
+    clone->bitmap = node->bitmap;
+    clone->hash = node->hash;
+    for (Py_ssize_t i = 0; i < Py_SIZE(node); i++)
+        clone->array[i] = Py_XNewRef(node->array[i]);
+    return clone;
+}
+
+static int
+HamtNode_traverse(HamtNodeObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(self));
+    for (Py_ssize_t i = 0; i < Py_SIZE(self); i++)
+        Py_VISIT(self->array[i]);
+    return 0;
+}
+
+static int
+HamtNode_clear(HamtNodeObject *self)
+{
+    for (Py_ssize_t i = 0; i < Py_SIZE(self); i++)
+        Py_CLEAR(self->array[i]);
+    return 0;
+}
+
+static void
+HamtNode_dealloc(HamtNodeObject *self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    Py_TRASHCAN_BEGIN(self, HamtNode_dealloc);
+    HamtNode_clear(self);
+    PyObject_GC_Del(self);
+    Py_DECREF(tp);
+    Py_TRASHCAN_END;
+}
+
+static PyType_Slot HamtNode_Type_Slots[] = {
+    {Py_tp_dealloc, HamtNode_dealloc},
+    {Py_tp_traverse, HamtNode_traverse},
+    {Py_tp_clear, HamtNode_clear},
+    {0, NULL},
+};
+
+static PyType_Spec HamtNode_Type_Spec = {
+    .name = "fastcons._hamt_node",
+    .basicsize = sizeof(HamtNodeObject),
+    .itemsize = sizeof(PyObject *),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = HamtNode_Type_Slots,
+};
+
+/* Make a node holding two pairs whose keys are different */
+static HamtNodeObject *
+hamt_node_from_two(consmodule_state *state, uint32_t shift, int32_t hash1, PyObject *key1,
+                   PyObject *val1, int32_t hash2, PyObject *key2, PyObject *val2)
+{
+    HamtNodeObject *node;
+    if (hash1 == hash2) {
+        if ((node = hamt_node_new(state, HAMT_COLLISION, 4)) == NULL)
+            return NULL;
+        node->hash = hash1;
+        node->array[0] = Py_NewRef(key1);
+        node->array[1] = Py_NewRef(val1);
+        node->array[2] = Py_NewRef(key2);
+        node->array[3] = Py_NewRef(val2);
+        return node;
+    }
+
+    uint32_t bit1 = hamt_bitpos(hash1, shift), bit2 = hamt_bitpos(hash2, shift);
+    if (bit1 == bit2) {
+        /* The hashes differ further down */
+        HamtNodeObject *sub =
+            hamt_node_from_two(state, shift + 5, hash1, key1, val1, hash2, key2, val2);
+        if (sub == NULL)
+            return NULL;
+        if ((node = hamt_node_new(state, HAMT_BITMAP, 2)) == NULL) {
+            Py_DECREF(sub);
+            return NULL;
+        }
+        node->bitmap = bit1;
+        node->array[1] = (PyObject *)sub;
+        return node;
+    }
+
+    if ((node = hamt_node_new(state, HAMT_BITMAP, 4)) == NULL)
+        return NULL;
+    node->bitmap = bit1 | bit2;
+    Py_ssize_t i = bit1 < bit2 ? 0 : 2;
+    node->array[i] = Py_NewRef(key1);
+    node->array[i + 1] = Py_NewRef(val1);
+    node->array[2 - i] = Py_NewRef(key2);
+    node->array[3 - i] = Py_NewRef(val2);
+    return node;
+}
+
+/* Find the position of key in a collision node's array: returns the index of the key,
+   -1 if it isn't there, or -2 on error. */
+static Py_ssize_t
+hamt_collision_find(HamtNodeObject *node, PyObject *key)
+{
+    for (Py_ssize_t i = 0; i < Py_SIZE(node); i += 2) {
+        int cmp = PyObject_RichCompareBool(key, node->array[i], Py_EQ);
+        if (cmp < 0)
+            return -2;
+        else if (cmp)
+            return i;
+    }
+    return -1;
+}
+
+/* Return a new reference to a node like 'node' but with key mapped to val, or to node
+   itself if it already maps key to val. Sets *added_leaf if key wasn't in the node. */
+static HamtNodeObject *
+hamt_node_assoc(consmodule_state *state, HamtNodeObject *node, uint32_t shift, int32_t hash,
+                PyObject *key, PyObject *val, int *added_leaf)
+{
+    HamtNodeObject *result;
+
+    if (node->kind == HAMT_COLLISION) {
+        if (hash != node->hash) {
+            /* Move the collision node down a level, under a bitmap node, and add key
+               alongside it */
+            HamtNodeObject *wrapper = hamt_node_new(state, HAMT_BITMAP, 2);
+            if (wrapper == NULL)
+                return NULL;
+            wrapper->bitmap = hamt_bitpos(node->hash, shift);
+            wrapper->array[1] = Py_NewRef(node);
+            result = hamt_node_assoc(state, wrapper, shift, hash, key, val, added_leaf);
+            Py_DECREF(wrapper);
+            return result;
+        }
+
+        Py_ssize_t i = hamt_collision_find(node, key);
+        if (i == -2)
+            return NULL;
+        else if (i >= 0) {
+            if (Py_Is(node->array[i + 1], val))
+                return (HamtNodeObject *)Py_NewRef(node);
+            if ((result = hamt_node_clone(state, node)) == NULL)
+                return NULL;
+            Py_SETREF(result->array[i + 1], Py_NewRef(val));
+            return result;
+        }
+
+        if ((result = hamt_node_new(state, HAMT_COLLISION, Py_SIZE(node) + 2)) == NULL)
+            return NULL;
+        result->hash = hash;
+        for (i = 0; i < Py_SIZE(node); i++)
+            result->array[i] = Py_NewRef(node->array[i]);
+        result->array[i] = Py_NewRef(key);
+        result->array[i + 1] = Py_NewRef(val);
+        *added_leaf = 1;
+        return result;
+    }
+
+    uint32_t bit = hamt_bitpos(hash, shift);
+    Py_ssize_t idx = 2 * hamt_bitindex(node->bitmap, bit);
+
+    if (!(node->bitmap & bit)) {
+        /* A free slot: insert the pair */
+        if ((result = hamt_node_new(state, HAMT_BITMAP, Py_SIZE(node) + 2)) == NULL)
+            return NULL;
+        result->bitmap = node->bitmap | bit;
+        for (Py_ssize_t i = 0; i < idx; i++)
+            result->array[i] = Py_XNewRef(node->array[i]);
+        result->array[idx] = Py_NewRef(key);
+        result->array[idx + 1] = Py_NewRef(val);
+        for (Py_ssize_t i = idx; i < Py_SIZE(node); i++)
+            result->array[i + 2] = Py_XNewRef(node->array[i]);
+        *added_leaf = 1;
+        return result;
+    }
+
+    PyObject *k = node->array[idx], *v = node->array[idx + 1];
+    if (k == NULL) {
+        /* A sub-node */
+        HamtNodeObject *sub = hamt_node_assoc(state, (HamtNodeObject *)v, shift + 5, hash,
+                                              key, val, added_leaf);
+        if (sub == NULL)
+            return NULL;
+        if (Py_Is((PyObject *)sub, v)) {
+            Py_DECREF(sub);
+            return (HamtNodeObject *)Py_NewRef(node);
+        }
+        if ((result = hamt_node_clone(state, node)) == NULL) {
+            Py_DECREF(sub);
+            return NULL;
+        }
+        Py_SETREF(result->array[idx + 1], (PyObject *)sub);
+        return result;
+    }
+
+    int cmp = PyObject_RichCompareBool(key, k, Py_EQ);
+    if (cmp < 0)
+        return NULL;
+    else if (cmp) {
+        if (Py_Is(v, val))
+            return (HamtNodeObject *)Py_NewRef(node);
+        if ((result = hamt_node_clone(state, node)) == NULL)
+            return NULL;
+        Py_SETREF(result->array[idx + 1], Py_NewRef(val));
+        return result;
+    }
+
+    /* Another key uses this slot: replace it with a sub-node holding both */
+    int32_t khash = hamt_hash(k);
+    if (khash == -1)
+        return NULL;
+    HamtNodeObject *sub =
+        hamt_node_from_two(state, shift + 5, khash, k, v, hash, key, val);
+    if (sub == NULL)
+        return NULL;
+    if ((result = hamt_node_clone(state, node)) == NULL) {
+        Py_DECREF(sub);
+        return NULL;
+    }
+    Py_CLEAR(result->array[idx]);
+    Py_SETREF(result->array[idx + 1], (PyObject *)sub);
+    *added_leaf = 1;
+    return result;
+}
+
+/* A copy of a node without the pair at index idx of its array */
+static HamtNodeObject *
+hamt_node_remove_pair(consmodule_state *state, HamtNodeObject *node, Py_ssize_t idx)
+{
+    HamtNodeObject *result = hamt_node_new(state, node->kind, Py_SIZE(node) - 2);
+    if (result == NULL)
+        return NULL;
+    result->bitmap = node->bitmap;
+    result->hash = node->hash;
+    for (Py_ssize_t i = 0, j = 0; i < Py_SIZE(node); i++)
+        if (i != idx && i != idx + 1)
+            result->array[j++] = Py_XNewRef(node->array[i]);
+    return result;
+}
+
+/* Remove key from a node. On HAMT_WITHOUT_NEWNODE, *new_node is set to a new reference
+   to the node without the key. */
+static hamt_without_t
+hamt_node_without(consmodule_state *state, HamtNodeObject *node, uint32_t shift, int32_t hash,
+                  PyObject *key, HamtNodeObject **new_node)
+{
+    if (node->kind == HAMT_COLLISION) {
+        if (hash != node->hash)
+            return HAMT_WITHOUT_NOT_FOUND;
+        Py_ssize_t i = hamt_collision_find(node, key);
+        if (i == -2)
+            return HAMT_WITHOUT_ERROR;
+        else if (i == -1)
+            return HAMT_WITHOUT_NOT_FOUND;
+        else if (Py_SIZE(node) == 2)
+            return HAMT_WITHOUT_EMPTY;
+        *new_node = hamt_node_remove_pair(state, node, i);
+        return *new_node == NULL ? HAMT_WITHOUT_ERROR : HAMT_WITHOUT_NEWNODE;
+    }
+
+    uint32_t bit = hamt_bitpos(hash, shift);
+    if (!(node->bitmap & bit))
+        return HAMT_WITHOUT_NOT_FOUND;
+
+    Py_ssize_t idx = 2 * hamt_bitindex(node->bitmap, bit);
+    PyObject *k = node->array[idx], *v = node->array[idx + 1];
+
+    if (k == NULL) {
+        HamtNodeObject *sub = NULL;
+        hamt_without_t res =
+            hamt_node_without(state, (HamtNodeObject *)v, shift + 5, hash, key, &sub);
+        if (res == HAMT_WITHOUT_NEWNODE) {
+            HamtNodeObject *result = hamt_node_clone(state, node);
+            if (result == NULL) {
+                Py_DECREF(sub);
+                return HAMT_WITHOUT_ERROR;
+            }
+            if (Py_SIZE(sub) == 2 && sub->array[0] != NULL) {
+                /* The sub-node has a single pair left, so keep it in this node instead */
+                result->array[idx] = Py_NewRef(sub->array[0]);
+                Py_SETREF(result->array[idx + 1], Py_NewRef(sub->array[1]));
+                Py_DECREF(sub);
+            }
+            else
+                Py_SETREF(result->array[idx + 1], (PyObject *)sub);
+            *new_node = result;
+            return HAMT_WITHOUT_NEWNODE;
+        }
+        else if (res != HAMT_WITHOUT_EMPTY)
+            return res;
+        /* The sub-node is empty: fall through and remove its slot */
+    }
+    else {
+        int cmp = PyObject_RichCompareBool(key, k, Py_EQ);
+        if (cmp < 0)
+            return HAMT_WITHOUT_ERROR;
+        else if (!cmp)
+            return HAMT_WITHOUT_NOT_FOUND;
+    }
+
+    if (Py_SIZE(node) == 2)
+        return HAMT_WITHOUT_EMPTY;
+    if ((*new_node = hamt_node_remove_pair(state, node, idx)) == NULL)
+        return HAMT_WITHOUT_ERROR;
+    (*new_node)->bitmap &= ~bit;
+    return HAMT_WITHOUT_NEWNODE;
+}
+
+/* Look key up: returns 1 and sets *val to a borrowed reference if it's found, 0 if it
+   isn't, or -1 on error. */
+static int
+hamt_node_find(HamtNodeObject *node, int32_t hash, PyObject *key, PyObject **val)
+{
+    for (uint32_t shift = 0;; shift += 5) {
+        if (node->kind == HAMT_COLLISION) {
+            if (hash != node->hash)
+                return 0;
+            Py_ssize_t i = hamt_collision_find(node, key);
+            if (i < 0)
+                return i == -1 ? 0 : -1;
+            *val = node->array[i + 1];
+            return 1;
+        }
+
+        uint32_t bit = hamt_bitpos(hash, shift);
+        if (!(node->bitmap & bit))
+            return 0;
+        Py_ssize_t idx = 2 * hamt_bitindex(node->bitmap, bit);
+        PyObject *k = node->array[idx];
+        if (k == NULL) {
+            node = (HamtNodeObject *)node->array[idx + 1];
+            continue;
+        }
+        int cmp = PyObject_RichCompareBool(key, k, Py_EQ);
+        if (cmp <= 0)
+            return cmp;
+        *val = node->array[idx + 1];
+        return 1;
+    }
+}
+
+/* Depth first iteration over the pairs in a trie */
+typedef struct {
+    HamtNodeObject *nodes[HAMT_MAX_TREE_DEPTH];
+    Py_ssize_t pos[HAMT_MAX_TREE_DEPTH];
+    int level;
+} hamt_iterator;
+
+static void
+hamt_iterator_init(hamt_iterator *it, HamtNodeObject *root)
+{
+    it->nodes[0] = root;
+    it->pos[0] = 0;
+    it->level = 0;
+}
+
+/* Returns 1 and sets borrowed references to the next pair, or 0 when exhausted */
+static int
+hamt_iterator_next(hamt_iterator *it, PyObject **key, PyObject **val)
+{
+    while (it->level >= 0) {
+        HamtNodeObject *node = it->nodes[it->level];
+        Py_ssize_t pos = it->pos[it->level];
+        if (pos >= Py_SIZE(node)) {
+            it->level--;
+            continue;
+        }
+        it->pos[it->level] = pos + 2;
+        if (node->array[pos] == NULL) {
+            assert(it->level + 1 < HAMT_MAX_TREE_DEPTH);
+            it->level++;
+            it->nodes[it->level] = (HamtNodeObject *)node->array[pos + 1];
+            it->pos[it->level] = 0;
+            continue;
+        }
+        *key = node->array[pos];
+        *val = node->array[pos + 1];
+        return 1;
+    }
+    return 0;
+}
+
+static HamtObject *
+hamt_new(consmodule_state *state, HamtNodeObject *root, Py_ssize_t count)
+{
+    HamtObject *self = PyObject_GC_New(HamtObject, (PyTypeObject *)state->HamtType);
+    if (self == NULL) {
+        Py_DECREF(root);
+        return NULL;
+    }
+    self->root = root;
+    self->count = count;
+    self->hash = -1;
+    PyObject_GC_Track(self);
+    return self;
+}
+
+static HamtObject *
+hamt_new_empty(consmodule_state *state)
+{
+    HamtNodeObject *root = hamt_node_new(state, HAMT_BITMAP, 0);
+    if (root == NULL)
+        return NULL;
+    return hamt_new(state, root, 0);
+}
+
+/* Return a new map with key mapped to val, or a new reference to self if nothing
+   changed */
+static HamtObject *
+hamt_assoc(consmodule_state *state, HamtObject *self, PyObject *key, PyObject *val)
+{
+    int32_t hash = hamt_hash(key);
+    if (hash == -1)
+        return NULL;
+    int added_leaf = 0;
+    HamtNodeObject *root =
+        hamt_node_assoc(state, self->root, 0, hash, key, val, &added_leaf);
+    if (root == NULL)
+        return NULL;
+    if (Py_Is(root, self->root)) {
+        Py_DECREF(root);
+        return (HamtObject *)Py_NewRef(self);
+    }
+    return hamt_new(state, root, self->count + added_leaf);
+}
+
+/* Return a new map without key, a new reference to self if key isn't in the map (setting
+   *found to 0), or NULL on error */
+static HamtObject *
+hamt_without(consmodule_state *state, HamtObject *self, PyObject *key, int *found)
+{
+    int32_t hash = hamt_hash(key);
+    if (hash == -1)
+        return NULL;
+    HamtNodeObject *root = NULL;
+    *found = 1;
+    switch (hamt_node_without(state, self->root, 0, hash, key, &root)) {
+    case HAMT_WITHOUT_ERROR:
+        return NULL;
+    case HAMT_WITHOUT_NOT_FOUND:
+        *found = 0;
+        return (HamtObject *)Py_NewRef(self);
+    case HAMT_WITHOUT_EMPTY:
+        return hamt_new_empty(state);
+    default:
+        return hamt_new(state, root, self->count - 1);
+    }
+}
+
+static int
+hamt_find(HamtObject *self, PyObject *key, PyObject **val)
+{
+    int32_t hash = hamt_hash(key);
+    if (hash == -1)
+        return -1;
+    return hamt_node_find(self->root, hash, key, val);
+}
+
+/* Build a map from an association list; the first pair for each key wins, as in assoc */
+static HamtObject *
+hamt_from_alist(consmodule_state *state, PyObject *alist)
+{
+    HamtObject *result = hamt_new_empty(state);
+    conswalk walk = CONSWALK_INIT(alist);
+    PyObject *pair, *val;
+    while (result != NULL && conswalk_next(state, &walk, &pair) > 0) {
+        if (!Py_IS_TYPE(pair, (PyTypeObject *)state->ConsType)) {
+            PyErr_SetString(PyExc_ValueError,
+                            "'alist' is not a properly formed association list");
+            Py_CLEAR(result);
+            break;
+        }
+        int found = hamt_find(result, CAR(pair), &val);
+        PyObject *tail = NULL;
+        if (found < 0 || (!found && (tail = cons_tail(pair)) == NULL))
+            Py_CLEAR(result);
+        else if (!found)
+            Py_SETREF(result, hamt_assoc(state, result, CAR(pair), tail));
+    }
+    conswalk_fini(&walk);
+    return result;
+}
+
+/* Build a map from a mapping, or an iterable of key/value pairs */
+static HamtObject *
+hamt_from_object(consmodule_state *state, PyObject *op)
+{
+    PyObject *items = NULL;
+    if (PyDict_Check(op)) {
+        HamtObject *result = hamt_new_empty(state);
+        PyObject *key, *val;
+        Py_ssize_t pos = 0;
+        while (result != NULL && PyDict_Next(op, &pos, &key, &val))
+            Py_SETREF(result, hamt_assoc(state, result, key, val));
+        return result;
+    }
+    else if (PyMapping_Check(op) && PyObject_HasAttrString(op, "items"))
+        items = PyMapping_Items(op);
+    else
+        items = Py_NewRef(op);
+    if (items == NULL)
+        return NULL;
+
+    PyObject *it = PyObject_GetIter(items);
+    Py_DECREF(items);
+    if (it == NULL)
+        return NULL;
+
+    HamtObject *result = hamt_new_empty(state);
+    PyObject *item;
+    while (result != NULL && (item = PyIter_Next(it)) != NULL) {
+        PyObject *pair = PySequence_Fast(item, "hamt() items must be key/value pairs");
+        Py_DECREF(item);
+        if (pair == NULL || PySequence_Fast_GET_SIZE(pair) != 2) {
+            if (pair != NULL)
+                PyErr_SetString(PyExc_ValueError, "hamt() items must be key/value pairs");
+            Py_XDECREF(pair);
+            Py_CLEAR(result);
+            break;
+        }
+        Py_SETREF(result, hamt_assoc(state, result, PySequence_Fast_GET_ITEM(pair, 0),
+                                     PySequence_Fast_GET_ITEM(pair, 1)));
+        Py_DECREF(pair);
+    }
+    Py_DECREF(it);
+    if (result != NULL && PyErr_Occurred())
+        Py_CLEAR(result);
+    return result;
+}
+
+static PyObject *
+Hamt_new(PyTypeObject *type, PyObject *args, PyObject *kwds)
+{
+    PyObject *op = NULL;
+    if (!PyArg_ParseTuple(args, "|O:hamt", &op))
+        return NULL;
+    if (kwds != NULL && PyDict_GET_SIZE(kwds) != 0) {
+        PyErr_SetString(PyExc_TypeError, "hamt() takes no keyword arguments");
+        return NULL;
+    }
+    consmodule_state *state = PyType_GetModuleState(type);
+    if (state == NULL)
+        return NULL;
+
+    if (op == NULL || Py_Is(op, state->nil))
+        return (PyObject *)hamt_new_empty(state);
+    else if (Py_IS_TYPE(op, type))
+        return Py_NewRef(op);
+    else if (Py_IS_TYPE(op, (PyTypeObject *)state->ConsType)) {
+        if (!IS_LIST(op)) {
+            PyErr_SetString(PyExc_ValueError, "expected proper cons list");
+            return NULL;
+        }
+        return (PyObject *)hamt_from_alist(state, op);
+    }
+    return (PyObject *)hamt_from_object(state, op);
+}
+
+static int
+Hamt_traverse(HamtObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(self));
+    Py_VISIT(self->root);
+    return 0;
+}
+
+static int
+Hamt_clear(HamtObject *self)
+{
+    Py_CLEAR(self->root);
+    return 0;
+}
+
+static void
+Hamt_dealloc(HamtObject *self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    Py_TRASHCAN_BEGIN(self, Hamt_dealloc);
+    Hamt_clear(self);
+    PyObject_GC_Del(self);
+    Py_DECREF(tp);
+    Py_TRASHCAN_END;
+}
+
+static Py_ssize_t
+Hamt_length(HamtObject *self)
+{
+    return self->count;
+}
+
+static PyObject *
+Hamt_subscript(HamtObject *self, PyObject *key)
+{
+    PyObject *val;
+    int found = hamt_find(self, key, &val);
+    if (found < 0)
+        return NULL;
+    else if (!found) {
+        PyErr_SetObject(PyExc_KeyError, key);
+        return NULL;
+    }
+    return Py_NewRef(val);
+}
+
+static int
+Hamt_contains(HamtObject *self, PyObject *key)
+{
+    PyObject *val;
+    return hamt_find(self, key, &val);
+}
+
+static PyObject *
+Hamt_get(HamtObject *self, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs < 1 || nargs > 2) {
+        PyErr_SetString(PyExc_TypeError, "hamt.get takes one or two arguments");
+        return NULL;
+    }
+    PyObject *val;
+    int found = hamt_find(self, args[0], &val);
+    if (found < 0)
+        return NULL;
+    else if (found)
+        return Py_NewRef(val);
+    return Py_NewRef(nargs == 2 ? args[1] : Py_None);
+}
+
+static PyObject *
+Hamt_set(HamtObject *self, PyTypeObject *defining_class, PyObject *const *args,
+         Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 2 || (kwnames != NULL && PyTuple_GET_SIZE(kwnames) != 0)) {
+        PyErr_SetString(PyExc_TypeError, "hamt.set takes exactly two positional arguments");
+        return NULL;
+    }
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+    return (PyObject *)hamt_assoc(state, self, args[0], args[1]);
+}
+
+static PyObject *
+Hamt_delete(HamtObject *self, PyTypeObject *defining_class, PyObject *const *args,
+            Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 1 || (kwnames != NULL && PyTuple_GET_SIZE(kwnames) != 0)) {
+        PyErr_SetString(PyExc_TypeError, "hamt.delete takes exactly one positional argument");
+        return NULL;
+    }
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+    int found;
+    HamtObject *result = hamt_without(state, self, args[0], &found);
+    if (result != NULL && !found) {
+        Py_DECREF(result);
+        PyErr_SetObject(PyExc_KeyError, args[0]);
+        return NULL;
+    }
+    return (PyObject *)result;
+}
+
+static PyObject *
+Hamt_to_alist(HamtObject *self, PyTypeObject *defining_class, PyObject *const *args,
+              Py_ssize_t nargs, PyObject *kwnames)
+{
+    if (nargs != 0) {
+        PyErr_SetString(PyExc_TypeError, "expected zero arguments");
+        return NULL;
+    }
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+
+    consbuilder builder = CONSBUILDER_INIT;
+    hamt_iterator it;
+    hamt_iterator_init(&it, self->root);
+    PyObject *key, *val;
+    while (hamt_iterator_next(&it, &key, &val)) {
+        PyObject *pair = Cons_NEW_PY(state);
+        if (pair == NULL) {
+            consbuilder_abort(&builder);
+            return NULL;
+        }
+        SET_CAR(pair, Py_NewRef(key));
+        SET_CDR(pair, Py_NewRef(val));
+        SET_LENGTH(pair, cons_length_with_tail(state, val));
+        cons_track(state, pair);
+        if (consbuilder_append(state, &builder, pair) < 0) {
+            consbuilder_abort(&builder);
+            return NULL;
+        }
+    }
+    return consbuilder_finish(state, &builder);
+}
+
+/* Pickle a map as the dict of its items */
+static PyObject *
+Hamt_reduce(HamtObject *self, PyObject *Py_UNUSED(ignored))
+{
+    PyObject *items = PyDict_New();
+    if (items == NULL)
+        return NULL;
+
+    hamt_iterator it;
+    hamt_iterator_init(&it, self->root);
+    PyObject *key, *val;
+    while (hamt_iterator_next(&it, &key, &val)) {
+        if (PyDict_SetItem(items, key, val) < 0) {
+            Py_DECREF(items);
+            return NULL;
+        }
+    }
+    return Py_BuildValue("O(N)", Py_TYPE(self), items);
+}
+
+/* Iterators over keys, values or items */
+typedef enum {
+    HAMT_ITER_KEYS,
+    HAMT_ITER_VALUES,
+    HAMT_ITER_ITEMS,
+} hamt_iter_kind;
+
+typedef struct {
+    PyObject_HEAD
+    HamtObject *map;
+    hamt_iterator it;
+    hamt_iter_kind kind;
+    Py_ssize_t remaining;
+} HamtIterObject;
+
+static PyObject *
+HamtIter_new(consmodule_state *state, HamtObject *map, hamt_iter_kind kind)
+{
+    HamtIterObject *it = PyObject_GC_New(HamtIterObject, (PyTypeObject *)state->HamtIterType);
+    if (it == NULL)
+        return NULL;
+    it->map = (HamtObject *)Py_NewRef(map);
+    hamt_iterator_init(&it->it, map->root);
+    it->kind = kind;
+    it->remaining = map->count;
+    PyObject_GC_Track(it);
+    return (PyObject *)it;
+}
+
+static int
+HamtIter_traverse(HamtIterObject *it, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(it));
+    Py_VISIT(it->map);
+    return 0;
+}
+
+static void
+HamtIter_dealloc(HamtIterObject *it)
+{
+    PyTypeObject *tp = Py_TYPE(it);
+    PyObject_GC_UnTrack(it);
+    Py_XDECREF(it->map);
+    PyObject_GC_Del(it);
+    Py_DECREF(tp);
+}
+
+static PyObject *
+HamtIter_next(HamtIterObject *it)
+{
+    PyObject *key, *val;
+    if (!hamt_iterator_next(&it->it, &key, &val))
+        return NULL;
+    it->remaining--;
+    switch (it->kind) {
+    case HAMT_ITER_KEYS:
+        return Py_NewRef(key);
+    case HAMT_ITER_VALUES:
+        return Py_NewRef(val);
+    default:
+        return PyTuple_Pack(2, key, val);
+    }
+}
+
+static PyObject *
+HamtIter_length_hint(HamtIterObject *it, PyObject *Py_UNUSED(ignored))
+{
+    return PyLong_FromSsize_t(it->remaining);
+}
+
+static PyMethodDef HamtIter_methods[] = {
+    {"__length_hint__", (PyCFunction)HamtIter_length_hint, METH_NOARGS, length_hint_doc},
+    {NULL, NULL},
+};
+
+static PyType_Slot HamtIter_Type_Slots[] = {
+    {Py_tp_dealloc, HamtIter_dealloc},
+    {Py_tp_traverse, HamtIter_traverse},
+    {Py_tp_iter, PyObject_SelfIter},
+    {Py_tp_iternext, HamtIter_next},
+    {Py_tp_methods, HamtIter_methods},
+    {0, NULL},
+};
+
+static PyType_Spec HamtIter_Type_Spec = {
+    .name = "fastcons.hamt_iterator",
+    .basicsize = sizeof(HamtIterObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = HamtIter_Type_Slots,
+};
+
+static PyObject *
+hamt_iter_method(HamtObject *self, PyTypeObject *defining_class, Py_ssize_t nargs,
+                 PyObject *kwnames, hamt_iter_kind kind)
+{
+    if (nargs != 0 || kwnames != NULL) {
+        PyErr_SetString(PyExc_TypeError, "expected zero arguments");
+        return NULL;
+    }
+    consmodule_state *state = PyType_GetModuleState(defining_class);
+    if (state == NULL)
+        return NULL;
+    return HamtIter_new(state, self, kind);
+}
+
+static PyObject *
+Hamt_keys(HamtObject *self, PyTypeObject *defining_class, PyObject *const *args,
+          Py_ssize_t nargs, PyObject *kwnames)
+{
+    return hamt_iter_method(self, defining_class, nargs, kwnames, HAMT_ITER_KEYS);
+}
+
+static PyObject *
+Hamt_values(HamtObject *self, PyTypeObject *defining_class, PyObject *const *args,
+            Py_ssize_t nargs, PyObject *kwnames)
+{
+    return hamt_iter_method(self, defining_class, nargs, kwnames, HAMT_ITER_VALUES);
+}
+
+static PyObject *
+Hamt_items(HamtObject *self, PyTypeObject *defining_class, PyObject *const *args,
+           Py_ssize_t nargs, PyObject *kwnames)
+{
+    return hamt_iter_method(self, defining_class, nargs, kwnames, HAMT_ITER_ITEMS);
+}
+
+static PyObject *
+Hamt_iter(HamtObject *self)
+{
+    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
+    if (state == NULL)
+        return NULL;
+    return HamtIter_new(state, self, HAMT_ITER_KEYS);
+}
+
+static PyObject *
+Hamt_richcompare(HamtObject *self, PyObject *other, int op)
+{
+    if ((op != Py_EQ && op != Py_NE) || !Py_IS_TYPE(other, Py_TYPE(self)))
+        Py_RETURN_NOTIMPLEMENTED;
+
+    HamtObject *that = (HamtObject *)other;
+    int equal = 1;
+    if (Py_Is(self, that))
+        equal = 1;
+    else if (self->count != that->count ||
+             hashes_differ(LOAD_SSIZE(self->hash), LOAD_SSIZE(that->hash)))
+        equal = 0;
+    else {
+        hamt_iterator it;
+        hamt_iterator_init(&it, self->root);
+        PyObject *key, *val, *other_val;
+        while (equal == 1 && hamt_iterator_next(&it, &key, &val)) {
+            int found = hamt_find(that, key, &other_val);
+            if (found <= 0)
+                equal = found;
+            else
+                equal = PyObject_RichCompareBool(val, other_val, Py_EQ);
+        }
+        if (equal < 0)
+            return NULL;
+    }
+    return PyBool_FromLong(op == Py_EQ ? equal : !equal);
+}
+
+/* An order independent hash of the pairs, like frozenset's */
+static Py_hash_t
+Hamt_hash(HamtObject *self)
+{
+    Py_hash_t cached = LOAD_SSIZE(self->hash);
+    if (cached != -1)
+        return cached;
+
+    Py_uhash_t acc = 0;
+    hamt_iterator it;
+    hamt_iterator_init(&it, self->root);
+    PyObject *key, *val;
+    while (hamt_iterator_next(&it, &key, &val)) {
+        Py_hash_t khash = PyObject_Hash(key), vhash;
+        if (khash == -1 || (vhash = PyObject_Hash(val)) == -1)
+            return -1;
+        Py_uhash_t h = cons_hash_combine((Py_uhash_t)khash, (Py_uhash_t)vhash);
+        acc ^= ((h ^ 89869747UL) ^ (h << 16)) * 3644798167UL;
+    }
+    acc ^= ((Py_uhash_t)self->count + 1) * 1927868237UL;
+    Py_hash_t hash = (Py_hash_t)acc;
+    if (hash == -1)
+        hash = 590923713;
+    STORE_SSIZE(self->hash, hash);
+    return hash;
+}
+
+static PyObject *
+Hamt_repr(HamtObject *self)
+{
+    if (self->count == 0)
+        return PyUnicode_FromString("hamt()");
+
+    int i = Py_ReprEnter((PyObject *)self);
+    if (i != 0)
+        return i > 0 ? PyUnicode_FromString("hamt({...})") : NULL;
+
+    _PyUnicodeWriter writer;
+    _PyUnicodeWriter_Init(&writer);
+    writer.overallocate = 1;
+    if (_PyUnicodeWriter_WriteASCIIString(&writer, "hamt({", 6) < 0)
+        goto error;
+
+    hamt_iterator it;
+    hamt_iterator_init(&it, self->root);
+    PyObject *key, *val;
+    bool first = true;
+    while (hamt_iterator_next(&it, &key, &val)) {
+        if (!first && _PyUnicodeWriter_WriteASCIIString(&writer, ", ", 2) < 0)
+            goto error;
+        first = false;
+        PyObject *repr = PyObject_Repr(key);
+        if (repr == NULL)
+            goto error;
+        int err = _PyUnicodeWriter_WriteStr(&writer, repr);
+        Py_DECREF(repr);
+        if (err < 0 || _PyUnicodeWriter_WriteASCIIString(&writer, ": ", 2) < 0)
+            goto error;
+        if ((repr = PyObject_Repr(val)) == NULL)
+            goto error;
+        err = _PyUnicodeWriter_WriteStr(&writer, repr);
+        Py_DECREF(repr);
+        if (err < 0)
+            goto error;
+    }
+
+    writer.overallocate = 0;
+    if (_PyUnicodeWriter_WriteASCIIString(&writer, "})", 2) < 0)
+        goto error;
+    Py_ReprLeave((PyObject *)self);
+    return _PyUnicodeWriter_Finish(&writer);
+
+error:
+    _PyUnicodeWriter_Dealloc(&writer);
+    Py_ReprLeave((PyObject *)self);
+    return NULL;
+}
+
+PyDoc_STRVAR(Hamt_get_doc, "get(key, default=None)\n\
+\n\
+Return the value for key if key is in the map, else default.");
+PyDoc_STRVAR(Hamt_set_doc, "set(key, value)\n\
+\n\
+Return a new map with key mapped to value, sharing structure with this one.");
+PyDoc_STRVAR(Hamt_delete_doc, "delete(key)\n\
+\n\
+Return a new map without key, sharing structure with this one. Raise KeyError\n\
+if key is not in the map.");
+PyDoc_STRVAR(Hamt_to_alist_doc, "Convert the map to an association list of (key . value) pairs");
+PyDoc_STRVAR(Hamt_keys_doc, "Return an iterator over the map's keys");
+PyDoc_STRVAR(Hamt_values_doc, "Return an iterator over the map's values");
+PyDoc_STRVAR(Hamt_items_doc, "Return an iterator over the map's (key, value) tuples");
+
+static PyMethodDef Hamt_methods[] = {
+    {"get", (PyCFunction)Hamt_get, METH_FASTCALL, Hamt_get_doc},
+    {"__reduce__", (PyCFunction)Hamt_reduce, METH_NOARGS, NULL},
+    {"set", (PyCFunction)Hamt_set, METH_METHOD | METH_FASTCALL | METH_KEYWORDS, Hamt_set_doc},
+    {"delete", (PyCFunction)Hamt_delete, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     Hamt_delete_doc},
+    {"to_alist", (PyCFunction)Hamt_to_alist, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     Hamt_to_alist_doc},
+    {"keys", (PyCFunction)Hamt_keys, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     Hamt_keys_doc},
+    {"values", (PyCFunction)Hamt_values, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     Hamt_values_doc},
+    {"items", (PyCFunction)Hamt_items, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
+     Hamt_items_doc},
+    {NULL, NULL},
+};
+
+PyDoc_STRVAR(hamt_doc, "hamt(mapping_or_alist=(), /)\n\
+\n\
+A persistent immutable mapping. Build one from a mapping, an association list\n\
+or an iterable of key/value pairs.");
+
+static PyType_Slot Hamt_Type_Slots[] = {
+    {Py_tp_doc, (void *)hamt_doc},
+    {Py_tp_new, Hamt_new},
+    {Py_tp_dealloc, Hamt_dealloc},
+    {Py_tp_traverse, Hamt_traverse},
+    {Py_tp_clear, Hamt_clear},
+    {Py_tp_repr, Hamt_repr},
+    {Py_tp_iter, Hamt_iter},
+    {Py_tp_hash, Hamt_hash},
+    {Py_tp_richcompare, Hamt_richcompare},
+    {Py_tp_methods, Hamt_methods},
+    {Py_mp_length, Hamt_length},
+    {Py_mp_subscript, Hamt_subscript},
+    {Py_sq_contains, Hamt_contains},
+    {0, NULL},
+};
+
+static PyType_Spec Hamt_Type_Spec = {
+    .name = "fastcons.hamt",
+    .basicsize = sizeof(HamtObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC,
+    .slots = Hamt_Type_Slots,
+};
+
+/* Lifting and lowering
+
+   Both walk their input with an explicit stack of frames, one for each container being
+   converted, so nesting depth is limited by memory rather than the C stack. */
+
+/* How lift converts each kind of object */
+typedef enum {
+    LIFT_ATOM,      // returned as is
+    LIFT_SEQUENCE,  // lists and tuples, to cons lists
+    LIFT_ITERABLE,  // sets and iterators (including generators), to cons lists
+    LIFT_DICT,      // dicts, to association lists or maps
+} lift_kind;
+
+typedef struct {
+    lift_kind kind;
+    /* The container, or for LIFT_ITERABLE an iterator over it */
+    PyObject *src;
+    /* LIFT_SEQUENCE: the next index; LIFT_DICT: the PyDict_Next position */
+    Py_ssize_t pos;
+    /* LIFT_SEQUENCE: the length of the sequence when the frame started. Lifting its
+       items may run code that grows it, but the chunk only has room for this many. */
+    Py_ssize_t end;
+    /* LIFT_DICT: the value of the current item, waiting to be lifted */
+    PyObject *value;
+    /* LIFT_DICT: the lifted key of the current item, waiting for its value */
+    PyObject *key;
+    /* The result so far: for LIFT_DICT with hamt a map, and otherwise the items of a
+       list under construction, in a chunk with room for 'capacity' of them */
+    ChunkObject *chunk;
+    Py_ssize_t capacity;
+    HamtObject *map;
+    /* Whether src is in the set of containers being lifted, see lift */
+    bool active;
+} lift_frame;
+
+/* Containers nested deeper than this are checked for cycles. Structures this deep are
+   rare, so ordinary lifts don't pay for the check; a cycle is found a little way past
+   this depth. */
+#define LIFT_CYCLE_CHECK_DEPTH 1000
+
+static inline lift_kind
+lift_classify(PyObject *op)
+{
+    if (PyDict_Check(op))
+        return LIFT_DICT;
+    else if (PyList_Check(op) || PyTuple_Check(op))
+        return LIFT_SEQUENCE;
+    else if (PyAnySet_Check(op) || PyIter_Check(op))
+        return LIFT_ITERABLE;
+    return LIFT_ATOM;
+}
+
+/* Get a new reference to the next object to lift in a frame. Returns 1 if there is one,
+   0 if the frame is done, or -1 on error. */
+static int
+lift_next(lift_frame *frame, PyObject **child)
+{
+    switch (frame->kind) {
+    case LIFT_SEQUENCE:
+        /* A generator lifted from this list may have resized it */
+        if (frame->pos >= Py_MIN(frame->end, PySequence_Fast_GET_SIZE(frame->src)))
+            return 0;
+        *child = Py_NewRef(PySequence_Fast_GET_ITEM(frame->src, frame->pos++));
+        return 1;
+    case LIFT_ITERABLE:
+        *child = PyIter_Next(frame->src);
+        if (*child != NULL)
+            return 1;
+        return PyErr_Occurred() ? -1 : 0;
+    default: {
+        if (frame->value != NULL) {
+            *child = frame->value;
+            frame->value = NULL;
+            return 1;
+        }
+        PyObject *key, *value;
+        if (!PyDict_Next(frame->src, &frame->pos, &key, &value))
+            return 0;
+        frame->value = Py_NewRef(value);
+        *child = Py_NewRef(key);
+        return 1;
+    }
+    }
+}
+
+/* Add a lifted object to the frame's result, stealing the reference */
+static int
+lift_accept(consmodule_state *state, lift_frame *frame, PyObject *lifted)
+{
+    if (frame->kind != LIFT_DICT)
+        return chunk_append(&frame->chunk, &frame->capacity, lifted);
+    else if (frame->key == NULL) {
+        frame->key = lifted;
+        return 0;
+    }
+
+    PyObject *key = frame->key;
+    frame->key = NULL;
+    if (frame->map != NULL) {
+        Py_SETREF(frame->map, hamt_assoc(state, frame->map, key, lifted));
+        Py_DECREF(key);
+        Py_DECREF(lifted);
+        return frame->map == NULL ? -1 : 0;
+    }
+
+    PyObject *pair = Cons_NEW_PY(state);
+    if (pair == NULL) {
+        Py_DECREF(key);
+        Py_DECREF(lifted);
+        return -1;
+    }
+    SET_CAR(pair, key);
+    SET_CDR(pair, lifted);
+    SET_LENGTH(pair, cons_length_with_tail(state, lifted));
+    cons_track(state, pair);
+    return chunk_append(&frame->chunk, &frame->capacity, pair);
+}
+
+static void
+lift_frame_clear(PyObject *active, lift_frame *frame)
+{
+    if (frame->active) {
+        PyObject *id = PyLong_FromVoidPtr(frame->src);
+        if (id == NULL || PySet_Discard(active, id) < 0)
+            PyErr_Clear();
+        Py_XDECREF(id);
+    }
+    Py_CLEAR(frame->src);
+    Py_CLEAR(frame->chunk);
+    Py_CLEAR(frame->value);
+    Py_CLEAR(frame->key);
+    Py_CLEAR(frame->map);
+}
+
+/* Start a frame lifting op. 'active' is the set of ids of the containers being lifted,
+   created on first use. */
+static int
+lift_frame_init(consmodule_state *state, lift_frame *frame, PyObject *op, lift_kind kind,
+                bool use_hamt, Py_ssize_t depth, PyObject **active)
+{
+    frame->kind = kind;
+    frame->src = NULL;
+    frame->pos = 0;
+    frame->end = kind == LIFT_SEQUENCE ? PySequence_Fast_GET_SIZE(op) : 0;
+    frame->value = frame->key = NULL;
+    frame->chunk = NULL;
+    frame->capacity = 0;
+    frame->map = NULL;
+    frame->active = false;
+
+    /* Only mutable containers can be part of a cycle. Iterators are consumed as they're
+       lifted, so they can't produce themselves twice. */
+    if (depth >= LIFT_CYCLE_CHECK_DEPTH && kind != LIFT_ITERABLE) {
+        if (*active == NULL && (*active = PySet_New(NULL)) == NULL)
+            return -1;
+        PyObject *id = PyLong_FromVoidPtr(op);
+        if (id == NULL)
+            return -1;
+        int found = PySet_Contains(*active, id);
+        if (found == 0)
+            found = PySet_Add(*active, id);
+        Py_DECREF(id);
+        if (found != 0) {
+            if (found > 0)
+                PyErr_SetString(PyExc_ValueError, "cannot lift a recursive structure");
+            return -1;
+        }
+        frame->active = true;
+    }
+
+    if (kind == LIFT_ITERABLE) {
+        if ((frame->capacity = PyObject_LengthHint(op, 0)) < 0)
+            return -1;
+        frame->src = PyObject_GetIter(op);
+    }
+    else {
+        frame->capacity = kind == LIFT_SEQUENCE ? frame->end : PyDict_GET_SIZE(op);
+        frame->src = Py_NewRef(op);
+    }
+    if (frame->src == NULL)
+        return -1;
+    if (kind == LIFT_DICT && use_hamt)
+        return (frame->map = hamt_new_empty(state)) == NULL ? -1 : 0;
+    return (frame->chunk = chunk_new(state, frame->capacity)) == NULL ? -1 : 0;
+}
+
+/* The result of a finished frame, a new reference */
+static PyObject *
+lift_frame_finish(consmodule_state *state, lift_frame *frame)
+{
+    PyObject *result;
+    if (frame->map != NULL) {
+        result = (PyObject *)frame->map;
+        frame->map = NULL;
+    }
+    else {
+        result = cons_from_chunk(state, frame->chunk);
+        frame->chunk = NULL;
+    }
+    return result;
+}
+
+/* Recursively convert lists, tuples, sets, iterators and dicts in op to cons lists, and
+   dicts to association lists, or maps if use_hamt is true */
+static PyObject *
+lift(PyObject *op, consmodule_state *state, bool use_hamt)
+{
+    lift_kind kind = lift_classify(op);
+    if (kind == LIFT_ATOM)
+        return Py_NewRef(op);
+
+    lift_frame small[16];
+    lift_frame *frames = small;
+    Py_ssize_t depth = 0, capacity = Py_ARRAY_LENGTH(small);
+    PyObject *active = NULL, *result = NULL, *child = NULL;
+
+    if (lift_frame_init(state, &frames[depth++], op, kind, use_hamt, 0, &active) < 0)
+        goto error;
+    STAT_MAX(state, lift_max_depth, depth);
+
+    while (depth > 0) {
+        lift_frame *frame = &frames[depth - 1];
+
+        /* Fast path for runs of atoms in lists and tuples */
+        if (frame->kind == LIFT_SEQUENCE) {
+            PyObject **items = PySequence_Fast_ITEMS(frame->src);
+            Py_ssize_t pos = frame->pos;
+            Py_ssize_t end = Py_MIN(frame->end, PySequence_Fast_GET_SIZE(frame->src));
+            /* The chunk has room for every item up to end */
+            for (; pos < end && lift_classify(items[pos]) == LIFT_ATOM; pos++)
+                chunk_push(frame->chunk, Py_NewRef(items[pos]));
+            frame->pos = pos;
+        }
+
+        int more = lift_next(frame, &child);
+        if (more < 0)
+            goto error;
+        else if (!more) {
+            PyObject *lifted = lift_frame_finish(state, frame);
+            lift_frame_clear(active, frame);
+            depth--;
+            if (lifted == NULL)
+                goto error;
+            else if (depth == 0)
+                result = lifted;
+            else if (lift_accept(state, &frames[depth - 1], lifted) < 0)
+                goto error;
+            continue;
+        }
+
+        if ((kind = lift_classify(child)) == LIFT_ATOM) {
+            if (lift_accept(state, frame, child) < 0) {
+                child = NULL;
+                goto error;
+            }
+            child = NULL;
+            continue;
+        }
+
+        lift_frame *grown = framestack_reserve(frames, small, depth, &capacity, sizeof(lift_frame));
+        if (grown == NULL)
+            goto error;
+        frames = grown;
+        int err = lift_frame_init(state, &frames[depth], child, kind, use_hamt, depth, &active);
+        Py_CLEAR(child);
+        if (err < 0) {
+            lift_frame_clear(active, &frames[depth]);
+            goto error;
+        }
+        depth++;
+        STAT_MAX(state, lift_max_depth, depth);
+    }
+
+    Py_XDECREF(active);
+    if (frames != small)
+        PyMem_Free(frames);
+    return result;
+
+error:
+    Py_XDECREF(child);
+    while (depth > 0)
+        lift_frame_clear(active, &frames[--depth]);
+    Py_XDECREF(active);
+    if (frames != small)
+        PyMem_Free(frames);
+    return NULL;
+}
+
+/* How lower converts each kind of object */
+typedef enum {
+    LOWER_ERROR,  // lower_classify failed
+    LOWER_ATOM,   // returned as is
+    LOWER_LIST,   // proper cons lists, to lists or tuples
+    LOWER_ALIST,  // association lists, to dicts
+    LOWER_HAMT,   // maps, to dicts
+} lower_kind;
+
+typedef struct {
+    lower_kind kind;
+    /* LOWER_LIST and LOWER_ALIST: the walk over the list. Cells and maps are immutable,
+       so the structure being lowered (or the walk, for a chunk) keeps the items alive. */
+    conswalk walk;
+    /* LOWER_HAMT: the position in the map */
+    hamt_iterator it;
+    /* The list, tuple or dict being built */
+    PyObject *result;
+    /* LOWER_LIST: the next index into result */
+    Py_ssize_t i;
+    /* LOWER_ALIST and LOWER_HAMT: the key whose value is being lowered */
+    PyObject *key;
+} lower_frame;
+
+/* Is op an association list? That is, a proper list of pairs whose heads are hashable
+   and aren't themselves pairs or lists. Lists of lists of atoms look just like this,
+   which is why lower only checks when asked to. Returns 1 if so, 0 if not, or -1 if
+   hashing a key raised anything but TypeError. */
+static int
+lower_is_alist(consmodule_state *state, PyObject *op)
+{
+    PyTypeObject *cons = (PyTypeObject *)state->ConsType;
+    conswalk walk = CONSWALK_INIT(op);
+    PyObject *item;
+    int result = 1;
+    while (result > 0 && conswalk_next(state, &walk, &item) > 0) {
+        if (!Py_IS_TYPE(item, cons) || Py_IS_TYPE(CAR(item), cons) ||
+            Py_Is(CAR(item), state->nil))
+            result = 0;
+        else if (PyObject_Hash(CAR(item)) == -1) {
+            /* An unhashable key can't go in a dict, so this is a list after all */
+            result = PyErr_ExceptionMatches(PyExc_TypeError) ? 0 : -1;
+            if (result == 0)
+                PyErr_Clear();
+        }
+    }
+    conswalk_fini(&walk);
+    return result;
+}
+
+static lower_kind
+lower_classify(consmodule_state *state, PyObject *op, bool alists)
+{
+    if (Py_IS_TYPE(op, (PyTypeObject *)state->ConsType) && IS_LIST(op)) {
+        int is_alist = alists ? lower_is_alist(state, op) : 0;
+        return is_alist < 0 ? LOWER_ERROR : is_alist ? LOWER_ALIST : LOWER_LIST;
+    }
+    else if (Py_Is(op, state->nil))
+        return LOWER_LIST;
+    else if (Py_IS_TYPE(op, (PyTypeObject *)state->HamtType))
+        return LOWER_HAMT;
+    return LOWER_ATOM;
+}
+
+static int
+lower_frame_init(consmodule_state *state, lower_frame *frame, PyObject *op, lower_kind kind,
+                 bool tuples)
+{
+    frame->kind = kind;
+    frame->walk = (conswalk)CONSWALK_INIT(op);
+    frame->i = 0;
+    frame->key = NULL;
+    if (kind == LOWER_LIST) {
+        Py_ssize_t n = Py_Is(op, state->nil) ? 0 : LENGTH(op);
+        frame->result = tuples ? PyTuple_New(n) : PyList_New(n);
+    }
+    else {
+        if (kind == LOWER_HAMT)
+            hamt_iterator_init(&frame->it, ((HamtObject *)op)->root);
+        frame->result = PyDict_New();
+    }
+    return frame->result == NULL ? -1 : 0;
+}
+
+/* Get a borrowed reference to the next object to lower in a frame. Returns 1 if there
+   is one, 0 if the frame is done, or -1 on error. */
+static int
+lower_next(consmodule_state *state, lower_frame *frame, PyObject **child)
+{
+    PyObject *value;
+    switch (frame->kind) {
+    case LOWER_LIST:
+        return conswalk_next(state, &frame->walk, child);
+    case LOWER_ALIST: {
+        PyObject *pair;
+        while (conswalk_next(state, &frame->walk, &pair) > 0) {
+            /* The first pair for each key wins, as in assoc */
+            int seen = PyDict_Contains(frame->result, CAR(pair));
+            if (seen < 0)
+                return -1;
+            else if (!seen) {
+                frame->key = CAR(pair);
+                *child = cons_tail(pair);
+                return *child == NULL ? -1 : 1;
+            }
+        }
+        return 0;
+    }
+    default:
+        if (!hamt_iterator_next(&frame->it, &frame->key, &value))
+            return 0;
+        *child = value;
+        return 1;
+    }
+}
+
+/* Add a lowered object to the frame's result, stealing the reference */
+static int
+lower_accept(lower_frame *frame, PyObject *lowered)
+{
+    if (frame->kind != LOWER_LIST) {
+        int err = PyDict_SetItem(frame->result, frame->key, lowered);
+        Py_DECREF(lowered);
+        return err;
+    }
+    if (PyTuple_Check(frame->result))
+        PyTuple_SET_ITEM(frame->result, frame->i++, lowered);
+    else
+        PyList_SET_ITEM(frame->result, frame->i++, lowered);
+    return 0;
+}
+
+/* Recursively convert proper cons lists in op to lists (or tuples, if tuples is true),
+   and maps and association lists (if alists is true) to dicts */
+static PyObject *
+lower(PyObject *op, consmodule_state *state, bool tuples, bool alists)
+{
+    lower_kind kind = lower_classify(state, op, alists);
+    if (kind == LOWER_ERROR)
+        return NULL;
+    else if (kind == LOWER_ATOM)
+        return Py_NewRef(op);
+
+    lower_frame small[16];
+    lower_frame *frames = small;
+    Py_ssize_t depth = 0, capacity = Py_ARRAY_LENGTH(small);
+    PyObject *child;
+
+    if (lower_frame_init(state, &frames[depth++], op, kind, tuples) < 0)
+        goto error;
+
+    while (true) {
+        lower_frame *frame = &frames[depth - 1];
+        int more = lower_next(state, frame, &child);
+        if (more < 0)
+            goto error;
+        else if (!more) {
+            PyObject *lowered = frame->result;
+            conswalk_fini(&frame->walk);
+            depth--;
+            if (depth == 0) {
+                if (frames != small)
+                    PyMem_Free(frames);
+                return lowered;
+            }
+            else if (lower_accept(&frames[depth - 1], lowered) < 0)
+                goto error;
+            continue;
+        }
+
+        if ((kind = lower_classify(state, child, alists)) == LOWER_ERROR)
+            goto error;
+        else if (kind == LOWER_ATOM) {
+            if (lower_accept(frame, Py_NewRef(child)) < 0)
+                goto error;
+            continue;
+        }
+
+        lower_frame *grown =
+            framestack_reserve(frames, small, depth, &capacity, sizeof(lower_frame));
+        if (grown == NULL)
+            goto error;
+        frames = grown;
+        if (lower_frame_init(state, &frames[depth], child, kind, tuples) < 0)
+            goto error;
+        depth++;
+    }
+
+error:
+    while (depth > 0) {
+        depth--;
+        conswalk_fini(&frames[depth].walk);
+        Py_XDECREF(frames[depth].result);
+    }
+    if (frames != small)
+        PyMem_Free(frames);
+    return NULL;
+}
+
+/* Serialization
+
+   dumps writes a header followed by one value, each introduced by a tag byte:
+
+     'N'                          nil
+     'n', 't', 'f'                None, True, False
+     0x80 | i                     an int i from 0 to 127
+     'i' <varint i>               a larger int i that fits in 64 bits
+     'j' <varint i>               the negative int -1 - i, if it fits in 64 bits
+     'd' <8 bytes>                a float, IEEE 754 little endian
+     'u' <varint n> <n bytes>     a str, UTF-8 encoded
+     'y' <varint n> <n bytes>     bytes
+     'L' <varint n> <values>      a spine of n cells: their n heads, then the tail of
+                                  the last one
+     'M' <varint n> <values>      the same, for a spine whose first cell may be referred
+                                  to again; these are numbered in the order they start
+     'R' <varint i>               the i'th 'M' spine again
+     'P' <varint n> <n bytes>     anything else, pickled
+
+   Varints are unsigned LEB128. A spine ends early at a tail that is referenced from
+   elsewhere too, so only spines starting at cells with more than one reference need a
+   number; every other cell can only be reached once. Spines are written and read with
+   explicit stacks, so neither long lists nor deeply nested heads recurse. */
+
+#define SERIAL_MAGIC "FC\x01"
+#define SERIAL_MAGIC_SIZE 3
+
+typedef struct {
+    PyObject *out;  // bytes, over-allocated
+    Py_ssize_t size;
+    /* id of each numbered cell -> its number, created on first use */
+    PyObject *memo;
+    Py_ssize_t nmemo;
+    PyObject *pickle_dumps;
+    /* Per open spine: the walk over its heads, and how many are left */
+    conswalk *walks;
+    Py_ssize_t *remaining;
+    Py_ssize_t depth, capacity;
+} encoder;
+
+static char *
+encoder_reserve(encoder *enc, Py_ssize_t n)
+{
+    Py_ssize_t capacity = PyBytes_GET_SIZE(enc->out);
+    if (enc->size + n > capacity) {
+        if (capacity > (PY_SSIZE_T_MAX - n) / 2) {
+            PyErr_NoMemory();
+            return NULL;
+        }
+        if (_PyBytes_Resize(&enc->out, capacity * 2 + n) < 0)
+            return NULL;
+    }
+    char *p = PyBytes_AS_STRING(enc->out) + enc->size;
+    enc->size += n;
+    return p;
+}
+
+static int
+encoder_write(encoder *enc, const void *data, Py_ssize_t n)
+{
+    char *p = encoder_reserve(enc, n);
+    if (p == NULL)
+        return -1;
+    memcpy(p, data, (size_t)n);
+    return 0;
+}
+
+static int
+encoder_write_varint(encoder *enc, char tag, uint64_t value)
+{
+    unsigned char buf[11];
+    Py_ssize_t n = 0;
+    buf[n++] = (unsigned char)tag;
+    do {
+        buf[n] = value & 0x7f;
+        value >>= 7;
+        if (value)
+            buf[n] |= 0x80;
+        n++;
+    } while (value);
+    return encoder_write(enc, buf, n);
+}
+
+static int
+encoder_write_sized(encoder *enc, char tag, const char *data, Py_ssize_t n)
+{
+    if (encoder_write_varint(enc, tag, (uint64_t)n) < 0)
+        return -1;
+    return encoder_write(enc, data, n);
+}
+
+static int
+encoder_write_pickled(encoder *enc, PyObject *op)
+{
+    if (enc->pickle_dumps == NULL) {
+        PyObject *pickle = PyImport_ImportModule("pickle");
+        if (pickle == NULL)
+            return -1;
+        enc->pickle_dumps = PyObject_GetAttrString(pickle, "dumps");
+        Py_DECREF(pickle);
+        if (enc->pickle_dumps == NULL)
+            return -1;
+    }
+    PyObject *pickled = PyObject_CallOneArg(enc->pickle_dumps, op);
+    if (pickled == NULL)
+        return -1;
+    else if (!PyBytes_Check(pickled)) {
+        Py_DECREF(pickled);
+        PyErr_SetString(PyExc_TypeError, "pickle.dumps did not return bytes");
+        return -1;
+    }
+    int err = encoder_write_sized(enc, 'P', PyBytes_AS_STRING(pickled),
+                                  PyBytes_GET_SIZE(pickled));
+    Py_DECREF(pickled);
+    return err;
+}
+
+/* Write the tag and length of the spine starting at cell, and open it */
+static int
+encoder_start_spine(consmodule_state *state, encoder *enc, PyObject *cell)
+{
+    PyTypeObject *cons = Py_TYPE(cell);
+    bool shared = Py_REFCNT(cell) > 1;
+    if (shared) {
+        if (enc->memo == NULL && (enc->memo = PyDict_New()) == NULL)
+            return -1;
+        PyObject *id = PyLong_FromVoidPtr(cell);
+        if (id == NULL)
+            return -1;
+        PyObject *index = PyDict_GetItemWithError(enc->memo, id);
+        if (index != NULL) {
+            Py_DECREF(id);
+            return encoder_write_varint(enc, 'R', (uint64_t)PyLong_AsSsize_t(index));
+        }
+        PyObject *number = PyErr_Occurred() ? NULL : PyLong_FromSsize_t(enc->nmemo++);
+        int err = number == NULL ? -1 : PyDict_SetItem(enc->memo, id, number);
+        Py_DECREF(id);
+        Py_XDECREF(number);
+        if (err < 0)
+            return -1;
+    }
+
+    /* Find the end of the spine, forcing streams on the way. A chunk's items have no
+       cells to be shared, so the spine takes all of them. */
+    Py_ssize_t n = 1;
+    for (PyObject *op = cell;; n++) {
+        if (IS_CHUNKED(op)) {
+            n += LENGTH(op) - 1;
+            break;
+        }
+        else if ((op = cons_tail(op)) == NULL)
+            return -1;
+        else if (!Py_IS_TYPE(op, cons) || Py_REFCNT(op) > 1)
+            break;
+    }
+    if (encoder_write_varint(enc, shared ? 'M' : 'L', (uint64_t)n) < 0)
+        return -1;
+
+    if (enc->depth == enc->capacity) {
+        Py_ssize_t capacity = enc->capacity ? enc->capacity * 2 : 16;
+        conswalk *walks = PyMem_Realloc(enc->walks, (size_t)capacity * sizeof(conswalk));
+        if (walks != NULL)
+            enc->walks = walks;
+        Py_ssize_t *remaining =
+            PyMem_Realloc(enc->remaining, (size_t)capacity * sizeof(Py_ssize_t));
+        if (remaining != NULL)
+            enc->remaining = remaining;
+        if (walks == NULL || remaining == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        enc->capacity = capacity;
+    }
+    enc->walks[enc->depth] = (conswalk)CONSWALK_INIT(cell);
+    enc->remaining[enc->depth++] = n;
+    return 0;
+}
+
+/* Write op, or if it's a cons, start its spine */
+static int
+encoder_write_value(consmodule_state *state, encoder *enc, PyObject *op)
+{
+    if (Py_IS_TYPE(op, (PyTypeObject *)state->ConsType))
+        return encoder_start_spine(state, enc, op);
+    else if (Py_Is(op, state->nil))
+        return encoder_write(enc, "N", 1);
+    else if (Py_IsNone(op))
+        return encoder_write(enc, "n", 1);
+    else if (Py_IsTrue(op))
+        return encoder_write(enc, "t", 1);
+    else if (Py_IsFalse(op))
+        return encoder_write(enc, "f", 1);
+    else if (PyLong_CheckExact(op)) {
+        int overflow;
+        long long v = PyLong_AsLongLongAndOverflow(op, &overflow);
+        if (v == -1 && PyErr_Occurred())
+            return -1;
+        else if (!overflow && v >= 0 && v < 0x80) {
+            unsigned char small = (unsigned char)(0x80 | v);
+            return encoder_write(enc, &small, 1);
+        }
+        else if (!overflow)
+            return v >= 0 ? encoder_write_varint(enc, 'i', (uint64_t)v)
+                          : encoder_write_varint(enc, 'j', (uint64_t)(-1 - v));
+    }
+    else if (PyFloat_CheckExact(op)) {
+        char *p = encoder_reserve(enc, 9);
+        if (p == NULL)
+            return -1;
+        p[0] = 'd';
+        return PyFloat_Pack8(PyFloat_AS_DOUBLE(op), p + 1, 1);
+    }
+    else if (PyUnicode_CheckExact(op)) {
+        Py_ssize_t n;
+        const char *data = PyUnicode_AsUTF8AndSize(op, &n);
+        if (data != NULL)
+            return encoder_write_sized(enc, 'u', data, n);
+        /* Lone surrogates can't be encoded, but pickle copes */
+        PyErr_Clear();
+    }
+    else if (PyBytes_CheckExact(op))
+        return encoder_write_sized(enc, 'y', PyBytes_AS_STRING(op), PyBytes_GET_SIZE(op));
+    return encoder_write_pickled(enc, op);
+}
+
+static PyObject *
+serial_dumps(consmodule_state *state, PyObject *op)
+{
+    encoder enc = {0};
+    enc.out = PyBytes_FromStringAndSize(NULL, 256);
+    if (enc.out == NULL)
+        return NULL;
+    if (encoder_write(&enc, SERIAL_MAGIC, SERIAL_MAGIC_SIZE) < 0 ||
+        encoder_write_value(state, &enc, op) < 0)
+        goto error;
+
+    while (enc.depth > 0) {
+        Py_ssize_t top = enc.depth - 1;
+        conswalk *walk = &enc.walks[top];
+        if (enc.remaining[top] == 0) {
+            /* Close the spine before writing its tail, so a chain of spines doesn't
+               pile up on the stack. The tail isn't in a chunk, so needs no reference. */
+            PyObject *tail = walk->cell;
+            conswalk_fini(walk);
+            enc.depth--;
+            if (encoder_write_value(state, &enc, tail) < 0)
+                goto error;
+            continue;
+        }
+        /* The spine was forced when it was opened, so it can't end early or fail */
+        PyObject *head = NULL;
+        enc.remaining[top]--;
+        if (conswalk_next(state, walk, &head) <= 0) {
+            if (!PyErr_Occurred())
+                PyErr_SetString(PyExc_SystemError, "cons spine ended early in dumps");
+            goto error;
+        }
+        if (encoder_write_value(state, &enc, head) < 0)
+            goto error;
+    }
+
+    if (_PyBytes_Resize(&enc.out, enc.size) < 0)
+        goto error;
+    PyObject *result = enc.out;
+    enc.out = NULL;
+    Py_XDECREF(enc.memo);
+    Py_XDECREF(enc.pickle_dumps);
+    PyMem_Free(enc.walks);
+    PyMem_Free(enc.remaining);
+    return result;
+
+error:
+    while (enc.depth > 0)
+        conswalk_fini(&enc.walks[--enc.depth]);
+    Py_XDECREF(enc.out);
+    Py_XDECREF(enc.memo);
+    Py_XDECREF(enc.pickle_dumps);
+    PyMem_Free(enc.walks);
+    PyMem_Free(enc.remaining);
+    return NULL;
+}
+
+typedef struct {
+    const unsigned char *p;
+    const unsigned char *end;
+} decoder;
+
+static int
+serial_invalid(void)
+{
+    PyErr_SetString(PyExc_ValueError, "invalid or truncated fastcons data");
+    return -1;
+}
+
+static int
+decoder_read_varint(decoder *dec, uint64_t *value)
+{
+    *value = 0;
+    for (unsigned shift = 0; dec->p < dec->end && shift < 64; shift += 7) {
+        unsigned char byte = *dec->p++;
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return 0;
+    }
+    return serial_invalid();
+}
+
+/* Read a varint giving the size of something still to come, checking there's at least
+   that much data left */
+static int
+decoder_read_size(decoder *dec, Py_ssize_t *n)
+{
+    uint64_t value;
+    if (decoder_read_varint(dec, &value) < 0)
+        return -1;
+    else if (value > (uint64_t)(dec->end - dec->p))
+        return serial_invalid();
+    *n = (Py_ssize_t)value;
+    return 0;
+}
+
+/* Read one atom or back-reference */
+static PyObject *
+decoder_read_atom(consmodule_state *state, decoder *dec, char tag, PyObject *memo,
+                  PyObject **pickle_loads)
+{
+    uint64_t value;
+    Py_ssize_t n;
+    const char *data;
+    switch (tag) {
+    case 'N':
+        return Py_NewRef(state->nil);
+    case 'n':
+        Py_RETURN_NONE;
+    case 't':
+        Py_RETURN_TRUE;
+    case 'f':
+        Py_RETURN_FALSE;
+    case 'i':
+        if (decoder_read_varint(dec, &value) < 0)
+            return NULL;
+        return PyLong_FromUnsignedLongLong(value);
+    case 'j':
+        if (decoder_read_varint(dec, &value) < 0)
+            return NULL;
+        else if (value > (uint64_t)LLONG_MAX) {
+            serial_invalid();
+            return NULL;
+        }
+        return PyLong_FromLongLong(-1 - (long long)value);
+    case 'd':
+        if (dec->end - dec->p < 8) {
+            serial_invalid();
+            return NULL;
+        }
+        dec->p += 8;
+        double d = PyFloat_Unpack8((const char *)dec->p - 8, 1);
+        return d == -1.0 && PyErr_Occurred() ? NULL : PyFloat_FromDouble(d);
+    case 'u':
+    case 'y':
+    case 'P':
+        if (decoder_read_size(dec, &n) < 0)
+            return NULL;
+        data = (const char *)dec->p;
+        dec->p += n;
+        if (tag == 'u')
+            return PyUnicode_DecodeUTF8(data, n, "strict");
+        else if (tag == 'y')
+            return PyBytes_FromStringAndSize(data, n);
+        if (*pickle_loads == NULL) {
+            PyObject *pickle = PyImport_ImportModule("pickle");
+            if (pickle == NULL)
+                return NULL;
+            *pickle_loads = PyObject_GetAttrString(pickle, "loads");
+            Py_DECREF(pickle);
+            if (*pickle_loads == NULL)
+                return NULL;
+        }
+        PyObject *pickled = PyBytes_FromStringAndSize(data, n);
+        if (pickled == NULL)
+            return NULL;
+        PyObject *result = PyObject_CallOneArg(*pickle_loads, pickled);
+        Py_DECREF(pickled);
+        return result;
+    case 'R':
+        if (decoder_read_varint(dec, &value) < 0)
+            return NULL;
+        /* Spines can't contain themselves, so a reference to one that isn't finished
+           yet is as invalid as one to a spine that doesn't exist */
+        if (value >= (uint64_t)PyList_GET_SIZE(memo) ||
+            Py_IsNone(PyList_GET_ITEM(memo, (Py_ssize_t)value))) {
+            serial_invalid();
+            return NULL;
+        }
+        return Py_NewRef(PyList_GET_ITEM(memo, (Py_ssize_t)value));
+    default:
+        if ((unsigned char)tag & 0x80)
+            return PyLong_FromLong((unsigned char)tag & 0x7f);
+        serial_invalid();
+        return NULL;
+    }
+}
+
+/* An open spine: its items start at 'base' on the value stack */
+typedef struct {
+    Py_ssize_t base;
+    Py_ssize_t n;
+    /* Its number if it was written with 'M', or -1 */
+    Py_ssize_t number;
+} decoder_frame;
+
+static PyObject *
+serial_loads(consmodule_state *state, const char *data, Py_ssize_t size)
+{
+    if (size < SERIAL_MAGIC_SIZE || memcmp(data, SERIAL_MAGIC, SERIAL_MAGIC_SIZE) != 0) {
+        PyErr_SetString(PyExc_ValueError, "not fastcons data");
+        return NULL;
+    }
+    decoder dec = {(const unsigned char *)data + SERIAL_MAGIC_SIZE,
+                   (const unsigned char *)data + size};
+
+    /* Values are pushed onto 'values' as they're read; once a spine has all its items
+       and its tail, they're replaced with its first cell */
+    PyObject **values = NULL;
+    decoder_frame *frames = NULL;
+    Py_ssize_t nvalues = 0, values_capacity = 0, depth = 0, frames_capacity = 0;
+    PyObject *memo = PyList_New(0), *pickle_loads = NULL, *result = NULL;
+    if (memo == NULL)
+        return NULL;
+
+    do {
+        if (dec.p == dec.end) {
+            serial_invalid();
+            goto done;
+        }
+        char tag = (char)*dec.p++;
+        if (tag == 'L' || tag == 'M') {
+            Py_ssize_t n;
+            if (decoder_read_size(&dec, &n) < 0)
+                goto done;
+            else if (n == 0) {
+                serial_invalid();
+                goto done;
+            }
+            if (depth == frames_capacity) {
+                frames_capacity = frames_capacity ? frames_capacity * 2 : 16;
+                decoder_frame *grown = PyMem_Realloc(
+                    frames, (size_t)frames_capacity * sizeof(decoder_frame));
+                if (grown == NULL) {
+                    PyErr_NoMemory();
+                    goto done;
+                }
+                frames = grown;
+            }
+            Py_ssize_t number = -1;
+            if (tag == 'M') {
+                number = PyList_GET_SIZE(memo);
+                if (PyList_Append(memo, Py_None) < 0)
+                    goto done;
+            }
+            frames[depth++] = (decoder_frame){nvalues, n, number};
+            continue;
+        }
+
+        PyObject *value = decoder_read_atom(state, &dec, tag, memo, &pickle_loads);
+        if (value == NULL)
+            goto done;
+        /* Close every spine this value completes */
+        for (;;) {
+            if (nvalues == values_capacity) {
+                values_capacity = values_capacity ? values_capacity * 2 : 64;
+                PyObject **grown =
+                    PyMem_Realloc(values, (size_t)values_capacity * sizeof(PyObject *));
+                if (grown == NULL) {
+                    Py_DECREF(value);
+                    PyErr_NoMemory();
+                    goto done;
+                }
+                values = grown;
+            }
+            values[nvalues++] = value;
+            if (depth == 0)
+                break;
+            decoder_frame *frame = &frames[depth - 1];
+            if (nvalues < frame->base + frame->n + 1)
+                break;
+
+            /* The last value is the tail */
+            nvalues = frame->base;
+            value = cons_from_spine(state, values + frame->base, frame->n,
+                                    values[frame->base + frame->n]);
+            if (value == NULL)
+                goto done;
+            if (frame->number >= 0 &&
+                PyList_SetItem(memo, frame->number, Py_NewRef(value)) < 0) {
+                Py_DECREF(value);
+                goto done;
+            }
+            depth--;
+        }
+    } while (depth > 0);
+
+    if (dec.p != dec.end)
+        serial_invalid();
+    else {
+        result = values[0];
+        nvalues = 0;
+    }
+
+done:
+    while (nvalues > 0)
+        Py_DECREF(values[--nvalues]);
+    PyMem_Free(values);
+    PyMem_Free(frames);
+    Py_DECREF(memo);
+    Py_XDECREF(pickle_loads);
+    return result;
+}
+
+/* module level functions */
+PyDoc_STRVAR(consmodule_assoc_doc,
+             "assoc(object, alist, *, indexed=False)\n\
+\n\
+Return the first pair in alist whose car is equal to object. Return\n\
+nil() if object is not found.\n\
+\n\
+If 'indexed' is true, the first call builds a hash index of alist's keys and\n\
+keeps it with the list, making this and later indexed lookups O(1). Lists\n\
+with unhashable keys are searched linearly.");
+
+/* Build the index of the first pair for each key of alist. Returns a new reference to
+   the index, Py_None if a key is unhashable, or NULL on error. */
+static PyObject *
+assoc_build_index(consmodule_state *state, PyObject *alist)
+{
+    PyObject *index = PyDict_New();
+    if (index == NULL)
+        return NULL;
+
+    conswalk walk = CONSWALK_INIT(alist);
+    PyObject *pair;
+    while (conswalk_next(state, &walk, &pair) > 0) {
+        if (!Py_IS_TYPE(pair, (PyTypeObject *)state->ConsType)) {
+            PyErr_SetString(PyExc_ValueError,
+                            "'alist' is not a properly formed association list");
+            goto error;
+        }
+        /* Keep the first pair for each key */
+        PyObject *found = PyDict_SetDefault(index, CAR(pair), pair);
+        if (found == NULL) {
+            if (!PyErr_ExceptionMatches(PyExc_TypeError))
+                goto error;
+            PyErr_Clear();
+            conswalk_fini(&walk);
+            Py_DECREF(index);
+            Py_RETURN_NONE;
+        }
+    }
+    conswalk_fini(&walk);
+    return index;
+
+error:
+    conswalk_fini(&walk);
+    Py_DECREF(index);
+    return NULL;
+}
+
+/* Look object up in the cached index of alist. Returns a new reference to the pair or
+   nil, or NULL with no exception set if the index can't be used. */
+static PyObject *
+assoc_indexed(consmodule_state *state, PyObject *object, PyObject *alist)
+{
+    ConsCacheObject *cache = cons_get_cache(state, alist);
+    if (cache == NULL)
+        return NULL;
+    /* The index is set once, by whichever thread finishes building one first. Keys'
+       __hash__ and __eq__ may also have run an indexed assoc on this list already. */
+    PyObject *index;
+    Py_BEGIN_CRITICAL_SECTION(cache);
+    index = Py_XNewRef(cache->assoc_index);
+    Py_END_CRITICAL_SECTION();
+    if (index == NULL) {
+        if ((index = assoc_build_index(state, alist)) == NULL)
+            return NULL;
+        Py_BEGIN_CRITICAL_SECTION(cache);
+        if (cache->assoc_index == NULL)
+            cache->assoc_index = Py_NewRef(index);
+        else
+            Py_SETREF(index, Py_NewRef(cache->assoc_index));
+        Py_END_CRITICAL_SECTION();
+    }
+
+    PyObject *pair = NULL;
+    if (!Py_IsNone(index)) {
+        pair = PyDict_GetItemWithError(index, object);
+        if (pair != NULL)
+            pair = Py_NewRef(pair);
+        else if (!PyErr_Occurred())
+            pair = Py_NewRef(state->nil);
+        else if (PyErr_ExceptionMatches(PyExc_TypeError))
+            /* object is unhashable, but may still compare equal to a key */
+            PyErr_Clear();
+    }
+    Py_DECREF(index);
+    return pair;
+}
+
+PyObject *
+consmodule_assoc(PyObject *module, PyObject *const *args, Py_ssize_t nargs,
+                 PyObject *kwnames)
+{
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_TypeError, "assoc requires exactly two positional arguments");
+        return NULL;
+    }
+    PyObject *object = args[0];
+    PyObject *alist = args[1];
+
+    static const char *const kwlist[] = {"indexed", NULL};
+    PyObject *kwvalues[] = {NULL};
+    if (parse_kwargs(args, nargs, kwnames, "assoc", kwlist, kwvalues) < 0)
+        return NULL;
+    int indexed = kwvalues[0] == NULL ? 0 : PyObject_IsTrue(kwvalues[0]);
+    if (indexed < 0)
+        return NULL;
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    STAT_INC(state, assoc_calls);
+
+    if (Py_Is(alist, state->nil)) {
+        Py_INCREF(state->nil);
+        return state->nil;
+    }
+    else if (!Py_IS_TYPE(alist, (PyTypeObject *)state->ConsType) || !IS_LIST(alist)) {
+        PyErr_SetString(
+            PyExc_ValueError,
+            "argument 'alist' to assoc must be a cons list of cons pairs, or nil()");
+        return NULL;
+    }
+
+    if (indexed) {
+        PyObject *result = assoc_indexed(state, object, alist);
+        if (result != NULL || PyErr_Occurred()) {
+            STAT_INC(state, assoc_probes);
+            return result;
+        }
+    }
+
+    conswalk walk = CONSWALK_INIT(alist);
+    PyObject *pair, *result = state->nil;
+    while (conswalk_next(state, &walk, &pair) > 0) {
+        if (!Py_IS_TYPE(pair, (PyTypeObject *)state->ConsType)) {
+            PyErr_SetString(PyExc_ValueError,
+                            "'alist' is not a properly formed association list");
+            result = NULL;
+            break;
+        }
+        STAT_INC(state, assoc_probes);
+        int cmp = PyObject_RichCompareBool(object, CAR(pair), Py_EQ);
+        if (cmp != 0) {
+            result = cmp < 0 ? NULL : pair;
+            break;
+        }
+    }
+    conswalk_fini(&walk);
+    return Py_XNewRef(result);
+}
+
+/* Check that op is nil() or a proper cons list, for functions taking a list argument */
+static int
+check_list_arg(consmodule_state *state, PyObject *op, const char *func, const char *arg)
+{
+    if (Py_Is(op, state->nil) || (Py_IS_TYPE(op, (PyTypeObject *)state->ConsType) && IS_LIST(op)))
+        return 0;
+    PyErr_Format(PyExc_ValueError, "argument '%s' to %s must be a proper cons list, or nil()",
+                 arg, func);
+    return -1;
+}
+
+static int
+check_callable_arg(PyObject *op, const char *func, const char *arg)
+{
+    if (PyCallable_Check(op))
+        return 0;
+    PyErr_Format(PyExc_TypeError, "argument '%s' to %s must be callable", arg, func);
+    return -1;
+}
+
+/* Native predicates
+
+   Predicates built by the predicate type's factories test an object in C, so assp and
+   filter can run a whole scan without calling back into Python. They're also ordinary
+   callables, usable anywhere a predicate function is. */
+typedef enum {
+    PREDICATE_IS_IN,
+    PREDICATE_IS_INSTANCE,
+    PREDICATE_STARTS_WITH,
+} predicate_kind;
+
+typedef struct {
+    PyObject_HEAD
+    predicate_kind kind;
+    /* PREDICATE_IS_IN: a frozenset of keys
+       PREDICATE_IS_INSTANCE: a type, or tuple of types
+       PREDICATE_STARTS_WITH: a str, or tuple of str */
+    PyObject *arg;
+    vectorcallfunc vectorcall;
+} PredicateObject;
+
+/* Returns 1 if op satisfies the predicate, 0 if it doesn't, or -1 on error */
+static int
+predicate_test(PredicateObject *pred, PyObject *op)
+{
+    switch (pred->kind) {
+    case PREDICATE_IS_IN:
+        return PySet_Contains(pred->arg, op);
+    case PREDICATE_IS_INSTANCE:
+        return PyObject_IsInstance(op, pred->arg);
+    default:
+        if (!PyUnicode_Check(op))
+            return 0;
+        if (PyUnicode_Check(pred->arg))
+            return (int)PyUnicode_Tailmatch(op, pred->arg, 0, PY_SSIZE_T_MAX, -1);
+        for (Py_ssize_t i = 0; i < PyTuple_GET_SIZE(pred->arg); i++) {
+            Py_ssize_t match =
+                PyUnicode_Tailmatch(op, PyTuple_GET_ITEM(pred->arg, i), 0, PY_SSIZE_T_MAX, -1);
+            if (match != 0)
+                return (int)match;
+        }
+        return 0;
+    }
+}
+
+/* Call a predicate on op: returns 1 if the result is truthy, 0 if not, or -1 on error */
+static int
+call_predicate(consmodule_state *state, PyObject *predicate, PyObject *op)
+{
+    if (Py_IS_TYPE(predicate, (PyTypeObject *)state->PredicateType))
+        return predicate_test((PredicateObject *)predicate, op);
+
+    PyObject *callargs[2] = {NULL, op};
+    PyObject *result =
+        PyObject_Vectorcall(predicate, callargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+    if (result == NULL)
+        return -1;
+    int truth = PyObject_IsTrue(result);
+    Py_DECREF(result);
+    return truth;
+}
+
+static PyObject *
+Predicate_vectorcall(PyObject *self, PyObject *const *args, size_t nargsf, PyObject *kwnames)
+{
+    Py_ssize_t nargs = PyVectorcall_NARGS(nargsf);
+    if (nargs != 1 || (kwnames != NULL && PyTuple_GET_SIZE(kwnames) != 0)) {
+        PyErr_SetString(PyExc_TypeError, "predicate takes exactly one positional argument");
+        return NULL;
+    }
+    int truth = predicate_test((PredicateObject *)self, args[0]);
+    if (truth < 0)
+        return NULL;
+    return PyBool_FromLong(truth);
+}
+
+static PyObject *
+predicate_new(PyTypeObject *type, predicate_kind kind, PyObject *arg)
+{
+    PredicateObject *pred = PyObject_GC_New(PredicateObject, type);
+    if (pred == NULL) {
+        Py_DECREF(arg);
+        return NULL;
+    }
+    pred->kind = kind;
+    pred->arg = arg;
+    pred->vectorcall = Predicate_vectorcall;
+    PyObject_GC_Track(pred);
+    return (PyObject *)pred;
+}
+
+/* Check that op is an instance of type, or a non-empty tuple of them */
+static int
+check_predicate_arg(PyObject *op, PyTypeObject *type, const char *func, const char *what)
+{
+    if (PyObject_TypeCheck(op, type))
+        return 0;
+    else if (PyTuple_Check(op) && PyTuple_GET_SIZE(op) > 0) {
+        Py_ssize_t i = 0;
+        for (; i < PyTuple_GET_SIZE(op); i++)
+            if (!PyObject_TypeCheck(PyTuple_GET_ITEM(op, i), type))
+                break;
+        if (i == PyTuple_GET_SIZE(op))
+            return 0;
+    }
+    PyErr_Format(PyExc_TypeError, "predicate.%s() argument must be %s, or a tuple of them",
+                 func, what);
+    return -1;
+}
+
+static PyObject *
+Predicate_is_in(PyTypeObject *type, PyObject *keys)
+{
+    PyObject *arg = PyFrozenSet_New(keys);
+    if (arg == NULL)
+        return NULL;
+    return predicate_new(type, PREDICATE_IS_IN, arg);
+}
+
+static PyObject *
+Predicate_is_instance(PyTypeObject *type, PyObject *types)
+{
+    if (check_predicate_arg(types, &PyType_Type, "is_instance", "a type") < 0)
+        return NULL;
+    return predicate_new(type, PREDICATE_IS_INSTANCE, Py_NewRef(types));
+}
+
+static PyObject *
+Predicate_starts_with(PyTypeObject *type, PyObject *prefix)
+{
+    if (check_predicate_arg(prefix, &PyUnicode_Type, "starts_with", "a str") < 0)
+        return NULL;
+    return predicate_new(type, PREDICATE_STARTS_WITH, Py_NewRef(prefix));
+}
+
+static int
+Predicate_traverse(PredicateObject *self, visitproc visit, void *arg)
+{
+    Py_VISIT(Py_TYPE(self));
+    Py_VISIT(self->arg);
+    return 0;
+}
+
+static int
+Predicate_clear(PredicateObject *self)
+{
+    Py_CLEAR(self->arg);
+    return 0;
+}
+
+static void
+Predicate_dealloc(PredicateObject *self)
+{
+    PyTypeObject *tp = Py_TYPE(self);
+    PyObject_GC_UnTrack(self);
+    Predicate_clear(self);
+    PyObject_GC_Del(self);
+    Py_DECREF(tp);
+}
+
+static PyObject *
+Predicate_repr(PredicateObject *self)
+{
+    static const char *const names[] = {"is_in", "is_instance", "starts_with"};
+    return PyUnicode_FromFormat("predicate.%s(%R)", names[self->kind], self->arg);
+}
+
+PyDoc_STRVAR(Predicate_is_in_doc, "is_in(keys, /)\n\
+\n\
+Return a predicate that tests whether an object is equal to any of 'keys',\n\
+like 'lambda x: x in frozenset(keys)'.");
+PyDoc_STRVAR(Predicate_is_instance_doc, "is_instance(types, /)\n\
+\n\
+Return a predicate that tests whether an object is an instance of 'types', a\n\
+type or tuple of types, like 'lambda x: isinstance(x, types)'.");
+PyDoc_STRVAR(Predicate_starts_with_doc, "starts_with(prefix, /)\n\
+\n\
+Return a predicate that tests whether an object is a str starting with\n\
+'prefix', a str or tuple of str. Objects that aren't str never match.");
+
+static PyMethodDef Predicate_methods[] = {
+    {"is_in", (PyCFunction)Predicate_is_in, METH_O | METH_CLASS, Predicate_is_in_doc},
+    {"is_instance", (PyCFunction)Predicate_is_instance, METH_O | METH_CLASS,
+     Predicate_is_instance_doc},
+    {"starts_with", (PyCFunction)Predicate_starts_with, METH_O | METH_CLASS,
+     Predicate_starts_with_doc},
+    {NULL, NULL},
+};
+
+static PyMemberDef Predicate_members[] = {
+    {"__vectorcalloffset__", Py_T_PYSSIZET, offsetof(PredicateObject, vectorcall), Py_READONLY,
+     NULL},
+    {NULL},
+};
+
+PyDoc_STRVAR(predicate_doc, "A predicate evaluated natively by assp and filter.\n\
+\n\
+Create one with predicate.is_in, predicate.is_instance or predicate.starts_with.");
+
+static PyType_Slot Predicate_Type_Slots[] = {
+    {Py_tp_doc, (void *)predicate_doc},
+    {Py_tp_dealloc, Predicate_dealloc},
+    {Py_tp_traverse, Predicate_traverse},
+    {Py_tp_clear, Predicate_clear},
+    {Py_tp_repr, Predicate_repr},
+    {Py_tp_call, PyVectorcall_Call},
+    {Py_tp_methods, Predicate_methods},
+    {Py_tp_members, Predicate_members},
+    {0, NULL},
+};
+
+static PyType_Spec Predicate_Type_Spec = {
+    .name = "fastcons.predicate",
+    .basicsize = sizeof(PredicateObject),
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
+             Py_TPFLAGS_HAVE_VECTORCALL | Py_TPFLAGS_DISALLOW_INSTANTIATION,
+    .slots = Predicate_Type_Slots,
+};
+
+PyDoc_STRVAR(consmodule_assp_doc,
+             "assp(predicate, alist)\n\
+\n\
+Return the first pair in alist for which the result of calling 'predicate'\n\
+on its car is truthy.\n\
+\n\
+'predicate' may be any callable that takes a single argument. Predicates made\n\
+by the predicate type's factories are evaluated without calling into Python.");
+
+PyObject *
+consmodule_assp(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_TypeError, "assp requires exactly two positional arguments");
+        return NULL;
+    }
+    PyObject *predicate = args[0];
+    PyObject *alist = args[1];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    STAT_INC(state, assp_calls);
+
+    if (check_callable_arg(predicate, "assp", "predicate") < 0)
+        return NULL;
+    else if (Py_Is(alist, state->nil)) {
+        Py_INCREF(state->nil);
+        return state->nil;
+    }
+    else if (!Py_IS_TYPE(alist, (PyTypeObject *)state->ConsType) || !IS_LIST(alist)) {
+        PyErr_SetString(
+            PyExc_ValueError,
+            "argument 'alist' to assp must be a cons list of cons pairs, or nil()");
+        return NULL;
+    }
+
+    conswalk walk = CONSWALK_INIT(alist);
+    PyObject *pair, *result = state->nil;
+    while (conswalk_next(state, &walk, &pair) > 0) {
+        if (!Py_IS_TYPE(pair, (PyTypeObject *)state->ConsType)) {
+            PyErr_SetString(PyExc_ValueError,
+                            "'alist' is not a properly formed association list");
+            result = NULL;
+            break;
+        }
+        STAT_INC(state, assp_probes);
+        int truth = call_predicate(state, predicate, CAR(pair));
+        if (truth != 0) {
+            result = truth < 0 ? NULL : pair;
+            break;
+        }
+    }
+    conswalk_fini(&walk);
+    return Py_XNewRef(result);
+}
+
+PyDoc_STRVAR(consmodule_map_doc,
+             "map(function, xs)\n\
+\n\
+Return a new list of the results of calling 'function' on each element of the\n\
+proper list xs.");
+
+PyObject *
+consmodule_map(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_TypeError, "map requires exactly two positional arguments");
+        return NULL;
+    }
+    PyObject *function = args[0];
+    PyObject *xs = args[1];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_callable_arg(function, "map", "function") < 0 ||
+        check_list_arg(state, xs, "map", "xs") < 0)
+        return NULL;
+    if (Py_Is(xs, state->nil))
+        return Py_NewRef(state->nil);
+
+    /* The result has the same length as xs, so its items can be collected in a chunk */
+    ChunkObject *chunk = chunk_new(state, LENGTH(xs));
+    if (chunk == NULL)
+        return NULL;
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *item;
+    while (conswalk_next(state, &walk, &item) > 0) {
+        PyObject *callargs[2] = {NULL, item};
+        PyObject *result = PyObject_Vectorcall(
+            function, callargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+        if (result == NULL) {
+            conswalk_fini(&walk);
+            Py_DECREF(chunk);
+            return NULL;
+        }
+        chunk_push(chunk, result);
+    }
+    conswalk_fini(&walk);
+    return cons_from_chunk(state, chunk);
+}
+
+PyDoc_STRVAR(consmodule_filter_doc,
+             "filter(predicate, xs)\n\
+\n\
+Return a new list of the elements of the proper list xs for which the result\n\
+of calling 'predicate' is truthy.");
+
+PyObject *
+consmodule_filter(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_TypeError, "filter requires exactly two positional arguments");
+        return NULL;
+    }
+    PyObject *predicate = args[0];
+    PyObject *xs = args[1];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_callable_arg(predicate, "filter", "predicate") < 0 ||
+        check_list_arg(state, xs, "filter", "xs") < 0)
+        return NULL;
+
+    consbuilder builder = CONSBUILDER_INIT;
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *item;
+    while (conswalk_next(state, &walk, &item) > 0) {
+        int truth = call_predicate(state, predicate, item);
+        if (truth < 0)
+            goto error;
+        else if (truth && consbuilder_append(state, &builder, Py_NewRef(item)) < 0)
+            goto error;
+    }
+    conswalk_fini(&walk);
+    return consbuilder_finish(state, &builder);
+
+error:
+    conswalk_fini(&walk);
+    consbuilder_abort(&builder);
+    return NULL;
+}
+
+PyDoc_STRVAR(consmodule_foldl_doc,
+             "foldl(function, initial, xs)\n\
+\n\
+Reduce the proper list xs from the left: call 'function' with the accumulated\n\
+value (starting with 'initial') and each element in turn, as\n\
+function(acc, x), and return the final accumulated value.");
+
+PyObject *
+consmodule_foldl(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 3) {
+        PyErr_SetString(PyExc_TypeError, "foldl requires exactly three positional arguments");
+        return NULL;
+    }
+    PyObject *function = args[0];
+    PyObject *xs = args[2];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_callable_arg(function, "foldl", "function") < 0 ||
+        check_list_arg(state, xs, "foldl", "xs") < 0)
+        return NULL;
+
+    PyObject *acc = Py_NewRef(args[1]), *item;
+    conswalk walk = CONSWALK_INIT(xs);
+    while (acc != NULL && conswalk_next(state, &walk, &item) > 0) {
+        PyObject *callargs[3] = {NULL, acc, item};
+        PyObject *result = PyObject_Vectorcall(
+            function, callargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+        Py_DECREF(acc);
+        acc = result;
+    }
+    conswalk_fini(&walk);
+    return acc;
+}
+
+PyDoc_STRVAR(consmodule_foldr_doc,
+             "foldr(function, initial, xs)\n\
+\n\
+Reduce the proper list xs from the right: call 'function' with each element,\n\
+last to first, and the accumulated value (starting with 'initial'), as\n\
+function(x, acc), and return the final accumulated value.");
+
+PyObject *
+consmodule_foldr(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 3) {
+        PyErr_SetString(PyExc_TypeError, "foldr requires exactly three positional arguments");
+        return NULL;
+    }
+    PyObject *function = args[0];
+    PyObject *xs = args[2];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_callable_arg(function, "foldr", "function") < 0 ||
+        check_list_arg(state, xs, "foldr", "xs") < 0)
+        return NULL;
+
+    /* Walk the list once to stack up its items, then fold while popping them. The walk
+       keeps a chunk's items alive until it's released. */
+    ptrstack items;
+    ptrstack_init(&items);
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *item, *acc = NULL;
+    while (conswalk_next(state, &walk, &item) > 0) {
+        if (ptrstack_push(&items, item) < 0)
+            goto done;
+    }
+
+    acc = Py_NewRef(args[1]);
+    while (acc != NULL && items.size > 0) {
+        PyObject *callargs[3] = {NULL, ptrstack_pop(&items), acc};
+        PyObject *result = PyObject_Vectorcall(
+            function, callargs + 1, 2 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+        Py_DECREF(acc);
+        acc = result;
+    }
+
+done:
+    conswalk_fini(&walk);
+    ptrstack_fini(&items);
+    return acc;
+}
+
+/* Numeric reductions
+
+   Following builtin_sum in bltinmodule.c, exact ints are added as C longs until one
+   would overflow, and floats (and ints, once the sum is a float) as C doubles with
+   Neumaier's compensated summation, so no partial sum is boxed and the results match
+   the builtin's. Anything else, or a sum that no longer fits, goes through the number
+   protocol. */
+
+/* Add the rest of the walk's items to result, stealing the reference to it */
+static PyObject *
+cons_sum(consmodule_state *state, conswalk *walk, PyObject *result)
+{
+    PyObject *item;
+    if (PyLong_CheckExact(result)) {
+        int overflow;
+        long i_result = PyLong_AsLongAndOverflow(result, &overflow);
+        /* If start already overflowed, don't even enter the loop */
+        if (overflow == 0)
+            Py_CLEAR(result);
+        while (result == NULL) {
+            if (conswalk_next(state, walk, &item) <= 0)
+                return PyLong_FromLong(i_result);
+            if (PyLong_CheckExact(item) || PyBool_Check(item)) {
+                long b = PyLong_AsLongAndOverflow(item, &overflow);
+                if (overflow == 0 &&
+                    (i_result >= 0 ? b <= LONG_MAX - i_result : b >= LONG_MIN - i_result)) {
+                    i_result += b;
+                    continue;
+                }
+            }
+            /* Either overflowed or isn't an int: carry on with objects */
+            if ((result = PyLong_FromLong(i_result)) == NULL)
+                return NULL;
+            Py_SETREF(result, PyNumber_Add(result, item));
+            if (result == NULL)
+                return NULL;
+        }
+    }
+
+    if (PyFloat_CheckExact(result)) {
+        double f_result = PyFloat_AS_DOUBLE(result), c = 0.0;
+        Py_CLEAR(result);
+        while (result == NULL) {
+            if (conswalk_next(state, walk, &item) <= 0) {
+                /* Don't let the compensation turn an infinite sum into a NaN */
+                if (c && Py_IS_FINITE(c))
+                    f_result += c;
+                return PyFloat_FromDouble(f_result);
+            }
+            if (PyFloat_CheckExact(item)) {
+                double x = PyFloat_AS_DOUBLE(item), t = f_result + x;
+                if (fabs(f_result) >= fabs(x))
+                    c += (f_result - t) + x;
+                else
+                    c += (x - t) + f_result;
+                f_result = t;
+                continue;
+            }
+            if (PyLong_Check(item)) {
+                int overflow;
+                long value = PyLong_AsLongAndOverflow(item, &overflow);
+                if (!overflow) {
+                    f_result += (double)value;
+                    continue;
+                }
+            }
+            if (c && Py_IS_FINITE(c))
+                f_result += c;
+            if ((result = PyFloat_FromDouble(f_result)) == NULL)
+                return NULL;
+            Py_SETREF(result, PyNumber_Add(result, item));
+            if (result == NULL)
+                return NULL;
+        }
+    }
+
+    while (conswalk_next(state, walk, &item) > 0) {
+        Py_SETREF(result, PyNumber_Add(result, item));
+        if (result == NULL)
+            return NULL;
+    }
+    return result;
+}
+
+PyDoc_STRVAR(consmodule_sum_doc,
+             "sum(xs, start=0, /)\n\
+\n\
+Return the sum of 'start' and the elements of the proper list xs, like the\n\
+builtin sum. Exact ints and floats are added without creating an object for\n\
+each partial sum; other elements are added with the + operator.");
+
+PyObject *
+consmodule_sum(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs < 1 || nargs > 2) {
+        PyErr_SetString(PyExc_TypeError, "sum requires one or two positional arguments");
+        return NULL;
+    }
+    PyObject *xs = args[0];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_list_arg(state, xs, "sum", "xs") < 0)
+        return NULL;
+
+    PyObject *start = nargs > 1 ? args[1] : NULL;
+    if (start != NULL &&
+        (PyUnicode_Check(start) || PyBytes_Check(start) || PyByteArray_Check(start))) {
+        PyErr_SetString(PyExc_TypeError, "sum can't sum strings or bytes");
+        return NULL;
+    }
+    PyObject *result = start == NULL ? PyLong_FromLong(0) : Py_NewRef(start);
+    if (result == NULL)
+        return NULL;
+
+    conswalk walk = CONSWALK_INIT(xs);
+    result = cons_sum(state, &walk, result);
+    conswalk_fini(&walk);
+    return result;
+}
+
+PyDoc_STRVAR(consmodule_mean_doc,
+             "mean(xs, /)\n\
+\n\
+Return the arithmetic mean of the elements of the non-empty proper list xs:\n\
+their sum, as computed by sum, divided by their number.");
+
+PyObject *
+consmodule_mean(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "mean requires exactly one positional argument");
+        return NULL;
+    }
+    PyObject *xs = args[0];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_list_arg(state, xs, "mean", "xs") < 0)
+        return NULL;
+    else if (Py_Is(xs, state->nil)) {
+        PyErr_SetString(PyExc_ValueError, "mean of an empty list");
+        return NULL;
+    }
+
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *total = cons_sum(state, &walk, PyLong_FromLong(0));
+    conswalk_fini(&walk);
+    if (total == NULL)
+        return NULL;
+    PyObject *n = PyLong_FromSsize_t(LENGTH(xs));
+    PyObject *result = n == NULL ? NULL : PyNumber_TrueDivide(total, n);
+    Py_DECREF(total);
+    Py_XDECREF(n);
+    return result;
+}
+
+typedef enum {
+    UNBOXED_NONE,
+    UNBOXED_LONG,
+    UNBOXED_DOUBLE,
+} unboxed_kind;
+
+/* Get the value of an exact int that fits in a long, or of an exact float */
+static inline unboxed_kind
+unbox_number(PyObject *op, long *l, double *d)
+{
+    if (PyFloat_CheckExact(op)) {
+        *d = PyFloat_AS_DOUBLE(op);
+        return UNBOXED_DOUBLE;
+    }
+    else if (PyLong_CheckExact(op)) {
+        int overflow;
+        *l = PyLong_AsLongAndOverflow(op, &overflow);
+        if (!overflow)
+            return UNBOXED_LONG;
+    }
+    return UNBOXED_NONE;
+}
+
+/* The smallest (if op is Py_LT) or largest (Py_GT) element of xs, the first of them if
+   several are equal, as with the builtin min and max. Elements that are both exact ints
+   that fit in a long, or both exact floats, are compared without the rich comparison
+   machinery. */
+static PyObject *
+cons_extreme(PyObject *module, PyObject *const *args, Py_ssize_t nargs, PyObject *kwnames,
+             const char *func, int op)
+{
+    if (nargs != 1) {
+        PyErr_Format(PyExc_TypeError, "%s takes exactly one positional argument", func);
+        return NULL;
+    }
+    PyObject *xs = args[0];
+
+    static const char *const kwlist[] = {"default", NULL};
+    PyObject *kwvalues[] = {NULL};
+    if (parse_kwargs(args, nargs, kwnames, func, kwlist, kwvalues) < 0)
+        return NULL;
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_list_arg(state, xs, func, "xs") < 0)
+        return NULL;
+    else if (Py_Is(xs, state->nil)) {
+        if (kwvalues[0] != NULL)
+            return Py_NewRef(kwvalues[0]);
+        PyErr_Format(PyExc_ValueError, "%s of an empty list with no default", func);
+        return NULL;
+    }
+
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *best, *item;
+    conswalk_next(state, &walk, &best);
+    long lbest = 0, l = 0;
+    double dbest = 0.0, d = 0.0;
+    unboxed_kind kind = unbox_number(best, &lbest, &dbest);
+    while (conswalk_next(state, &walk, &item) > 0) {
+        unboxed_kind item_kind = unbox_number(item, &l, &d);
+        int better;
+        if (item_kind == UNBOXED_LONG && kind == UNBOXED_LONG)
+            better = op == Py_LT ? l < lbest : l > lbest;
+        else if (item_kind == UNBOXED_DOUBLE && kind == UNBOXED_DOUBLE)
+            better = op == Py_LT ? d < dbest : d > dbest;
+        else if ((better = PyObject_RichCompareBool(item, best, op)) < 0) {
+            best = NULL;
+            break;
+        }
+        if (better) {
+            best = item;
+            kind = item_kind;
+            lbest = l;
+            dbest = d;
+        }
+    }
+    /* best is alive until the walk is released */
+    Py_XINCREF(best);
+    conswalk_fini(&walk);
+    return best;
+}
+
+PyDoc_STRVAR(consmodule_min_doc,
+             "min(xs, /, *, default=<unrepresentable>)\n\
+\n\
+Return the smallest element of the proper list xs, or 'default' if xs is\n\
+nil(). Exact ints and floats are compared without calling into Python.");
+
+PyObject *
+consmodule_min(PyObject *module, PyObject *const *args, Py_ssize_t nargs,
+               PyObject *kwnames)
+{
+    return cons_extreme(module, args, nargs, kwnames, "min", Py_LT);
+}
+
+PyDoc_STRVAR(consmodule_max_doc,
+             "max(xs, /, *, default=<unrepresentable>)\n\
+\n\
+Return the largest element of the proper list xs, or 'default' if xs is\n\
+nil(). Exact ints and floats are compared without calling into Python.");
+
+PyObject *
+consmodule_max(PyObject *module, PyObject *const *args, Py_ssize_t nargs,
+               PyObject *kwnames)
+{
+    return cons_extreme(module, args, nargs, kwnames, "max", Py_GT);
+}
+
+PyDoc_STRVAR(consmodule_count_doc,
+             "count(predicate, xs)\n\
+\n\
+Return the number of elements of the proper list xs for which the result of\n\
+calling 'predicate' is truthy. Predicates made by the predicate type's\n\
+factories are evaluated without calling into Python.");
+
+PyObject *
+consmodule_count(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_TypeError, "count requires exactly two positional arguments");
+        return NULL;
+    }
+    PyObject *predicate = args[0];
+    PyObject *xs = args[1];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_callable_arg(predicate, "count", "predicate") < 0 ||
+        check_list_arg(state, xs, "count", "xs") < 0)
+        return NULL;
+
+    Py_ssize_t n = 0;
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *item;
+    while (conswalk_next(state, &walk, &item) > 0) {
+        int truth = call_predicate(state, predicate, item);
+        if (truth < 0) {
+            n = -1;
+            break;
+        }
+        n += truth;
+    }
+    conswalk_fini(&walk);
+    return n < 0 ? NULL : PyLong_FromSsize_t(n);
+}
+
+/* List algebra
+
+   These build their results with the same chunk and spine builders as cons.from_xs,
+   so the lengths and GC tracking of the new cells come out as for any other list, and
+   share whatever structure they can: drop returns a tail of its argument, append
+   shares its last argument, and take and append return an argument unchanged when
+   nothing would be copied. */
+
+/* Parse a count argument, which must be a non-negative int */
+static int
+parse_count_arg(PyObject *op, const char *func, Py_ssize_t *n)
+{
+    if (!PyIndex_Check(op)) {
+        PyErr_Format(PyExc_TypeError, "argument 'n' to %s must be an int, not %.200s", func,
+                     Py_TYPE(op)->tp_name);
+        return -1;
+    }
+    if ((*n = PyNumber_AsSsize_t(op, PyExc_OverflowError)) == -1 && PyErr_Occurred())
+        return -1;
+    if (*n < 0) {
+        PyErr_Format(PyExc_ValueError, "argument 'n' to %s must be non-negative", func);
+        return -1;
+    }
+    return 0;
+}
+
+/* Check that op is nil(), a proper list or a stream, for functions that only read as
+   far into a list as they need */
+static int
+check_list_or_stream_arg(consmodule_state *state, PyObject *op, const char *func,
+                         const char *arg)
+{
+    if (Py_Is(op, state->nil) ||
+        (Py_IS_TYPE(op, (PyTypeObject *)state->ConsType) && (IS_LIST(op) || IS_STREAM(op))))
+        return 0;
+    PyErr_Format(PyExc_ValueError,
+                 "argument '%s' to %s must be a proper cons list, a stream, or nil()", arg,
+                 func);
+    return -1;
+}
+
+PyDoc_STRVAR(consmodule_reverse_doc,
+             "reverse(xs)\n\
+\n\
+Return a new list of the elements of the proper list xs in reverse order.");
+
+PyObject *
+consmodule_reverse(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "reverse requires exactly one positional argument");
+        return NULL;
+    }
+    PyObject *xs = args[0];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_list_arg(state, xs, "reverse", "xs") < 0)
+        return NULL;
+    if (Py_Is(xs, state->nil) || LENGTH(xs) == 1)
+        return Py_NewRef(xs);
+
+    /* Fill the chunk from the back. A proper list's walk can't fail, so every slot is
+       filled by the time the chunk is sized. */
+    Py_ssize_t n = LENGTH(xs);
+    ChunkObject *chunk = chunk_new(state, n);
+    if (chunk == NULL)
+        return NULL;
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *item;
+    for (Py_ssize_t i = n; i > 0 && conswalk_next(state, &walk, &item) > 0;)
+        chunk->items[--i] = Py_NewRef(item);
+    conswalk_fini(&walk);
+    Py_SET_SIZE(chunk, n);
+    return cons_from_chunk(state, chunk);
+}
+
+PyDoc_STRVAR(consmodule_append_doc,
+             "append(*lists)\n\
+\n\
+Return the concatenation of the lists. Every argument but the last must be a\n\
+proper list, and their elements are copied; the last argument becomes the\n\
+tail of the result as it is, without being copied, so it may be any object.\n\
+With a single argument, return it unchanged, and with none, return nil().");
+
+PyObject *
+consmodule_append(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (nargs == 0)
+        return Py_NewRef(state->nil);
+
+    Py_ssize_t n = 0;
+    for (Py_ssize_t i = 0; i < nargs - 1; i++) {
+        if (check_list_arg(state, args[i], "append", "lists") < 0)
+            return NULL;
+        if (!Py_Is(args[i], state->nil))
+            n += LENGTH(args[i]);
+    }
+    PyObject *tail = args[nargs - 1];
+    if (n == 0)
+        return Py_NewRef(tail);
+
+    /* A chunk can only end in nil, so a prefix in front of anything else is made of
+       cells */
+    bool chunked = Py_Is(tail, state->nil);
+    ChunkObject *chunk = NULL;
+    PyObject **items;
+    if (chunked) {
+        if ((chunk = chunk_new(state, n)) == NULL)
+            return NULL;
+        items = chunk->items;
+    }
+    else if ((items = PyMem_New(PyObject *, (size_t)n)) == NULL)
+        return PyErr_NoMemory();
+
+    Py_ssize_t filled = 0;
+    for (Py_ssize_t i = 0; i < nargs - 1; i++) {
+        conswalk walk = CONSWALK_INIT(args[i]);
+        PyObject *item;
+        while (conswalk_next(state, &walk, &item) > 0)
+            items[filled++] = Py_NewRef(item);
+        conswalk_fini(&walk);
+    }
+    assert(filled == n);
+
+    if (chunked) {
+        Py_SET_SIZE(chunk, n);
+        return cons_from_chunk(state, chunk);
+    }
+    PyObject *result = cons_from_spine(state, items, n, Py_NewRef(tail));
+    PyMem_Free(items);
+    return result;
+}
+
+PyDoc_STRVAR(consmodule_take_doc,
+             "take(n, xs)\n\
+\n\
+Return a new list of the first n elements of the proper list or stream xs, or\n\
+xs itself if it has no more than n elements. Only the first n elements of a\n\
+stream are forced.");
+
+PyObject *
+consmodule_take(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_TypeError, "take requires exactly two positional arguments");
+        return NULL;
+    }
+    PyObject *xs = args[1];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    Py_ssize_t n;
+    if (parse_count_arg(args[0], "take", &n) < 0 ||
+        check_list_or_stream_arg(state, xs, "take", "xs") < 0)
+        return NULL;
+    if (Py_Is(xs, state->nil) || (IS_LIST(xs) && LENGTH(xs) <= n))
+        return Py_NewRef(xs);
+    if (n == 0)
+        return Py_NewRef(state->nil);
+
+    /* A stream may turn out to be shorter than n, so its chunk is grown as needed */
+    Py_ssize_t capacity = IS_LIST(xs) ? n : Py_MIN(n, CONS_CHUNK_MIN);
+    ChunkObject *chunk = chunk_new(state, capacity);
+    if (chunk == NULL)
+        return NULL;
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *item;
+    int next = 0;
+    while (Py_SIZE(chunk) < n) {
+        /* Stop at the nth item, so the stream isn't forced past it */
+        next = Py_SIZE(chunk) == n - 1 ? conswalk_peek(state, &walk, &item)
+                                       : conswalk_next(state, &walk, &item);
+        if (next <= 0)
+            break;
+        if (chunk_append(&chunk, &capacity, Py_NewRef(item)) < 0) {
+            next = -1;
+            break;
+        }
+    }
+    conswalk_fini(&walk);
+    if (next < 0) {
+        Py_DECREF(chunk);
+        return NULL;
+    }
+    else if (next == 0) {
+        /* The whole stream was taken */
+        Py_DECREF(chunk);
+        return Py_NewRef(xs);
+    }
+    return cons_from_chunk(state, chunk);
+}
+
+PyDoc_STRVAR(consmodule_drop_doc,
+             "drop(n, xs)\n\
+\n\
+Return the proper list or stream xs without its first n elements, or nil() if\n\
+it has no more than n elements. The result is the tail of xs that starts\n\
+there, shared rather than copied; in a list built in bulk whose cells haven't\n\
+been made yet, it's a single new cell sharing the list's storage.");
+
+PyObject *
+consmodule_drop(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 2) {
+        PyErr_SetString(PyExc_TypeError, "drop requires exactly two positional arguments");
+        return NULL;
+    }
+    PyObject *xs = args[1];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    Py_ssize_t n;
+    if (parse_count_arg(args[0], "drop", &n) < 0 ||
+        check_list_or_stream_arg(state, xs, "drop", "xs") < 0)
+        return NULL;
+    if (Py_Is(xs, state->nil) || (IS_LIST(xs) && LENGTH(xs) <= n))
+        return Py_NewRef(state->nil);
+
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *item, *result = NULL;
+    int next = 1;
+    for (Py_ssize_t i = 0; i < n && (next = conswalk_next(state, &walk, &item)) > 0; i++)
+        ;
+    if (next >= 0)
+        result = conswalk_rest(state, &walk);
+    conswalk_fini(&walk);
+    return result;
+}
+
+PyDoc_STRVAR(consmodule_zip_doc,
+             "zip(*lists)\n\
+\n\
+Return a new list of tuples, where the i-th tuple holds the i-th element of\n\
+each of the proper lists, as long as the shortest of them.");
+
+PyObject *
+consmodule_zip(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+
+    Py_ssize_t n = PY_SSIZE_T_MAX;
+    for (Py_ssize_t i = 0; i < nargs; i++) {
+        if (check_list_arg(state, args[i], "zip", "lists") < 0)
+            return NULL;
+        n = Py_MIN(n, Py_Is(args[i], state->nil) ? 0 : LENGTH(args[i]));
+    }
+    if (nargs == 0 || n == 0)
+        return Py_NewRef(state->nil);
+
+    conswalk *walks = PyMem_New(conswalk, (size_t)nargs);
+    if (walks == NULL)
+        return PyErr_NoMemory();
+    for (Py_ssize_t i = 0; i < nargs; i++)
+        walks[i] = (conswalk)CONSWALK_INIT(args[i]);
+
+    PyObject *result = NULL;
+    ChunkObject *chunk = chunk_new(state, n);
+    if (chunk == NULL)
+        goto done;
+    for (Py_ssize_t k = 0; k < n; k++) {
+        PyObject *tuple = PyTuple_New(nargs);
+        if (tuple == NULL) {
+            Py_CLEAR(chunk);
+            goto done;
+        }
+        for (Py_ssize_t i = 0; i < nargs; i++) {
+            /* Every list has at least n items, and proper lists can't fail to walk */
+            PyObject *item = NULL;
+            if (conswalk_next(state, &walks[i], &item) <= 0) {
+                if (!PyErr_Occurred())
+                    PyErr_SetString(PyExc_SystemError, "cons list ended early in zip");
+                Py_DECREF(tuple);
+                Py_CLEAR(chunk);
+                goto done;
+            }
+            PyTuple_SET_ITEM(tuple, i, Py_NewRef(item));
+        }
+        chunk_push(chunk, tuple);
+    }
+    result = cons_from_chunk(state, chunk);
+
+done:
+    for (Py_ssize_t i = 0; i < nargs; i++)
+        conswalk_fini(&walks[i]);
+    PyMem_Free(walks);
+    return result;
+}
+
+PyDoc_STRVAR(consmodule_last_doc,
+             "last(xs)\n\
+\n\
+Return the last element of the proper list xs. Raise ValueError if xs is\n\
+nil(). A list built in bulk has its last element read from its storage\n\
+without walking it.");
+
+PyObject *
+consmodule_last(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "last requires exactly one positional argument");
+        return NULL;
+    }
+    PyObject *xs = args[0];
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if (check_list_arg(state, xs, "last", "xs") < 0)
+        return NULL;
+    if (Py_Is(xs, state->nil)) {
+        PyErr_SetString(PyExc_ValueError, "last() arg is an empty list");
+        return NULL;
+    }
+
+    for (PyObject *cell = xs;; cell = cons_tail(cell)) {
+        Py_ssize_t start;
+        ChunkObject *chunk = cons_chunk_ref(cell, &start);
+        if (chunk != NULL) {
+            PyObject *item = Py_NewRef(chunk->items[Py_SIZE(chunk) - 1]);
+            Py_DECREF(chunk);
+            return item;
+        }
+        else if (LENGTH(cell) == 1)
+            return Py_NewRef(CAR(cell));
+    }
+}
+
+PyDoc_STRVAR(consmodule_flatten_doc,
+             "flatten(xs)\n\
+\n\
+Return a new list of the elements of the proper list xs, with every element\n\
+that is itself a proper list (or nil()) replaced by its flattened elements, at\n\
+any depth. Pairs that aren't proper lists, and streams, are kept as elements.\n\
+Nested lists are walked with an explicit stack, so depth isn't limited by the\n\
+recursion limit.");
+
+#define FLATTEN_STACK_INLINE 16
+
+PyObject *
+consmodule_flatten(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
 {
-    _PyUnicodeWriter writer;
-    Py_ssize_t i;
-    PyObject *next = self;
-    PyObject *m = PyType_GetModuleByDef(Py_TYPE(self), &consmodule);
-    if (m == NULL) {
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "flatten requires exactly one positional argument");
         return NULL;
     }
-    consmodule_state *state = PyModule_GetState(m);
+    PyObject *xs = args[0];
+
+    consmodule_state *state = PyModule_GetState(module);
     if (state == NULL)
         return NULL;
+    if (check_list_arg(state, xs, "flatten", "xs") < 0)
+        return NULL;
+    if (Py_Is(xs, state->nil))
+        return Py_NewRef(xs);
 
-    PyTypeObject *cons = (PyTypeObject *)state->ConsType;
-
-    i = Py_ReprEnter(self);
-    if (i != 0)
-        return i > 0 ? PyUnicode_FromFormat("...") : NULL;
-
-    _PyUnicodeWriter_Init(&writer);
-    writer.overallocate = 1;
-    writer.min_length = 3;  // "(_)"
-    if (_PyUnicodeWriter_WriteChar(&writer, '(') < 0)
-        goto error;
+    /* The flat list is at least as long as xs */
+    Py_ssize_t capacity = LENGTH(xs);
+    ChunkObject *chunk = chunk_new(state, capacity);
+    if (chunk == NULL)
+        return NULL;
 
-    PyObject *head = NULL, *repr = NULL, *tail = NULL;
-    while (Py_IS_TYPE(next, cons)) {
-        head = CAR(next);
-        repr = PyObject_Repr(head);
-        if (repr == NULL)
-            goto error;
-        if (_PyUnicodeWriter_WriteStr(&writer, repr) < 0) {
-            Py_DECREF(repr);
-            goto error;
+    conswalk small[FLATTEN_STACK_INLINE], *walks = small;
+    Py_ssize_t depth = 1, stack_capacity = FLATTEN_STACK_INLINE;
+    walks[0] = (conswalk)CONSWALK_INIT(xs);
+    while (depth > 0) {
+        PyObject *item;
+        if (conswalk_next(state, &walks[depth - 1], &item) == 0) {
+            conswalk_fini(&walks[--depth]);
+            continue;
         }
-        Py_DECREF(repr);
-
-        tail = CDR(next);
-        if (Py_Is(tail, state->nil))
-            break;
-        else if (!Py_IS_TYPE(tail, cons)) {
-            if (_PyUnicodeWriter_WriteASCIIString(&writer, " . ", 3) < 0)
-                goto error;
-            repr = PyObject_Repr(tail);
-            if (repr == NULL)
-                goto error;
-            if (_PyUnicodeWriter_WriteStr(&writer, repr) < 0) {
-                Py_DECREF(repr);
+        if (Py_Is(item, state->nil))
+            continue;
+        else if (Py_IS_TYPE(item, (PyTypeObject *)state->ConsType) && IS_LIST(item)) {
+            conswalk *grown = framestack_reserve(walks, small, depth, &stack_capacity,
+                                                 sizeof(conswalk));
+            if (grown == NULL)
                 goto error;
-            }
-            Py_DECREF(repr);
-            break;
+            walks = grown;
+            walks[depth++] = (conswalk)CONSWALK_INIT(item);
         }
-        if (_PyUnicodeWriter_WriteChar(&writer, ' ') < 0)
+        else if (chunk_append(&chunk, &capacity, Py_NewRef(item)) < 0)
             goto error;
-        next = tail;
     }
-
-    writer.overallocate = 0;
-    if (_PyUnicodeWriter_WriteChar(&writer, ')') < 0)
-        goto error;
-    Py_ReprLeave(self);
-    return _PyUnicodeWriter_Finish(&writer);
+    if (walks != small)
+        PyMem_Free(walks);
+    if (Py_SIZE(chunk) == 0) {
+        Py_DECREF(chunk);
+        return Py_NewRef(state->nil);
+    }
+    return cons_from_chunk(state, chunk);
 
 error:
-    _PyUnicodeWriter_Dealloc(&writer);
-    Py_ReprLeave(self);
+    while (depth > 0)
+        conswalk_fini(&walks[--depth]);
+    if (walks != small)
+        PyMem_Free(walks);
+    Py_DECREF(chunk);
     return NULL;
 }
 
+/* The key of a pair in an association list being sorted, passed through the key
+   function given to sort (the bound self), if any. sort checks that every element is a
+   pair before calling it. */
+static PyObject *
+sort_alist_key(PyObject *key, PyObject *pair)
+{
+    PyObject *head = CAR(pair);
+    if (key == NULL)
+        return Py_NewRef(head);
+    PyObject *callargs[2] = {NULL, head};
+    return PyObject_Vectorcall(key, callargs + 1, 1 | PY_VECTORCALL_ARGUMENTS_OFFSET, NULL);
+}
+
+static PyMethodDef sort_alist_key_def = {"alist_key", (PyCFunction)sort_alist_key, METH_O,
+                                         NULL};
+
+PyDoc_STRVAR(consmodule_sort_doc,
+             "sort(xs, /, *, key=None, reverse=False, alist=False)\n\
+\n\
+Return a new list of the elements of the proper list xs in ascending order,\n\
+or xs itself if it's already in order. Like sorted(), the sort is stable, and\n\
+'key' and 'reverse' work the same way. With 'alist', xs must be an\n\
+association list, and its pairs are ordered by their keys (passed through\n\
+'key', if given) rather than compared whole.");
+
+/* The elements are gathered straight into the array of a Python list and sorted with
+   list.sort, CPython's timsort, which already compares homogeneous ints, floats, strs
+   and tuples without going through rich comparison. */
 PyObject *
-Cons_richcompare(PyObject *self, PyObject *other, int op)
+consmodule_sort(PyObject *module, PyObject *const *args, Py_ssize_t nargs,
+                PyObject *kwnames)
 {
-    consmodule_state *state = PyType_GetModuleState(Py_TYPE(self));
-    if (state == NULL)
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "sort takes exactly one positional argument");
         return NULL;
+    }
+    PyObject *xs = args[0];
 
-    PyObject *nil = state->nil;
-    PyTypeObject *cons = (PyTypeObject *)state->ConsType;
-    if (!Py_IS_TYPE(other, cons))
-        Py_RETURN_NOTIMPLEMENTED;
+    static const char *const kwlist[] = {"key", "reverse", "alist", NULL};
+    PyObject *kwvalues[] = {NULL, NULL, NULL};
+    if (parse_kwargs(args, nargs, kwnames, "sort", kwlist, kwvalues) < 0)
+        return NULL;
+    PyObject *key = Py_IsNone(kwvalues[0]) ? NULL : kwvalues[0];
+    int reverse = kwvalues[1] == NULL ? 0 : PyObject_IsTrue(kwvalues[1]);
+    int alist = kwvalues[2] == NULL ? 0 : PyObject_IsTrue(kwvalues[2]);
+    if (reverse < 0 || alist < 0)
+        return NULL;
 
-    PyObject *this = self, *that = other;
-    /* cdr down the list until comparison fails or either object is not a cons */
-    while (Py_IS_TYPE(this, cons) && Py_IS_TYPE(that, cons)) {
-        int cmp = PyObject_RichCompareBool(CAR(this), CAR(that), op);
-        if (cmp < 0)
-            return NULL;
-        else if (cmp && op == Py_NE)
-            Py_RETURN_TRUE;
-        else if (!cmp && op != Py_NE)
-            Py_RETURN_FALSE;
-        else {
-            this = CDR(this);
-            that = CDR(that);
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    if ((key != NULL && check_callable_arg(key, "sort", "key") < 0) ||
+        check_list_arg(state, xs, "sort", "xs") < 0)
+        return NULL;
+    if (Py_Is(xs, state->nil))
+        return Py_NewRef(xs);
+
+    /* The key list.sort is called with: key itself, or for an alist, a function of the
+       pairs wrapping it */
+    PyObject *sortkey = alist ? NULL : Py_XNewRef(key);
+    Py_ssize_t n = LENGTH(xs);
+    PyObject *list = PyList_New(n), *result = NULL;
+    if (list == NULL)
+        goto done;
+    conswalk walk = CONSWALK_INIT(xs);
+    PyObject *item;
+    for (Py_ssize_t i = 0; i < n && conswalk_next(state, &walk, &item) > 0; i++) {
+        if (alist && !Py_IS_TYPE(item, (PyTypeObject *)state->ConsType)) {
+            PyErr_SetString(PyExc_ValueError,
+                            "argument 'xs' to sort must be an association list of pairs");
+            conswalk_fini(&walk);
+            goto done;
         }
+        PyList_SET_ITEM(list, i, Py_NewRef(item));
     }
+    conswalk_fini(&walk);
 
-    if (Py_Is(this, nil) && Py_Is(that, nil)) {
-        // In the case of a proper list, disregard comparison of the terminating element
-        if (op == Py_NE)
-            Py_RETURN_FALSE;
-        else
-            Py_RETURN_TRUE;
+    if (alist && (sortkey = PyCFunction_New(&sort_alist_key_def, key)) == NULL)
+        goto done;
+    if (sortkey == NULL && !reverse) {
+        if (PyList_Sort(list) < 0)
+            goto done;
+    }
+    else {
+        PyObject *sort = PyObject_GetAttrString(list, "sort"), *kwargs = NULL, *sorted = NULL;
+        if (sort != NULL && (kwargs = PyDict_New()) != NULL &&
+            (sortkey == NULL || PyDict_SetItemString(kwargs, "key", sortkey) == 0) &&
+            PyDict_SetItemString(kwargs, "reverse", reverse ? Py_True : Py_False) == 0)
+            sorted = PyObject_VectorcallDict(sort, NULL, 0, kwargs);
+        Py_XDECREF(sort);
+        Py_XDECREF(kwargs);
+        if (sorted == NULL)
+            goto done;
+        Py_DECREF(sorted);
     }
-    return PyObject_RichCompare(this, that, op);
-}
-
-/* Simplified xxHash - see https://github.com/Cyan4973/xxHash/blob/master/doc/xxhash_spec.md
-   and tupleobject.c
-*/
-#if SIZEOF_PY_UHASH_T > 4
-#define _PyHASH_XXPRIME_1 ((Py_uhash_t)11400714785074694791ULL)
-#define _PyHASH_XXPRIME_2 ((Py_uhash_t)14029467366897019727ULL)
-#define _PyHASH_XXPRIME_5 ((Py_uhash_t)2870177450012600261ULL)
-#define _PyHASH_XXROTATE(x) ((x << 31) | (x >> 33)) /* Rotate left 31 bits */
-#else
-#define _PyHASH_XXPRIME_1 ((Py_uhash_t)2654435761UL)
-#define _PyHASH_XXPRIME_2 ((Py_uhash_t)2246822519UL)
-#define _PyHASH_XXPRIME_5 ((Py_uhash_t)374761393UL)
-#define _PyHASH_XXROTATE(x) ((x << 13) | (x >> 19)) /* Rotate left 13 bits */
-#endif
 
-static Py_hash_t
-Cons_hash(ConsObject *cons)
-{
-    PyObject *objs[2] = {cons->head, cons->tail};
-    Py_uhash_t acc = _PyHASH_XXPRIME_5;
+    /* An already sorted list is shared rather than copied */
+    bool unchanged = true;
+    walk = (conswalk)CONSWALK_INIT(xs);
+    for (Py_ssize_t i = 0; unchanged && i < n && conswalk_next(state, &walk, &item) > 0; i++)
+        unchanged = Py_Is(item, PyList_GET_ITEM(list, i));
+    conswalk_fini(&walk);
+    result = unchanged ? Py_NewRef(xs) : Cons_from_fast_with(list, state, identity);
 
-    for (size_t i = 0; i < 2; i++) {
-        Py_uhash_t lane = PyObject_Hash(objs[i]);
-        if (lane == (Py_uhash_t)-1)
-            return -1;
-        acc += lane * _PyHASH_XXPRIME_2;
-        acc = _PyHASH_XXROTATE(acc);
-        acc *= _PyHASH_XXPRIME_1;
-    }
-    /* Adding the length complicates matters (do cons(1, 2) and cons(1, nil()) have the same
-       length wrt hashing?) so leave it - the xxHash spec allows length to be zero.
-    */
-    return acc;
+done:
+    Py_XDECREF(sortkey);
+    Py_XDECREF(list);
+    return result;
 }
 
-static PyMemberDef Cons_members[] = {
-    {"head", T_OBJECT_EX, offsetof(ConsObject, head), READONLY, "cons head"},
-    {"tail", T_OBJECT_EX, offsetof(ConsObject, tail), READONLY, "cons tail"},
-    {NULL},
-};
-
-PyDoc_STRVAR(from_xs_doc, "Create a cons list from a sequence or iterable");
-PyDoc_STRVAR(to_list_doc, "Convert a proper const list to a Python list");
-PyDoc_STRVAR(lift_doc,
-             "Recursively convert a Python sequence and its sub-sequences to a conses");
+PyDoc_STRVAR(consmodule_from_spine_doc,
+             "_from_spine(items, tail, /)\n\
+\n\
+Cons the items of a tuple onto tail, back to front. Used to unpickle conses.");
 
-static PyMethodDef Cons_methods[] = {
-    {"from_xs", (PyCFunction)Cons_from_xs,
-     METH_METHOD | METH_FASTCALL | METH_KEYWORDS | METH_CLASS, from_xs_doc},
-    {"to_list", (PyCFunction)Cons_to_list, METH_METHOD | METH_FASTCALL | METH_KEYWORDS,
-     to_list_doc},
-    {"lift", (PyCFunction)Cons_lift, METH_METHOD | METH_FASTCALL | METH_KEYWORDS | METH_CLASS,
-     lift_doc},
-    {NULL},
-};
+PyObject *
+consmodule_from_spine(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 2 || !PyTuple_Check(args[0])) {
+        PyErr_SetString(PyExc_TypeError, "_from_spine requires a tuple and a tail");
+        return NULL;
+    }
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
 
-PyDoc_STRVAR(cons_doc, "Construct a new immutable pair");
+    PyObject *items = args[0];
+    Py_ssize_t n = PyTuple_GET_SIZE(items);
+    for (Py_ssize_t i = 0; i < n; i++)
+        Py_INCREF(PyTuple_GET_ITEM(items, i));
+    return cons_from_spine(state, &PyTuple_GET_ITEM(items, 0), n, Py_NewRef(args[1]));
+}
 
-static PyType_Slot Cons_Type_Slots[] = {
-    {Py_tp_doc, (void *)cons_doc},
-    {Py_tp_dealloc, Cons_dealloc},
-    {Py_tp_new, Cons_new},
-    {Py_tp_members, Cons_members},
-    {Py_tp_traverse, Cons_traverse},
-    {Py_tp_clear, Cons_clear},
-    {Py_tp_repr, Cons_repr},
-    {Py_tp_methods, Cons_methods},
-    {Py_tp_richcompare, Cons_richcompare},
-    {Py_tp_hash, Cons_hash},
-    {0, NULL},
-};
+PyDoc_STRVAR(consmodule_dumps_doc, "dumps(obj, /)\n\
+\n\
+Serialize obj to bytes in a compact binary format. Lists are written as flat\n\
+sequences of items, and cells referred to more than once are written once and\n\
+shared again by loads. None, bools, ints, floats, str and bytes have compact\n\
+encodings; other objects are pickled. Streams are forced to the end.");
 
-static PyType_Spec Cons_Type_Spec = {
-    .name = "fastcons.cons",
-    .basicsize = sizeof(ConsObject),
-    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_IMMUTABLETYPE | Py_TPFLAGS_HAVE_GC |
-             Py_TPFLAGS_MANAGED_WEAKREF,
-    .slots = Cons_Type_Slots,
-};
+PyObject *
+consmodule_dumps(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+{
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "dumps requires exactly one positional argument");
+        return NULL;
+    }
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+    return serial_dumps(state, args[0]);
+}
 
-/* module level functions */
-PyDoc_STRVAR(consmodule_assoc_doc,
-             "assoc(object, alist)\n\
+PyDoc_STRVAR(consmodule_write_repr_doc, "write_repr(obj, file, /)\n\
 \n\
-Return the first pair in alist whose car is equal to object. Return\n\
-nil() if object is not found.");
+Write repr(obj) to a text file, or any object with a write method taking str,\n\
+in pieces of bounded size rather than building the whole string first. A file\n\
+that refuses str, such as a binary file, is written UTF-8 bytes. Nested lists\n\
+are walked without recursing.");
 
 PyObject *
-consmodule_assoc(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+consmodule_write_repr(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
 {
     if (nargs != 2) {
-        PyErr_SetString(PyExc_TypeError, "assoc requires exactly two positional arguments");
+        PyErr_SetString(PyExc_TypeError,
+                        "write_repr requires exactly two positional arguments");
         return NULL;
     }
-    PyObject *object = args[0];
-    PyObject *alist = args[1];
-
     consmodule_state *state = PyModule_GetState(module);
     if (state == NULL)
         return NULL;
-
-    if (Py_Is(alist, state->nil)) {
-        Py_INCREF(state->nil);
-        return state->nil;
-    }
-    else if (!Py_IS_TYPE(alist, (PyTypeObject *)state->ConsType) || !IS_LIST(alist)) {
-        PyErr_SetString(
-            PyExc_ValueError,
-            "argument 'alist' to assoc must be a cons list of cons pairs, or nil()");
+    PyObject *obj = args[0];
+    PyObject *write = PyObject_GetAttrString(args[1], "write");
+    if (write == NULL)
         return NULL;
-    }
 
-    for (PyObject *pair = CAR(alist); !Py_Is(alist, state->nil);
-         alist = CDR(alist), pair = CAR(alist)) {
-        if (!Py_IS_TYPE(pair, (PyTypeObject *)state->ConsType)) {
-            PyErr_SetString(PyExc_ValueError,
-                            "'alist' is not a properly formed association list");
-            return NULL;
-        }
-        else if (PyObject_RichCompareBool(object, CAR(pair), Py_EQ)) {
-            Py_INCREF(pair);
-            return pair;
-        }
+    reprsink sink;
+    reprsink_init(&sink, write, -1);
+    bool is_cons = Py_IS_TYPE(obj, (PyTypeObject *)state->ConsType);
+    int err = is_cons ? Py_ReprEnter(obj) : 0;
+    if (err > 0)
+        err = _PyUnicodeWriter_WriteASCIIString(&sink.writer, "...", 3);
+    else if (err == 0) {
+        err = cons_write_repr(state, &sink, obj);
+        if (is_cons)
+            Py_ReprLeave(obj);
     }
-
-    Py_INCREF(state->nil);
-    return state->nil;
+    if (err == 0)
+        err = reprsink_flush(&sink);
+    else
+        _PyUnicodeWriter_Dealloc(&sink.writer);
+    Py_DECREF(write);
+    return err < 0 ? NULL : Py_NewRef(Py_None);
 }
 
-PyDoc_STRVAR(consmodule_assp_doc,
-             "assp(predicate, alist)\n\
-\n\
-Return the first pair in alist for which the result of calling 'predicate'\n\
-on its car is truthy.\n\
+PyDoc_STRVAR(consmodule_loads_doc, "loads(data, /)\n\
 \n\
-'predicate' must be a function that takes a single argument.");
+Rebuild an object from bytes written by dumps. As with pickle, only load data\n\
+from a trusted source.");
 
 PyObject *
-consmodule_assp(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
+consmodule_loads(PyObject *module, PyObject *const *args, Py_ssize_t nargs)
 {
-    if (nargs != 2) {
-        PyErr_SetString(PyExc_TypeError, "assp requires exactly two positional arguments");
+    if (nargs != 1) {
+        PyErr_SetString(PyExc_TypeError, "loads requires exactly one positional argument");
         return NULL;
     }
-    PyObject *predicate = args[0];
-    PyObject *alist = args[1];
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
+        return NULL;
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(args[0], &view, PyBUF_SIMPLE) < 0)
+        return NULL;
+    PyObject *result = serial_loads(state, view.buf, view.len);
+    PyBuffer_Release(&view);
+    return result;
+}
+
+PyDoc_STRVAR(consmodule_freelist_info_doc,
+             "freelist_info()\n\
+\n\
+Return a dict describing the cons cell free-list: its current 'size' and\n\
+'capacity', the number of allocations served from it ('hits') or from the\n\
+Python allocator ('misses'), and the number of 'bulk_allocs' requests.");
 
+PyObject *
+consmodule_freelist_info(PyObject *module, PyObject *Py_UNUSED(ignored))
+{
     consmodule_state *state = PyModule_GetState(module);
     if (state == NULL)
         return NULL;
 
-    if (Py_Is(alist, state->nil)) {
-        Py_INCREF(state->nil);
-        return state->nil;
-    }
-    else if (!Py_IS_TYPE(alist, (PyTypeObject *)state->ConsType) || !IS_LIST(alist)) {
-        PyErr_SetString(
-            PyExc_ValueError,
-            "argument 'alist' to assp must be a cons list of cons pairs, or nil()");
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n}", "size", state->numfree, "capacity",
+                         (Py_ssize_t)CONS_MAXFREELIST, "hits", state->freelist_hits,
+                         "misses", state->freelist_misses, "bulk_allocs",
+                         state->bulk_allocs);
+}
+
+PyDoc_STRVAR(consmodule_stats_doc,
+             "stats(*, reset=False)\n\
+\n\
+Return a dict of counters describing what the module has done: cells\n\
+allocated and freed, cells currently alive and the most alive at once, cells\n\
+allocated one at a time or by bulk requests, lists stored in chunks, calls to\n\
+assoc, assp, comparisons and hashing, the pairs examined by assoc and assp,\n\
+and the deepest nesting seen by hash and cons.lift. 'enabled' is false if the\n\
+module was built with CONS_STATS=0, in which case the counters stay at zero.\n\
+If 'reset' is true, the counters are zeroed after they're read, and the peak\n\
+number of live cells starts again from the current number.");
+
+PyObject *
+consmodule_stats(PyObject *module, PyObject *const *args, Py_ssize_t nargs,
+                 PyObject *kwnames)
+{
+    if (nargs != 0) {
+        PyErr_SetString(PyExc_TypeError, "stats takes no positional arguments");
         return NULL;
     }
-    else if (!PyFunction_Check(predicate)) {
-        PyErr_SetString(PyExc_ValueError, "argument 'predicate' to assp must be a function");
+    static const char *const kwlist[] = {"reset", NULL};
+    PyObject *kwvalues[] = {NULL};
+    if (parse_kwargs(args, nargs, kwnames, "stats", kwlist, kwvalues) < 0)
+        return NULL;
+    int reset = kwvalues[0] == NULL ? 0 : PyObject_IsTrue(kwvalues[0]);
+    if (reset < 0)
+        return NULL;
+
+    consmodule_state *state = PyModule_GetState(module);
+    if (state == NULL)
         return NULL;
+
+    static const struct {
+        const char *name;
+        size_t offset;
+    } counters[] = {
+        {"cells_allocated", offsetof(consstats, cells_allocated)},
+        {"cells_freed", offsetof(consstats, cells_freed)},
+        {"live_cells", offsetof(consstats, live_cells)},
+        {"peak_live_cells", offsetof(consstats, peak_live_cells)},
+        {"bulk_allocs", offsetof(consstats, bulk_allocs)},
+        {"bulk_cells", offsetof(consstats, bulk_cells)},
+        {"chunked_lists", offsetof(consstats, chunked_lists)},
+        {"untracked_cells", offsetof(consstats, untracked_cells)},
+        {"assoc_calls", offsetof(consstats, assoc_calls)},
+        {"assoc_probes", offsetof(consstats, assoc_probes)},
+        {"assp_calls", offsetof(consstats, assp_calls)},
+        {"assp_probes", offsetof(consstats, assp_probes)},
+        {"compare_calls", offsetof(consstats, compare_calls)},
+        {"hash_calls", offsetof(consstats, hash_calls)},
+        {"hash_max_depth", offsetof(consstats, hash_max_depth)},
+        {"lift_max_depth", offsetof(consstats, lift_max_depth)},
+    };
+
+    /* Other threads may be updating the counters as they're read */
+    consstats snapshot;
+    for (size_t i = 0; i < Py_ARRAY_LENGTH(counters); i++) {
+        Py_ssize_t *counter = (Py_ssize_t *)((char *)&state->stats + counters[i].offset);
+        *(Py_ssize_t *)((char *)&snapshot + counters[i].offset) = LOAD_SSIZE(*counter);
+        /* live_cells is a level rather than a count of events, so it's never reset */
+        if (reset && counter != &state->stats.live_cells)
+            STORE_SSIZE(*counter, 0);
     }
+    if (reset)
+        STORE_SSIZE(state->stats.peak_live_cells, snapshot.live_cells);
 
-    for (PyObject *pair = CAR(alist); !Py_Is(alist, state->nil);
-         alist = CDR(alist), pair = CAR(alist)) {
-        if (!Py_IS_TYPE(pair, (PyTypeObject *)state->ConsType)) {
-            PyErr_SetString(PyExc_ValueError,
-                            "'alist' is not a properly formed association list");
-            return NULL;
-        }
-        PyObject *result = PyObject_CallOneArg(predicate, CAR(pair));
-        if (result == NULL)
+    PyObject *result = Py_BuildValue("{s:O,s:n}", "enabled", CONS_STATS ? Py_True : Py_False,
+                                     "single_allocs",
+                                     snapshot.cells_allocated - snapshot.bulk_cells);
+    if (result == NULL)
+        return NULL;
+    for (size_t i = 0; i < Py_ARRAY_LENGTH(counters); i++) {
+        PyObject *value =
+            PyLong_FromSsize_t(*(Py_ssize_t *)((char *)&snapshot + counters[i].offset));
+        int err = value == NULL ? -1 : PyDict_SetItemString(result, counters[i].name, value);
+        Py_XDECREF(value);
+        if (err < 0) {
+            Py_DECREF(result);
             return NULL;
-        else if (PyObject_IsTrue(result)) {
-            Py_INCREF(pair);
-            return pair;
         }
     }
-
-    Py_INCREF(state->nil);
-    return state->nil;
+    return result;
 }
 
 /* module initialisation */
@@ -737,6 +7002,8 @@ consmodule_exec(PyObject *m)
     state->ConsType = PyType_FromModuleAndSpec(m, &Cons_Type_Spec, NULL);
     if (state->ConsType == NULL)
         return -1;
+    /* There's no Py_tp_vectorcall slot before Python 3.14 */
+    ((PyTypeObject *)state->ConsType)->tp_vectorcall = Cons_vectorcall;
     if (PyModule_AddType(m, (PyTypeObject *)state->ConsType) < 0)
         return -1;
     PyObject *match_args = PyTuple_New(2);
@@ -751,6 +7018,58 @@ consmodule_exec(PyObject *m)
     }
     Py_DECREF(match_args);
 
+    state->ConsIterType = PyType_FromModuleAndSpec(m, &ConsIter_Type_Spec, NULL);
+    if (state->ConsIterType == NULL)
+        return -1;
+
+    state->ConsBuilderType = PyType_FromModuleAndSpec(m, &ConsBuilder_Type_Spec, NULL);
+    if (state->ConsBuilderType == NULL)
+        return -1;
+
+    state->ConsIndexType = PyType_FromModuleAndSpec(m, &ConsIndex_Type_Spec, NULL);
+    if (state->ConsIndexType == NULL)
+        return -1;
+
+    state->ConsCacheType = PyType_FromModuleAndSpec(m, &ConsCache_Type_Spec, NULL);
+    if (state->ConsCacheType == NULL)
+        return -1;
+
+    state->ThunkType = PyType_FromModuleAndSpec(m, &Thunk_Type_Spec, NULL);
+    if (state->ThunkType == NULL)
+        return -1;
+
+    state->ChunkType = PyType_FromModuleAndSpec(m, &Chunk_Type_Spec, NULL);
+    if (state->ChunkType == NULL)
+        return -1;
+
+    state->HamtType = PyType_FromModuleAndSpec(m, &Hamt_Type_Spec, NULL);
+    if (state->HamtType == NULL)
+        return -1;
+    if (PyModule_AddType(m, (PyTypeObject *)state->HamtType) < 0)
+        return -1;
+
+    state->HamtNodeType = PyType_FromModuleAndSpec(m, &HamtNode_Type_Spec, NULL);
+    if (state->HamtNodeType == NULL)
+        return -1;
+
+    state->HamtIterType = PyType_FromModuleAndSpec(m, &HamtIter_Type_Spec, NULL);
+    if (state->HamtIterType == NULL)
+        return -1;
+
+    state->PredicateType = PyType_FromModuleAndSpec(m, &Predicate_Type_Spec, NULL);
+    if (state->PredicateType == NULL)
+        return -1;
+    if (PyModule_AddType(m, (PyTypeObject *)state->PredicateType) < 0)
+        return -1;
+
+    PyObject *array = PyImport_ImportModule("array");
+    if (array == NULL)
+        return -1;
+    state->ArrayType = PyObject_GetAttrString(array, "array");
+    Py_DECREF(array);
+    if (state->ArrayType == NULL)
+        return -1;
+
     state->NilType = PyType_FromModuleAndSpec(m, &Nil_Type_Spec, NULL);
     if (state->NilType == NULL)
         return -1;
@@ -766,6 +7085,9 @@ consmodule_exec(PyObject *m)
 
 static PyModuleDef_Slot consmodule_slots[] = {
     {Py_mod_exec, consmodule_exec},
+#ifdef Py_mod_gil
+    {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
     {0, NULL},
 };
 
@@ -774,6 +7096,17 @@ consmodule_traverse(PyObject *m, visitproc visit, void *arg)
 {
     consmodule_state *state = PyModule_GetState(m);
     Py_VISIT(state->ConsType);
+    Py_VISIT(state->ConsIterType);
+    Py_VISIT(state->ConsBuilderType);
+    Py_VISIT(state->ConsIndexType);
+    Py_VISIT(state->ConsCacheType);
+    Py_VISIT(state->ThunkType);
+    Py_VISIT(state->ChunkType);
+    Py_VISIT(state->HamtType);
+    Py_VISIT(state->HamtNodeType);
+    Py_VISIT(state->HamtIterType);
+    Py_VISIT(state->PredicateType);
+    Py_VISIT(state->ArrayType);
     Py_VISIT(state->NilType);
     Py_VISIT(state->nil);
     return 0;
@@ -783,15 +7116,62 @@ static int
 consmodule_clear(PyObject *m)
 {
     consmodule_state *state = PyModule_GetState(m);
+    cons_freelist_clear(state);
     Py_CLEAR(state->ConsType);
+    Py_CLEAR(state->ConsIterType);
+    Py_CLEAR(state->ConsBuilderType);
+    Py_CLEAR(state->ConsIndexType);
+    Py_CLEAR(state->ConsCacheType);
+    Py_CLEAR(state->ThunkType);
+    Py_CLEAR(state->ChunkType);
+    Py_CLEAR(state->HamtType);
+    Py_CLEAR(state->HamtNodeType);
+    Py_CLEAR(state->HamtIterType);
+    Py_CLEAR(state->PredicateType);
+    Py_CLEAR(state->ArrayType);
     Py_CLEAR(state->NilType);
     Py_CLEAR(state->nil);
     return 0;
 }
 
+static void
+consmodule_free(void *m)
+{
+    consmodule_clear((PyObject *)m);
+}
+
 static PyMethodDef consmodule_methods[] = {
-    {"assoc", (PyCFunction)consmodule_assoc, METH_FASTCALL, consmodule_assoc_doc},
+    {"assoc", (PyCFunction)consmodule_assoc, METH_FASTCALL | METH_KEYWORDS,
+     consmodule_assoc_doc},
     {"assp", (PyCFunction)consmodule_assp, METH_FASTCALL, consmodule_assp_doc},
+    {"map", (PyCFunction)consmodule_map, METH_FASTCALL, consmodule_map_doc},
+    {"filter", (PyCFunction)consmodule_filter, METH_FASTCALL, consmodule_filter_doc},
+    {"foldl", (PyCFunction)consmodule_foldl, METH_FASTCALL, consmodule_foldl_doc},
+    {"foldr", (PyCFunction)consmodule_foldr, METH_FASTCALL, consmodule_foldr_doc},
+    {"sum", (PyCFunction)consmodule_sum, METH_FASTCALL, consmodule_sum_doc},
+    {"mean", (PyCFunction)consmodule_mean, METH_FASTCALL, consmodule_mean_doc},
+    {"min", (PyCFunction)consmodule_min, METH_FASTCALL | METH_KEYWORDS, consmodule_min_doc},
+    {"max", (PyCFunction)consmodule_max, METH_FASTCALL | METH_KEYWORDS, consmodule_max_doc},
+    {"count", (PyCFunction)consmodule_count, METH_FASTCALL, consmodule_count_doc},
+    {"reverse", (PyCFunction)consmodule_reverse, METH_FASTCALL, consmodule_reverse_doc},
+    {"append", (PyCFunction)consmodule_append, METH_FASTCALL, consmodule_append_doc},
+    {"take", (PyCFunction)consmodule_take, METH_FASTCALL, consmodule_take_doc},
+    {"drop", (PyCFunction)consmodule_drop, METH_FASTCALL, consmodule_drop_doc},
+    {"zip", (PyCFunction)consmodule_zip, METH_FASTCALL, consmodule_zip_doc},
+    {"last", (PyCFunction)consmodule_last, METH_FASTCALL, consmodule_last_doc},
+    {"flatten", (PyCFunction)consmodule_flatten, METH_FASTCALL, consmodule_flatten_doc},
+    {"sort", (PyCFunction)consmodule_sort, METH_FASTCALL | METH_KEYWORDS,
+     consmodule_sort_doc},
+    {"dumps", (PyCFunction)consmodule_dumps, METH_FASTCALL, consmodule_dumps_doc},
+    {"loads", (PyCFunction)consmodule_loads, METH_FASTCALL, consmodule_loads_doc},
+    {"write_repr", (PyCFunction)consmodule_write_repr, METH_FASTCALL,
+     consmodule_write_repr_doc},
+    {"_from_spine", (PyCFunction)consmodule_from_spine, METH_FASTCALL,
+     consmodule_from_spine_doc},
+    {"freelist_info", (PyCFunction)consmodule_freelist_info, METH_NOARGS,
+     consmodule_freelist_info_doc},
+    {"stats", (PyCFunction)consmodule_stats, METH_FASTCALL | METH_KEYWORDS,
+     consmodule_stats_doc},
     {NULL, NULL},
 };
 
@@ -804,6 +7184,7 @@ static struct PyModuleDef consmodule = {
     .m_slots = consmodule_slots,
     .m_traverse = consmodule_traverse,
     .m_clear = consmodule_clear,
+    .m_free = consmodule_free,
 };
 
 PyMODINIT_FUNC
@@ -1,8 +1,13 @@
-from collections.abc import Callable, Iterable
-from typing import Any, Self
+from collections.abc import Buffer, Callable, Hashable, Iterable, Iterator, Mapping
+from typing import Any, Self, overload
+
+from _typeshed import SupportsWrite
 
 class nil:
     def to_list(self) -> list[Any]: ...
+    def indexed(self) -> cons_index: ...
+    def __iter__(self) -> Iterator[Any]: ...
+    def __len__(self) -> int: ...
 
 class cons:
     head: Any
@@ -10,10 +15,89 @@ class cons:
 
     def __init__(self, head: Any, tail: Any) -> None: ...
     def to_list(self) -> list[Any]: ...
+    def indexed(self) -> cons_index: ...
+    def __iter__(self) -> Iterator[Any]: ...
+    def __len__(self) -> int: ...
     @classmethod
     def from_xs(cls, xs: Iterable[Any]) -> Self | nil: ...
     @classmethod
-    def lift(cls, xs: Any) -> Any | Self | nil: ...
+    def stream(cls, xs: Iterable[Any]) -> Self | nil: ...
+    @classmethod
+    def lift(cls, xs: Any, *, hamt: bool = False) -> Any | Self | nil: ...
+    @classmethod
+    def lower(cls, xs: Any, *, tuples: bool = False, alists: bool = False) -> Any: ...
+    @classmethod
+    def builder(cls) -> cons_builder: ...
+
+class cons_builder:
+    def append(self, item: Any, /) -> None: ...
+    def extend(self, iterable: Iterable[Any], /) -> None: ...
+    def build(self) -> cons | nil: ...
+    def __len__(self) -> int: ...
+
+class cons_index:
+    @property
+    def list(self) -> cons | nil: ...
+    def __len__(self) -> int: ...
+    @overload
+    def __getitem__(self, index: int, /) -> Any: ...
+    @overload
+    def __getitem__(self, index: slice, /) -> cons | nil: ...
+
+class hamt:
+    def __init__(
+        self, mapping_or_alist: Mapping[Any, Any] | Iterable[tuple[Any, Any]] | cons | nil = ..., /
+    ) -> None: ...
+    def __len__(self) -> int: ...
+    def __getitem__(self, key: Hashable) -> Any: ...
+    def __contains__(self, key: object) -> bool: ...
+    def __iter__(self) -> Iterator[Any]: ...
+    def __hash__(self) -> int: ...
+    def get(self, key: Hashable, default: Any = None, /) -> Any: ...
+    def set(self, key: Hashable, value: Any, /) -> Self: ...
+    def delete(self, key: Hashable, /) -> Self: ...
+    def keys(self) -> Iterator[Any]: ...
+    def values(self) -> Iterator[Any]: ...
+    def items(self) -> Iterator[tuple[Any, Any]]: ...
+    def to_alist(self) -> cons | nil: ...
+
+def assoc(object: Any, alist: cons | nil, *, indexed: bool = False) -> cons | nil: ...
+class predicate:
+    def __call__(self, x: Any, /) -> bool: ...
+    @classmethod
+    def is_in(cls, keys: Iterable[Hashable], /) -> Self: ...
+    @classmethod
+    def is_instance(cls, types: type | tuple[type, ...], /) -> Self: ...
+    @classmethod
+    def starts_with(cls, prefix: str | tuple[str, ...], /) -> Self: ...
 
-def assoc(object: Any, alist: cons | nil) -> cons | nil: ...
-def assp(predicate: Callable[[Any], bool], alist: cons | nil) -> cons | nil: ...
+def assp(predicate: Callable[[Any], object], alist: cons | nil) -> cons | nil: ...
+def map(function: Callable[[Any], Any], xs: cons | nil) -> cons | nil: ...
+def filter(predicate: Callable[[Any], Any], xs: cons | nil) -> cons | nil: ...
+def foldl(function: Callable[[Any, Any], Any], initial: Any, xs: cons | nil) -> Any: ...
+def foldr(function: Callable[[Any, Any], Any], initial: Any, xs: cons | nil) -> Any: ...
+def sum(xs: cons | nil, start: Any = 0, /) -> Any: ...
+def mean(xs: cons | nil, /) -> Any: ...
+def min(xs: cons | nil, /, *, default: Any = ...) -> Any: ...
+def max(xs: cons | nil, /, *, default: Any = ...) -> Any: ...
+def count(predicate: Callable[[Any], object], xs: cons | nil) -> int: ...
+def reverse(xs: cons | nil) -> cons | nil: ...
+def append(*lists: Any) -> Any: ...
+def take(n: int, xs: cons | nil) -> cons | nil: ...
+def drop(n: int, xs: cons | nil) -> cons | nil: ...
+def zip(*lists: cons | nil) -> cons | nil: ...
+def last(xs: cons | nil) -> Any: ...
+def flatten(xs: cons | nil) -> cons | nil: ...
+def sort(
+    xs: cons | nil,
+    /,
+    *,
+    key: Callable[[Any], Any] | None = None,
+    reverse: bool = False,
+    alist: bool = False,
+) -> cons | nil: ...
+def dumps(obj: Any, /) -> bytes: ...
+def loads(data: Buffer, /) -> Any: ...
+def write_repr(obj: Any, file: SupportsWrite[str] | SupportsWrite[bytes], /) -> None: ...
+def freelist_info() -> dict[str, int]: ...
+def stats(*, reset: bool = False) -> dict[str, int]: ...
@@ -0,0 +1,500 @@
+"""Benchmarks for fastcons, against the equivalent tuple, list and dict operations.
+
+Run the whole suite with
+
+    python measure/bench.py -o results.json
+
+and compare two result files with
+
+    python -m pyperf compare_to old.json new.json
+
+Every benchmark is timed by pyperf in its own worker processes. It is then run once more
+in a fresh process to record how many cons cells and Python memory blocks its result
+holds, the peak size of the Python memory it allocated, and how much it raised the peak
+RSS. These are stored in the benchmark's metadata (see `python -m pyperf show
+--metadata results.json`).
+
+Besides the usual pyperf options (`--fast`, `--rigorous`, ...), `--sizes` and `--depths`
+set the list lengths and nesting depths, and `--select` runs only the benchmarks whose
+names match a regular expression.
+"""
+
+import copy
+import functools
+import gc
+import io
+import json
+import operator
+import pickle
+import random
+import re
+import subprocess
+import sys
+import time
+import tracemalloc
+from collections.abc import Callable
+from dataclasses import dataclass
+from typing import Any
+
+import fastcons
+from fastcons import cons, dumps, hamt, loads, nil, write_repr
+
+SIZES = "10,1000,100000,10000000"
+DEPTHS = "2,16"
+
+
+@dataclass(frozen=True)
+class Case:
+    """One operation of a benchmark group, as done by fastcons or by a builtin type.
+
+    `setup(n)` makes the operation's input from a list length, or `setup(n, depth)` from
+    a length and a nesting depth if `nested` is set, and `run` takes the input. If
+    `fresh` is set, the operation changes or caches something on its input, so each run
+    gets a new one.
+    """
+
+    group: str
+    impl: str
+    setup: Callable[[int, int], Any]
+    run: Callable[[Any], Any]
+    nested: bool = False
+    fresh: bool = False
+
+
+def make_input(case, n, depth):
+    return case.setup(n, depth) if case.nested else case.setup(n)
+
+
+def flat(n):
+    return list(range(n))
+
+
+def nested(n, depth):
+    """A list of lists, `depth` levels deep, with about n ints at the bottom."""
+    width = int(n ** (1 / depth))
+    level = list(range(n // width ** (depth - 1)))
+    for _ in range(depth - 1):
+        level = [copy.deepcopy(level) for _ in range(width)]
+    return level
+
+
+def pairs(n):
+    return [(i, str(i)) for i in range(n)]
+
+
+def linked(items):
+    """The items as nested 2-tuples, the nearest builtin equivalent to a cons list."""
+    result = ()
+    for x in reversed(items):
+        result = (x, result)
+    return result
+
+
+def walk_linked(xs):
+    while xs:
+        xs = xs[1]
+
+
+def walk_cons(xs):
+    while xs is not nil():
+        xs = xs.tail
+
+
+def lookup(key, items):
+    return next((v for k, v in items if k == key), None)
+
+
+def ints(n):
+    return tuple(range(n))
+
+
+def floats(n):
+    return tuple(i * 0.5 for i in range(n))
+
+
+def cons_ints(n):
+    return cons.from_xs(range(n))
+
+
+def cons_floats(n):
+    return cons.from_xs(floats(n))
+
+
+def lifted(n, depth):
+    return cons.lift(nested(n, depth))
+
+
+def lifted_tuples(n, depth):
+    return cons.lower(lifted(n, depth), tuples=True)
+
+
+def alist(n):
+    return cons.from_xs([cons(k, v) for k, v in pairs(n)])
+
+
+def shuffled(n):
+    items = list(range(n))
+    random.Random(0).shuffle(items)
+    return tuple(items)
+
+
+def cons_shuffled(n):
+    return cons.from_xs(shuffled(n))
+
+
+def cases():
+    """Pairs of cases per group, with fastcons first."""
+    return [
+        # Building
+        Case("from_xs-list", "fastcons", flat, cons.from_xs),
+        Case("from_xs-list", "tuple", flat, tuple),
+        Case("from_xs-range", "fastcons", lambda n: range(n), cons.from_xs),
+        Case("from_xs-range", "list", lambda n: range(n), list),
+        Case("from_xs-iter", "fastcons", flat, lambda xs: cons.from_xs(iter(xs))),
+        Case("from_xs-iter", "list", flat, lambda xs: list(iter(xs))),
+        Case("from_xs-bytes", "fastcons", lambda n: bytes(n), cons.from_xs),
+        Case("from_xs-bytes", "list", lambda n: bytes(n), list),
+        Case("stream", "fastcons", flat, lambda xs: len(cons.stream(iter(xs)))),
+        Case("stream", "list", flat, lambda xs: len(list(iter(xs)))),
+        Case(
+            "cons", "fastcons", flat, lambda xs: functools.reduce(cons_onto, xs, nil())
+        ),
+        Case("cons", "tuple", flat, lambda xs: functools.reduce(tuple_onto, xs, ())),
+        Case("builder", "fastcons", flat, build),
+        Case("builder", "list", flat, build_list),
+        Case("lift", "fastcons", nested, cons.lift, nested=True),
+        Case("lift", "list", nested, copy.deepcopy, nested=True),
+        # Reading
+        Case("iterate", "fastcons", cons_ints, list),
+        Case("iterate", "tuple", ints, list),
+        Case("to_list", "fastcons", cons_ints, lambda xs: xs.to_list()),
+        Case("to_list", "tuple", ints, list),
+        Case("indexed", "fastcons", cons_ints, middle_of_index, fresh=True),
+        Case("indexed", "tuple", ints, lambda xs: list(xs)[len(xs) // 2]),
+        Case("tail", "fastcons", cons_ints, walk_cons),
+        Case("tail", "tuple", lambda n: linked(range(n)), walk_linked),
+        Case("lower", "fastcons", lifted, lower, nested=True),
+        Case("lower", "list", nested, copy.deepcopy, nested=True),
+        Case("repr", "fastcons", lifted, repr, nested=True),
+        Case("repr", "list", nested, repr, nested=True),
+        Case("hash", "fastcons", lifted, hash, nested=True, fresh=True),
+        Case("hash", "tuple", lifted_tuples, hash, nested=True),
+        Case(
+            "eq", "fastcons", lambda n, d: (lifted(n, d), lifted(n, d)), eq, nested=True
+        ),
+        Case("eq", "list", lambda n, d: (nested(n, d), nested(n, d)), eq, nested=True),
+        # Association lists and maps, looking up the last key
+        Case("assoc", "fastcons", alist, lambda xs: fastcons.assoc(len(xs) - 1, xs)),
+        Case("assoc", "list", lambda n: pairs(n), lambda xs: lookup(len(xs) - 1, xs)),
+        Case(
+            "assoc-indexed",
+            "fastcons",
+            alist,
+            lambda xs: fastcons.assoc(len(xs) - 1, xs, indexed=True),
+        ),
+        Case(
+            "assoc-indexed",
+            "dict",
+            lambda n: dict(pairs(n)),
+            lambda m: m.get(len(m) - 1),
+        ),
+        Case("assp", "fastcons", alist, assp_last),
+        Case("assp", "list", lambda n: pairs(n), find_last),
+        Case("hamt", "fastcons", lambda n: dict(pairs(n)), hamt),
+        Case("hamt", "dict", lambda n: dict(pairs(n)), dict),
+        Case(
+            "hamt-get",
+            "fastcons",
+            lambda n: hamt(pairs(n)),
+            lambda m: m.get(len(m) - 1),
+        ),
+        Case("hamt-get", "dict", lambda n: dict(pairs(n)), lambda m: m.get(len(m) - 1)),
+        # Higher-order functions and reductions
+        Case("map", "fastcons", cons_ints, lambda xs: fastcons.map(abs, xs)),
+        Case("map", "list", ints, lambda xs: list(map(abs, xs))),
+        Case("filter", "fastcons", cons_ints, lambda xs: fastcons.filter(bool, xs)),
+        Case("filter", "list", ints, lambda xs: list(filter(bool, xs))),
+        Case(
+            "foldl",
+            "fastcons",
+            cons_ints,
+            lambda xs: fastcons.foldl(operator.add, 0, xs),
+        ),
+        Case("foldl", "tuple", ints, lambda xs: functools.reduce(operator.add, xs, 0)),
+        Case(
+            "foldr",
+            "fastcons",
+            cons_ints,
+            lambda xs: fastcons.foldr(operator.add, 0, xs),
+        ),
+        Case(
+            "foldr", "tuple", ints, lambda xs: functools.reduce(radd, reversed(xs), 0)
+        ),
+        Case("sum-int", "fastcons", cons_ints, fastcons.sum),
+        Case("sum-int", "tuple", ints, sum),
+        Case("sum-float", "fastcons", cons_floats, fastcons.sum),
+        Case("sum-float", "tuple", floats, sum),
+        Case("mean-float", "fastcons", cons_floats, fastcons.mean),
+        Case("mean-float", "tuple", floats, lambda xs: sum(xs) / len(xs)),
+        Case("min", "fastcons", cons_ints, fastcons.min),
+        Case("min", "tuple", ints, min),
+        Case("max-float", "fastcons", cons_floats, fastcons.max),
+        Case("max-float", "tuple", floats, max),
+        Case("count", "fastcons", cons_ints, lambda xs: fastcons.count(bool, xs)),
+        Case("count", "tuple", ints, lambda xs: sum(map(bool, xs))),
+        # List algebra and sorting
+        Case("reverse", "fastcons", cons_ints, fastcons.reverse),
+        Case("reverse", "tuple", ints, lambda xs: xs[::-1]),
+        Case(
+            "append",
+            "fastcons",
+            lambda n: (cons_ints(n), cons_ints(n)),
+            lambda p: fastcons.append(*p),
+        ),
+        Case("append", "tuple", lambda n: (ints(n), ints(n)), lambda p: p[0] + p[1]),
+        Case("take", "fastcons", cons_ints, lambda xs: fastcons.take(len(xs) // 2, xs)),
+        Case("take", "tuple", ints, lambda xs: xs[: len(xs) // 2]),
+        Case("drop", "fastcons", cons_ints, lambda xs: fastcons.drop(len(xs) // 2, xs)),
+        Case("drop", "tuple", ints, lambda xs: xs[len(xs) // 2 :]),
+        Case(
+            "zip",
+            "fastcons",
+            lambda n: (cons_ints(n), cons_ints(n)),
+            lambda p: fastcons.zip(*p),
+        ),
+        Case("zip", "tuple", lambda n: (ints(n), ints(n)), lambda p: tuple(zip(*p))),
+        Case("flatten", "fastcons", lifted, fastcons.flatten, nested=True),
+        Case("flatten", "list", nested, flatten_list, nested=True),
+        Case("sort", "fastcons", cons_shuffled, fastcons.sort),
+        Case("sort", "tuple", shuffled, sorted),
+        # Serialization
+        Case("dumps", "fastcons", lifted, dumps, nested=True),
+        Case("dumps", "list", nested, pickle.dumps, nested=True),
+        Case("loads", "fastcons", lambda n, d: dumps(lifted(n, d)), loads, nested=True),
+        Case(
+            "loads",
+            "list",
+            lambda n, d: pickle.dumps(nested(n, d)),
+            pickle.loads,
+            nested=True,
+        ),
+        Case("pickle", "fastcons", cons_ints, pickle.dumps),
+        Case("pickle", "tuple", ints, pickle.dumps),
+        Case(
+            "write_repr",
+            "fastcons",
+            lifted,
+            lambda xs: write_repr(xs, io.StringIO()),
+            nested=True,
+        ),
+        Case(
+            "write_repr",
+            "list",
+            nested,
+            lambda xs: io.StringIO().write(repr(xs)),
+            nested=True,
+        ),
+    ]
+
+
+def lower(xs):
+    return cons.lower(xs)
+
+
+def build(xs):
+    builder = cons.builder()
+    for x in xs:
+        builder.append(x)
+    return builder.build()
+
+
+def build_list(xs):
+    result = []
+    for x in xs:
+        result.append(x)
+    return result
+
+
+def middle_of_index(xs):
+    view = xs.indexed()
+    return view[len(view) // 2]
+
+
+def assp_last(xs):
+    return fastcons.assp((len(xs) - 1).__eq__, xs)
+
+
+def find_last(items):
+    key = len(items) - 1
+    return next((pair for pair in items if key.__eq__(pair[0])), None)
+
+
+def flatten_list(xs):
+    """The atoms of nested lists in order, without recursing."""
+    result, stack = [], [iter(xs)]
+    while stack:
+        for x in stack[-1]:
+            if isinstance(x, list):
+                stack.append(iter(x))
+                break
+            result.append(x)
+        else:
+            stack.pop()
+    return result
+
+
+def radd(acc, x):
+    return x + acc
+
+
+def cons_onto(xs, x):
+    return cons(x, xs)
+
+
+def tuple_onto(xs, x):
+    return (x, xs)
+
+
+def eq(pair):
+    return pair[0] == pair[1]
+
+
+def parse_ints(text):
+    return [int(x) for x in text.split(",")]
+
+
+def instances(args):
+    """The (name, case, n, depth) of each benchmark to run."""
+    select = re.compile(args.select)
+    for case in cases():
+        for n in parse_ints(args.sizes):
+            for depth in parse_ints(args.depths) if case.nested else [1]:
+                name = f"{case.group}/{case.impl}/n={n}"
+                if case.nested:
+                    name += f"/depth={depth}"
+                if select.search(name):
+                    yield name, case, n, depth
+
+
+# Inputs, made on first use so that each worker only makes its own benchmark's
+INPUTS = {}
+
+
+def time_case(loops, case, n, depth):
+    if not case.fresh:
+        key = (case, n, depth)
+        if key not in INPUTS:
+            INPUTS[key] = make_input(case, n, depth)
+        arg = INPUTS[key]
+        run = case.run
+        start = time.perf_counter()
+        for _ in range(loops):
+            run(arg)
+        return time.perf_counter() - start
+
+    elapsed = 0.0
+    for _ in range(loops):
+        arg = make_input(case, n, depth)
+        start = time.perf_counter()
+        case.run(arg)
+        elapsed += time.perf_counter() - start
+    return elapsed
+
+
+def allocated_cells():
+    info = fastcons.freelist_info()
+    return info["hits"] + info["misses"]
+
+
+def peak_rss_kib():
+    import resource
+
+    peak = resource.getrusage(resource.RUSAGE_SELF).ru_maxrss
+    return peak // 1024 if sys.platform == "darwin" else peak
+
+
+def probe(case, n, depth):
+    """Memory statistics of one run of a case, meant to be taken in a fresh process."""
+    arg = make_input(case, n, depth)
+    gc.collect()
+    rss, blocks, cells = peak_rss_kib(), sys.getallocatedblocks(), allocated_cells()
+    result = case.run(arg)
+    stats = {
+        "cons_cells": allocated_cells() - cells,
+        "py_blocks": sys.getallocatedblocks() - blocks,
+        "peak_rss_kib": peak_rss_kib() - rss,
+    }
+    del result
+    if case.fresh:
+        arg = make_input(case, n, depth)
+    tracemalloc.start()
+    case.run(arg)
+    stats["alloc_peak_bytes"] = tracemalloc.get_traced_memory()[1]
+    tracemalloc.stop()
+    return stats
+
+
+def probe_in_subprocess(case, n, depth):
+    command = [
+        sys.executable,
+        __file__,
+        "--probe",
+        case.group,
+        case.impl,
+        str(n),
+        str(depth),
+    ]
+    output = subprocess.run(command, check=True, capture_output=True, text=True).stdout
+    return json.loads(output)
+
+
+def probe_main(group, impl, n, depth):
+    (case,) = [case for case in cases() if (case.group, case.impl) == (group, impl)]
+    json.dump(probe(case, int(n), int(depth)), sys.stdout)
+
+
+def add_cmdline_args(cmd, args):
+    cmd.extend(
+        ["--sizes", args.sizes, "--depths", args.depths, "--select", args.select]
+    )
+
+
+def main():
+    import pyperf
+
+    runner = pyperf.Runner(add_cmdline_args=add_cmdline_args)
+    runner.argparser.add_argument(
+        "--sizes", default=SIZES, help=f"comma-separated list lengths (default {SIZES})"
+    )
+    runner.argparser.add_argument(
+        "--depths",
+        default=DEPTHS,
+        help=f"comma-separated nesting depths for nested data (default {DEPTHS})",
+    )
+    runner.argparser.add_argument(
+        "--select", default="", help="only run benchmarks whose names match this regex"
+    )
+    args = runner.parse_args()
+
+    benchmarks = []
+    for name, case, n, depth in instances(args):
+        bench = runner.bench_time_func(name, time_case, case, n, depth)
+        if bench is None or args.worker:
+            continue
+        metadata = {"group": case.group, "impl": case.impl, "size": n}
+        if case.nested:
+            metadata["depth"] = depth
+        metadata.update(probe_in_subprocess(case, n, depth))
+        bench.update_metadata(metadata)
+        benchmarks.append(bench)
+
+    # pyperf writes each benchmark as it finishes, rewrite them with their memory stats
+    if not args.worker and args.output and benchmarks:
+        pyperf.BenchmarkSuite(benchmarks).dump(args.output, replace=True)
+
+
+if __name__ == "__main__":
+    if sys.argv[1:2] == ["--probe"]:
+        probe_main(*sys.argv[2:])
+    else:
+        main()
@@ -5,6 +5,9 @@ from setuptools import Extension, setup
 
 DEBUG = int(os.environ.get("CONS_DEBUG", 0)) == 1
 DEBUG_LEVEL = 0
+# Set CONS_STATS=0 to compile out the counters reported by fastcons.stats(), or
+# CONS_STATS=1 to keep them in free-threaded builds, where they're off by default
+STATS = os.environ.get("CONS_STATS")
 
 # Common flags for both release and debug builds.
 extra_compile_args = sysconfig.get_config_var("CFLAGS").split()
@@ -26,6 +29,8 @@ if DEBUG:
     ]
 else:
     extra_compile_args += ["-DNDEBUG", "-O3"]
+if STATS is not None:
+    extra_compile_args += [f"-DCONS_STATS={int(STATS)}"]
 
 
 setup(
@@ -0,0 +1,22 @@
+"""List builders shared by the tests, for checking each list representation."""
+
+from fastcons import cons, nil
+
+
+def cells(xs):
+    """Build a list of the items of xs one cell at a time, rather than as a chunk."""
+    result = nil()
+    for x in reversed(list(xs)):
+        result = cons(x, result)
+    return result
+
+
+def partly_forced(xs, n=3):
+    """Build a chunked list of the items of xs, with up to n of its tails made."""
+    ys = cons.from_xs(xs)
+    cell = ys
+    for _ in range(n):
+        if cell is nil():
+            break
+        cell = cell.tail
+    return ys
@@ -0,0 +1,177 @@
+import pytest
+from fastcons import append, cons, drop, flatten, last, nil, reverse, take, zip
+
+from helpers import cells, partly_forced
+
+BUILDERS = [cons.from_xs, cells, partly_forced]
+SIZES = [0, 1, 2, 15, 16, 50]
+
+
+def check_lengths(xs):
+    """Check that every cell of a proper list stores its own length."""
+    n = len(list(xs))
+    while xs is not nil():
+        assert len(xs) == n
+        xs, n = xs.tail, n - 1
+
+
+@pytest.mark.parametrize("build", BUILDERS)
+@pytest.mark.parametrize("n", SIZES)
+def test_reverse(build, n):
+    result = reverse(build(range(n)))
+    assert list(result) == list(range(n))[::-1]
+    check_lengths(result)
+
+
+def test_reverse_of_one_is_itself():
+    xs = cons(1, nil())
+    assert reverse(xs) is xs
+    assert reverse(nil()) is nil()
+
+
+@pytest.mark.parametrize("build", BUILDERS)
+@pytest.mark.parametrize("n", SIZES)
+def test_append(build, n):
+    xs, ys = build(range(n)), cells("abc")
+    result = append(xs, ys)
+    assert list(result) == [*range(n), "a", "b", "c"]
+    check_lengths(result)
+    tail = result
+    for _ in range(n):
+        tail = tail.tail
+    assert tail is ys
+
+
+def test_append_many():
+    result = append(cells([1]), nil(), cons.from_xs(range(2, 20)), nil())
+    assert list(result) == list(range(1, 20))
+    check_lengths(result)
+
+
+def test_append_shares_single_and_empty_prefixes():
+    xs = cons.from_xs(range(20))
+    assert append() is nil()
+    assert append(xs) is xs
+    assert append(nil(), nil(), xs) is xs
+
+
+def test_append_improper_tail():
+    result = append(cells([1, 2]), 3)
+    assert result == cons(1, cons(2, 3))
+    with pytest.raises(TypeError):
+        len(result)
+    stream = cons.stream(iter("ab"))
+    assert list(append(cells([1]), stream)) == [1, "a", "b"]
+
+
+def test_append_requires_proper_prefixes():
+    with pytest.raises(ValueError, match="proper cons list"):
+        append(cons(1, 2), nil())
+    with pytest.raises(ValueError, match="proper cons list"):
+        append(cons.stream(iter("ab")), nil())
+
+
+@pytest.mark.parametrize("build", BUILDERS)
+@pytest.mark.parametrize("n", [0, 1, 10, 20, 49])
+def test_take_and_drop(build, n):
+    xs = build(range(50))
+    assert list(take(n, xs)) == list(range(n))
+    assert list(drop(n, xs)) == list(range(n, 50))
+    check_lengths(take(n, xs))
+    check_lengths(drop(n, xs))
+
+
+def test_take_and_drop_past_the_end():
+    xs = cons.from_xs(range(20))
+    assert take(20, xs) is xs
+    assert take(100, xs) is xs
+    assert drop(20, xs) is nil()
+    assert drop(0, xs) is xs
+    assert take(0, xs) is nil()
+    assert take(3, nil()) is nil()
+    assert drop(3, nil()) is nil()
+
+
+def test_drop_shares_existing_cells():
+    xs = cells(range(10))
+    assert drop(3, xs) is xs.tail.tail.tail
+    # Until a bulk-built list's cells are made, drop makes one sharing its chunk
+    ys = cons.from_xs(range(20))
+    assert drop(2, ys) is not ys.tail.tail
+    assert drop(2, ys) is ys.tail.tail
+
+
+def test_take_and_drop_streams():
+    def naturals():
+        n = 0
+        while True:
+            yield n
+            n += 1
+
+    assert list(take(3, cons.stream(naturals()))) == [0, 1, 2]
+    assert drop(3, cons.stream(naturals())).head == 3
+    short = cons.stream(iter("ab"))
+    assert take(5, short) is short
+    assert drop(5, cons.stream(iter("ab"))) is nil()
+
+
+@pytest.mark.parametrize("n", [-1, 1.5, "1"])
+def test_take_and_drop_bad_counts(n):
+    with pytest.raises((TypeError, ValueError)):
+        take(n, cons.from_xs(range(3)))
+    with pytest.raises((TypeError, ValueError)):
+        drop(n, cons.from_xs(range(3)))
+
+
+@pytest.mark.parametrize("build", BUILDERS)
+def test_zip(build):
+    xs, ys = build(range(30)), cells("abc")
+    result = zip(xs, ys)
+    assert list(result) == [(0, "a"), (1, "b"), (2, "c")]
+    check_lengths(result)
+    assert list(zip(xs)) == [(i,) for i in range(30)]
+    assert list(zip(xs, xs)) == [(i, i) for i in range(30)]
+    assert zip() is nil()
+    assert zip(xs, nil()) is nil()
+
+
+@pytest.mark.parametrize("build", BUILDERS)
+@pytest.mark.parametrize("n", [1, 2, 16, 50])
+def test_last(build, n):
+    assert last(build(range(n))) == n - 1
+    assert last(cons(-1, build(range(n)))) == n - 1
+
+
+def test_last_of_nil():
+    with pytest.raises(ValueError, match="empty"):
+        last(nil())
+
+
+def test_flatten():
+    xs = cons.lift([1, [2, [3, []], 4], [[[5]]], list(range(6, 30)), [], 30])
+    result = flatten(xs)
+    assert list(result) == list(range(1, 31))
+    check_lengths(result)
+    assert flatten(nil()) is nil()
+    assert flatten(cons.lift([[], [[]]])) is nil()
+
+
+def test_flatten_keeps_pairs_and_streams():
+    pair = cons(1, 2)
+    stream = cons.stream(iter("ab"))
+    result = flatten(cells([pair, cells([stream, (3,)])]))
+    assert list(result) == [pair, stream, (3,)]
+
+
+def test_flatten_deep_nesting():
+    xs = cons(0, nil())
+    for i in range(1, 100_000):
+        xs = cons(xs, cons(i, nil()))
+    assert list(flatten(xs)) == list(range(100_000))
+
+
+@pytest.mark.parametrize("kernel", [reverse, last, flatten, lambda xs: zip(xs)])
+@pytest.mark.parametrize("xs", [cons(1, 2), cons.stream(range(3)), [1, 2]])
+def test_kernels_require_proper_lists(kernel, xs):
+    with pytest.raises(ValueError, match="proper cons list"):
+        kernel(xs)
@@ -1,5 +1,8 @@
+import functools
+import operator
+
 import pytest
-from fastcons import assoc, assp, cons, nil
+from fastcons import assoc, assp, cons, filter, nil, predicate
 
 
 @pytest.mark.parametrize(
@@ -18,6 +21,56 @@ from fastcons import assoc, assp, cons, nil
 )
 def test_assoc(x, xs, expected):
     assert assoc(x, xs) == expected
+    assert assoc(x, xs, indexed=True) == expected
+
+
+def test_assoc_indexed_returns_first_pair():
+    first = cons("a", 1)
+    alist = cons.from_xs([cons("b", 0), first, cons("a", 2)])
+    assert assoc("a", alist, indexed=True) is first
+    assert assoc("a", alist, indexed=True) is first
+    assert assoc("a", alist.tail.tail, indexed=True).tail == 2
+
+
+def test_assoc_indexed_large():
+    alist = cons.lift({i: str(i) for i in range(10_000)})
+    for i in range(0, 10_000, 7):
+        assert assoc(i, alist, indexed=True) == cons(i, str(i))
+    assert assoc(-1, alist, indexed=True) is nil()
+    assert assoc(1.0, alist, indexed=True) == cons(1, "1")
+
+
+def test_assoc_indexed_unhashable_keys():
+    alist = cons.from_xs([cons([1], "a"), cons("b", "c")])
+    assert assoc([1], alist, indexed=True) == cons([1], "a")
+    assert assoc("b", alist, indexed=True) == cons("b", "c")
+
+
+def test_assoc_indexed_unhashable_object():
+    alist = cons.from_xs([cons("a", 1)])
+    assert assoc([1], alist, indexed=True) is nil()
+
+
+@pytest.mark.parametrize("indexed", [False, True])
+def test_assoc_malformed(indexed):
+    with pytest.raises(ValueError):
+        assoc("a", cons.from_xs([cons("b", 1), 2]), indexed=indexed)
+
+
+def test_assoc_compare_error():
+    class Bad:
+        def __eq__(self, other):
+            raise RuntimeError("boom")
+
+        __hash__ = object.__hash__
+
+    with pytest.raises(RuntimeError):
+        assoc(Bad(), cons.from_xs([cons("a", 1)]))
+
+
+def test_assoc_bad_keyword():
+    with pytest.raises(TypeError):
+        assoc("a", nil(), index=True)
 
 
 @pytest.mark.parametrize(
@@ -60,3 +113,94 @@ def test_assp(predicate, xs, expected):
 def test_assp_predicate_kwonly_raises():
     with pytest.raises(TypeError):
         assp(lambda *, x: x is x, cons.lift({"foo": "bar", "baz": "quux"}))
+
+
+@pytest.mark.parametrize(
+    "predicate",
+    [
+        functools.partial(operator.eq, "baz"),
+        "baz".__eq__,
+        {"baz"}.__contains__,
+    ],
+)
+def test_assp_any_callable(predicate):
+    alist = cons.lift({"foo": "bar", "baz": "quux"})
+    assert assp(predicate, alist) == cons("baz", "quux")
+
+
+@pytest.mark.parametrize("alist", [cons.lift({"foo": "bar"}), nil()])
+def test_assp_not_callable(alist):
+    with pytest.raises(TypeError, match="callable"):
+        assp("foo", alist)
+
+
+def test_assp_predicate_error():
+    def predicate(x):
+        raise RuntimeError("boom")
+
+    with pytest.raises(RuntimeError):
+        assp(predicate, cons.lift({"foo": "bar"}))
+
+
+def test_assp_truthiness_error():
+    class Bad:
+        def __bool__(self):
+            raise RuntimeError("boom")
+
+    with pytest.raises(RuntimeError):
+        assp(lambda x: Bad(), cons.lift({"foo": "bar"}))
+
+
+def test_assp_malformed():
+    with pytest.raises(ValueError):
+        assp(lambda x: False, cons.from_xs([cons("a", 1), 2]))
+
+
+@pytest.mark.parametrize(
+    ("pred", "key", "other"),
+    [
+        (predicate.is_in(["b", 3]), 3, "a"),
+        (predicate.is_in({"b"}), "b", "a"),
+        (predicate.is_instance(int), 3, "a"),
+        (predicate.is_instance((float, int)), 3, "a"),
+        (predicate.starts_with("ba"), "baz", "foo"),
+        (predicate.starts_with(("x", "ba")), "baz", "foo"),
+    ],
+)
+def test_native_predicates(pred, key, other):
+    alist = cons.from_xs([cons(other, 0), cons(key, 1), cons(key, 2)])
+    assert assp(pred, alist) == cons(key, 1)
+    assert assp(pred, cons.from_xs([cons(other, 0)])) is nil()
+    assert pred(key) is True
+    assert pred(other) is False
+    assert filter(pred, cons.from_xs([other, key, other])) == cons(key, nil())
+
+
+def test_starts_with_ignores_non_str():
+    assert assp(predicate.starts_with("a"), cons.lift({1: 0, b"ab": 1, "ab": 2})) == cons("ab", 2)
+
+
+def test_is_in_unhashable():
+    with pytest.raises(TypeError):
+        assp(predicate.is_in(["a"]), cons.from_xs([cons([1], 0)]))
+
+
+@pytest.mark.parametrize(
+    ("factory", "arg"),
+    [
+        (predicate.is_instance, 1),
+        (predicate.is_instance, ()),
+        (predicate.starts_with, b"a"),
+        (predicate.starts_with, ("a", 1)),
+        (predicate.is_in, 1),
+        (predicate.is_in, [[1]]),
+    ],
+)
+def test_native_predicate_bad_argument(factory, arg):
+    with pytest.raises(TypeError):
+        factory(arg)
+
+
+def test_native_predicate_repr():
+    assert repr(predicate.starts_with("a")) == "predicate.starts_with('a')"
+    assert repr(predicate.is_instance(int)) == "predicate.is_instance(<class 'int'>)"
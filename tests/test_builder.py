@@ -0,0 +1,93 @@
+import gc
+import weakref
+
+import pytest
+from fastcons import cons, nil
+
+
+@pytest.mark.parametrize("n", [0, 1, 15, 16, 1000])
+def test_builder_builds_proper_list(n):
+    builder = cons.builder()
+    for i in range(n):
+        builder.append(i)
+    assert len(builder) == n
+    xs = builder.build()
+    assert xs == cons.from_xs(range(n))
+    assert len(xs) == n
+    assert list(xs) == list(range(n))
+
+
+def test_build_resets_builder():
+    builder = cons.builder()
+    builder.append(1)
+    xs = builder.build()
+    assert len(builder) == 0
+    assert builder.build() is nil()
+    builder.append(2)
+    assert builder.build() == cons(2, nil())
+    assert xs == cons(1, nil())
+
+
+def test_builder_extend():
+    builder = cons.builder()
+    builder.extend([1, 2])
+    builder.append(3)
+    builder.extend(x for x in range(4, 30))
+    assert builder.build() == cons.from_xs(range(1, 30))
+
+
+def test_builder_extend_error():
+    def gen():
+        yield 1
+        raise RuntimeError("boom")
+
+    builder = cons.builder()
+    with pytest.raises(RuntimeError):
+        builder.extend(gen())
+    assert builder.build() == cons(1, nil())
+    with pytest.raises(TypeError):
+        builder.extend(1)
+
+
+def test_builder_cycle_is_collected():
+    class Box:
+        pass
+
+    builder = cons.builder()
+    box = Box()
+    box.builder = builder
+    builder.append(box)
+    ref = weakref.ref(box)
+    del builder, box
+    gc.collect()
+    assert ref() is None
+
+
+def test_builder_cannot_be_instantiated():
+    with pytest.raises(TypeError):
+        type(cons.builder())()
+    with pytest.raises(TypeError):
+        cons.builder(1)
+
+
+@pytest.mark.parametrize(
+    ("args", "kwargs"),
+    [((1, 2), {}), ((1,), {"tail": 2}), ((), {"head": 1, "tail": 2})],
+)
+def test_cons_call_forms(args, kwargs):
+    assert cons(*args, **kwargs) == cons(1, 2)
+
+
+def test_cons_call_sets_length():
+    assert len(cons(1, nil())) == 1
+    assert len(cons(1, tail=cons(2, nil()))) == 2
+    assert len(cons.__new__(cons, 0, cons.from_xs(range(20)))) == 21
+
+
+@pytest.mark.parametrize(
+    ("args", "kwargs"),
+    [((), {}), ((1,), {}), ((1, 2, 3), {}), ((1,), {"head": 2}), ((1,), {"x": 2})],
+)
+def test_cons_bad_calls(args, kwargs):
+    with pytest.raises(TypeError):
+        cons(*args, **kwargs)
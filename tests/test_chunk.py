@@ -0,0 +1,206 @@
+import gc
+import pickle
+import sysconfig
+import weakref
+
+import fastcons
+import pytest
+from fastcons import cons, dumps, freelist_info, hamt, loads, nil, stats
+
+from helpers import cells
+
+# Free-threaded builds only count allocations along with the other stats
+counts_allocations = pytest.mark.skipif(
+    bool(sysconfig.get_config_var("Py_GIL_DISABLED")) and not stats()["enabled"],
+    reason="built without allocation counters",
+)
+
+
+def allocated():
+    """The number of cells allocated so far."""
+    info = freelist_info()
+    return info["hits"] + info["misses"]
+
+
+BUILDERS = [
+    lambda n: cons.from_xs(list(range(n))),
+    lambda n: cons.from_xs(range(n)),
+    lambda n: cons.from_xs(x for x in range(n)),
+    lambda n: cons.from_xs(bytes(range(n))),
+    lambda n: cons.lift(list(range(n))),
+    lambda n: cons.lift(iter(range(n))),
+]
+
+
+@counts_allocations
+@pytest.mark.parametrize("build", BUILDERS)
+def test_bulk_built_list_is_one_cell(build):
+    before = allocated()
+    xs = build(100)
+    assert allocated() - before == 1
+    assert len(xs) == 100
+
+
+@counts_allocations
+@pytest.mark.parametrize("build", BUILDERS)
+def test_reading_does_not_make_cells(build):
+    xs, expected = build(100), cells(range(100))
+    before = allocated()
+    assert list(xs) == list(range(100))
+    assert xs.to_list() == list(range(100))
+    assert repr(xs) == repr(expected)
+    assert xs == expected
+    assert hash(xs) == hash(expected)
+    assert allocated() - before == 0
+
+
+@counts_allocations
+def test_map_result_is_one_cell():
+    xs = cons.from_xs(range(100))
+    before = allocated()
+    mapped = fastcons.map(str, xs)
+    assert allocated() - before == 1
+    assert mapped == cells(map(str, range(100)))
+
+
+@counts_allocations
+def test_short_lists_are_cells():
+    before = allocated()
+    xs = cons.from_xs(range(3))
+    assert allocated() - before == 3
+    assert xs == cells(range(3))
+
+
+def test_tail_makes_cells_on_demand():
+    xs = cons.from_xs(range(20))
+    tail = xs.tail
+    assert tail is xs.tail
+    assert tail.head == 1
+    assert len(tail) == 19
+    assert tail.tail.tail.head == 3
+
+    last = xs
+    for i in range(19):
+        last = last.tail
+    assert last.head == 19
+    assert last.tail is nil()
+
+
+def test_chunked_list_matches_cells():
+    xs, ys = cons.from_xs(range(50)), cells(range(50))
+    assert xs == ys
+    assert hash(xs) == hash(ys)
+    assert repr(xs) == repr(ys)
+    assert xs.tail.tail == ys.tail.tail
+    assert hash(xs.tail.tail) == hash(ys.tail.tail)
+
+
+def test_partly_forced_list_reads_correctly():
+    xs = cons.from_xs(range(30))
+    xs.tail.tail.tail
+    assert list(xs) == list(range(30))
+    assert xs.to_list() == list(range(30))
+    assert xs == cells(range(30))
+    assert len(xs.tail.tail.tail) == 27
+
+
+def test_comparisons_read_chunks():
+    xs = cons.from_xs(range(30))
+    assert xs < cons.from_xs(range(31))
+    assert xs > cons.from_xs(range(29))
+    assert xs < cons.from_xs([*range(29), 30])
+    assert xs != cons.from_xs([*range(29), 30])
+    assert xs == cons(0, cons.from_xs(range(1, 30)))
+    assert cons.from_xs(range(20)) != cons(0, cons(1, 2))
+    with pytest.raises(TypeError):
+        assert cons.from_xs(range(20)) < cons(0, cons(1, 2))
+
+
+def test_nested_chunks_compare_and_hash():
+    inner = [list(range(i, i + 20)) for i in range(20)]
+    xs, ys = cons.lift(inner), cons.lift(inner)
+    assert xs == ys
+    assert hash(xs) == hash(ys)
+    inner[-1][-1] = -1
+    assert cons.lift(inner) < xs
+
+
+def test_iterator_keeps_items_alive():
+    class Item:
+        pass
+
+    xs = cons.from_xs([Item() for _ in range(20)])
+    it = iter(xs)
+    next(it)
+    # Forcing every tail drops the list's reference to its chunk
+    cell = xs
+    while cell.tail is not nil():
+        cell = cell.tail
+    assert len(list(it)) == 19
+    assert it.__length_hint__() == 0
+
+
+def test_length_hint():
+    it = iter(cons.from_xs(range(20)))
+    assert it.__length_hint__() == 20
+    next(it)
+    next(it)
+    assert it.__length_hint__() == 18
+
+
+def test_folds_and_filter_read_chunks():
+    xs = cons.from_xs(range(100))
+    assert fastcons.foldl(lambda acc, x: acc + [x], [], xs) == list(range(100))
+    assert fastcons.foldr(lambda x, acc: [x, *acc], [], xs) == list(range(100))
+    assert fastcons.filter(lambda x: x % 2, xs) == cons.from_xs(range(1, 100, 2))
+
+
+def test_assoc_on_chunked_alist():
+    alist = cons.from_xs([cons(i, str(i)) for i in range(50)])
+    assert fastcons.assoc(42, alist) == cons(42, "42")
+    assert fastcons.assoc(42, alist, indexed=True) == cons(42, "42")
+    assert fastcons.assoc(99, alist) is nil()
+    assert fastcons.assp(lambda k: k > 48, alist) == cons(49, "49")
+    assert hamt(alist)[7] == "7"
+
+
+def test_lift_and_lower_roundtrip():
+    obj = {"a": list(range(40)), "b": [tuple(range(20))] * 20}
+    lifted = cons.lift(obj)
+    lowered = cons.lower(lifted)
+    assert lowered == [["a", *range(40)], ["b", *[list(range(20))] * 20]]
+
+
+def test_lift_stops_at_original_length():
+    items = list(range(20))
+
+    def grow():
+        items.append(-1)
+        yield 0
+
+    items[5] = grow()
+    lifted = cons.lift(items)
+    assert len(lifted) == 20
+
+
+@counts_allocations
+def test_serialization_reads_chunks():
+    xs = cons.from_xs(range(100))
+    before = allocated()
+    data, pickled = dumps(xs), pickle.dumps(xs)
+    assert allocated() - before == 0
+    assert loads(data) == xs
+    assert pickle.loads(pickled) == xs
+
+
+def test_chunk_items_are_collected_in_cycles():
+    class Box:
+        pass
+
+    box = Box()
+    xs = cons.from_xs([box] * 20)
+    box.xs = xs
+    ref = weakref.ref(box)
+    del box, xs
+    gc.collect()
+    assert ref() is None
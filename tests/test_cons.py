@@ -1,10 +1,14 @@
+import array
 import gc
 import operator
+import sys
 import weakref
-from collections import namedtuple
+from collections import deque, namedtuple
 
 import pytest
-from fastcons import cons, nil
+from fastcons import cons, freelist_info, hamt, nil
+
+from helpers import cells
 
 
 @pytest.mark.parametrize(
@@ -57,6 +61,18 @@ def test_cons_none():
         (range(2), cons(0, cons(1, nil()))),
         ({1, 2}, cons(1, cons(2, nil()))),
         ({1: 2, 3: 4}, cons(1, cons(3, nil()))),
+        # Check inputs with their own fast paths
+        (range(5, -1, -3), cons(5, cons(2, nil()))),
+        (range(2**70, 2**70 + 2), cons(2**70, cons(2**70 + 1, nil()))),
+        (b"ab", cons(97, cons(98, nil()))),
+        (bytearray(b"\xff"), cons(255, nil())),
+        (memoryview(b"abc")[::2], cons(97, cons(99, nil()))),
+        (memoryview(b"a").cast("c"), cons(b"a", nil())),
+        (array.array("d", [1.5, 2]), cons(1.5, cons(2.0, nil()))),
+        (array.array("q", [-1]), cons(-1, nil())),
+        (deque([1, 2]), cons(1, cons(2, nil()))),
+        (iter([1, 2]), cons(1, cons(2, nil()))),
+        ({1: 2}.items(), cons((1, 2), nil())),
     ],
 )
 def test_from_xs(xs, expected):
@@ -64,6 +80,35 @@ def test_from_xs(xs, expected):
     assert pair == expected
 
 
+@pytest.mark.parametrize(
+    "xs",
+    [range(-(2**63), 2**63 - 1, 2**62), memoryview(array.array("f", [0.5, 1]))[::-1]],
+)
+def test_from_xs_matches_iteration(xs):
+    items = list(cons.from_xs(xs))
+    assert items == list(xs)
+    assert [type(x) for x in items] == [type(x) for x in xs]
+
+
+@pytest.mark.parametrize("hint", [0, 1, 1000])
+def test_from_xs_wrong_length_hint(hint):
+    class Hinted:
+        def __iter__(self):
+            return iter("abc")
+
+        def __length_hint__(self):
+            return hint
+
+    xs = cons.from_xs(Hinted())
+    assert xs == cons.from_xs("abc")
+    assert len(xs) == 3
+
+
+def test_from_xs_not_iterable():
+    with pytest.raises(TypeError, match="Expected a sequence or iterable"):
+        cons.from_xs(1)
+
+
 @pytest.mark.parametrize(
     ("obj", "expected"),
     [
@@ -157,6 +202,84 @@ def test_cons_richcompare(op, a, b, expected):
     assert op(a, b) == expected
 
 
+@pytest.mark.parametrize(
+    ("a", "b"),
+    [
+        # Lists compare lexicographically, like tuples
+        (cons.from_xs([1, 2]), cons.from_xs([1, 3])),
+        (cons.from_xs([1, 2]), cons.from_xs([1, 2, 3])),
+        (cons.from_xs([1, 9, 9]), cons.from_xs([2])),
+        (cons(1, 2), cons(1, 3)),
+        (cons.lift([[1, 2], 3]), cons.lift([[1, 3], 0])),
+        (cons.lift([[1, 2], 3]), cons.lift([[1, 2, 0], 0])),
+        (cons.lift([[1, 2], 3]), cons.lift([[1, 2], 4])),
+    ],
+)
+def test_cons_ordering(a, b):
+    assert a < b
+    assert a <= b
+    assert b > a
+    assert b >= a
+    assert not a > b
+    assert not b < a
+    assert a != b
+
+
+class CountingEq:
+    calls = 0
+
+    def __init__(self, x):
+        self.x = x
+
+    def __eq__(self, other):
+        CountingEq.calls += 1
+        return self.x == other.x
+
+    def __hash__(self):
+        return hash(self.x)
+
+
+def test_richcompare_skips_shared_tail():
+    shared = cons.from_xs([CountingEq(i) for i in range(1000)])
+    a = cons(CountingEq(-1), shared)
+    b = cons(CountingEq(-1), shared)
+    CountingEq.calls = 0
+    assert a == b
+    assert CountingEq.calls == 1
+
+
+def test_richcompare_skips_shared_heads():
+    shared = cons.from_xs([CountingEq(i) for i in range(1000)])
+    a = cons.from_xs([shared, shared])
+    b = cons.from_xs([shared, shared])
+    CountingEq.calls = 0
+    assert a == b
+    assert a <= b
+    assert CountingEq.calls == 0
+
+
+def test_richcompare_different_hashes():
+    a = cons(CountingEq(1), cons(CountingEq(2), 3))
+    b = cons(CountingEq(1), cons(CountingEq(2), 4))
+    hash(a)
+    hash(b)
+    CountingEq.calls = 0
+    assert a != b
+    assert CountingEq.calls == 0
+
+
+def test_richcompare_deeply_nested_heads():
+    a, b = nil(), nil()
+    for i in range(100_000):
+        a = cons(a, cons(i, nil()))
+        b = cons(b, cons(i, nil()))
+    assert a == b
+    assert not a < b
+    c = cons(cons(cons(0, nil()), nil()), nil())
+    assert c == cons(cons(cons(0, nil()), nil()), nil())
+    assert c < cons(cons(cons(1, nil()), nil()), nil())
+
+
 def test_cons_to_list():
     cons_list = cons.from_xs(range(100))
     assert cons_list.to_list() == list(range(100))
@@ -176,6 +299,64 @@ def test_hash_equality():
 def test_not_hashable_when_members_not_hashable():
     with pytest.raises(TypeError):
         hash(cons([1], nil()))
+    with pytest.raises(TypeError):
+        hash(cons(1, cons([1], nil())))
+
+
+def test_hash_long_list():
+    """Test hashing doesn't recurse once per cell."""
+    xs = cons.from_xs(range(1_000_000))
+    assert hash(xs) == hash(cons.from_xs(range(1_000_000)))
+    assert hash(xs) != hash(xs.tail)
+
+
+def test_hash_deeply_nested_heads():
+    """Test hashing doesn't recurse once per level of lists nested in heads."""
+
+    def nested():
+        xs = nil()
+        for i in range(100_000):
+            xs = cons(xs, cons(i, nil()))
+        return xs
+
+    xs = nested()
+    assert hash(xs) == hash(nested())
+    assert hash(xs) != hash(xs.head)
+    obj = []
+    for _ in range(50_000):
+        obj = [obj, 1]
+    assert hash(cons.lift(obj)) == hash(cons.lift(obj))
+
+
+def test_hash_deep_nesting_through_tuples_raises():
+    xs = nil()
+    for _ in range(100_000):
+        xs = cons((xs,), nil())
+    with pytest.raises(RecursionError):
+        hash(xs)
+
+
+def test_hash_is_cached():
+    class Counted:
+        calls = 0
+
+        def __hash__(self):
+            Counted.calls += 1
+            return 1
+
+    xs = cons.from_xs([Counted() for _ in range(10)])
+    hash(xs.tail.tail)
+    assert Counted.calls == 8
+    hash(xs)
+    assert Counted.calls == 10
+    hash(xs)
+    hash(xs.tail)
+    assert Counted.calls == 10
+
+
+def test_hash_improper():
+    assert hash(cons(1, cons(2, 3))) == hash(cons(1, cons(2, 3)))
+    assert hash(cons(1, cons(2, 3))) != hash(cons(1, cons(2, nil())))
 
 
 @pytest.mark.parametrize(
@@ -222,6 +403,120 @@ def test_lift_generator(xs, expected):
     assert repr(cons.lift(xs)) == expected
 
 
+@pytest.mark.parametrize(
+    ("xs", "expected"),
+    [
+        ({1}, "(1)"),
+        (frozenset({"a"}), "('a')"),
+        (iter([1, [2]]), "(1 (2))"),
+        (map(str, range(3)), "('0' '1' '2')"),
+        ([{1}, iter(())], "((1) nil())"),
+    ],
+)
+def test_lift_sets_and_iterators(xs, expected):
+    assert repr(cons.lift(xs)) == expected
+
+
+def test_lift_deeply_nested():
+    data = 0
+    for _ in range(100_000):
+        data = [data, {"k": 1}]
+    lifted = cons.lift(data)
+    depth = 0
+    while lifted != 0:
+        lifted = lifted.head
+        depth += 1
+    assert depth == 100_000
+
+
+def test_lift_recursive_structure_raises():
+    xs = [1]
+    xs.append([xs])
+    with pytest.raises(ValueError):
+        cons.lift(xs)
+
+
+def test_lift_dict_pairs_with_list_values_are_lists():
+    pair = cons.lift({"a": [1, 2]}).head
+    assert pair == cons("a", cons(1, cons(2, nil())))
+    assert len(pair) == 3
+
+
+@pytest.mark.parametrize(
+    ("xs", "expected"),
+    [
+        (1, 1),
+        (nil(), []),
+        (cons.lift([1, [2, (3,)]]), [1, [2, [3]]]),
+        (cons(1, 2), cons(1, 2)),
+        (cons.lift([1, cons(2, 3)]), [1, cons(2, 3)]),
+        (hamt({"a": cons.lift([1])}), {"a": [1]}),
+        (cons.lift({"a": 1}, hamt=True), {"a": 1}),
+        (cons.lift([[1, 2], [3, 4]]), [[1, 2], [3, 4]]),
+        (cons.lift([[1, 2], [1, 3]]), [[1, 2], [1, 3]]),
+    ],
+)
+def test_lower(xs, expected):
+    assert cons.lower(xs) == expected
+
+
+@pytest.mark.parametrize(
+    ("xs", "expected"),
+    [
+        (cons.lift({"a": [1, {"b": 2}], "c": 3}), {"a": [1, {"b": 2}], "c": 3}),
+        (cons.lift({"a": {}}), {"a": []}),
+    ],
+)
+def test_lower_alists(xs, expected):
+    assert cons.lower(xs, alists=True) == expected
+
+
+def test_lower_inverts_lift_of_maps():
+    obj = {"a": [1, {"b": [[1, 2], [3, 4]]}], "c": 3}
+    assert cons.lower(cons.lift(obj, hamt=True)) == obj
+
+
+def test_lower_alist_first_pair_wins():
+    alist = cons.from_xs([cons("a", 1), cons("b", 2), cons("a", 3)])
+    assert cons.lower(alist, alists=True) == {"a": 1, "b": 2}
+
+
+def test_lower_options():
+    xs = cons.lift([[1, 2], [3, 4]])
+    assert cons.lower(xs, alists=True) == {1: [2], 3: [4]}
+    assert cons.lower(xs, alists=False) == [[1, 2], [3, 4]]
+    assert cons.lower(xs, tuples=True) == ((1, 2), (3, 4))
+    assert cons.lower(nil(), tuples=True) == ()
+    with pytest.raises(TypeError):
+        cons.lower(xs, tuple=True)
+
+
+def test_lower_unhashable_key_is_a_list():
+    xs = cons.from_xs([cons([1], 2)])
+    assert cons.lower(xs, alists=True) == [cons([1], 2)]
+
+
+def test_lower_key_hash_error_propagates():
+    class Bad:
+        def __hash__(self):
+            raise RuntimeError("boom")
+
+    with pytest.raises(RuntimeError):
+        cons.lower(cons.from_xs([cons(Bad(), 2)]), alists=True)
+
+
+def test_lower_deeply_nested():
+    xs = nil()
+    for _ in range(100_000):
+        xs = cons(xs, nil())
+    lowered = cons.lower(xs)
+    depth = 0
+    while lowered:
+        (lowered,) = lowered
+        depth += 1
+    assert depth == 100_000
+
+
 def test_lift_namedtuple():
     Foo = namedtuple("Foo", "foo bar baz")
     assert repr(cons.lift(Foo("a", "b", "c"))) == "('a' 'b' 'c')"
@@ -362,6 +657,73 @@ def test_cons_weak_references_nested():
     assert w2() is None
 
 
+@pytest.mark.parametrize(
+    ("xs", "expected"),
+    [
+        (cons(1, nil()), 1),
+        (cons(1, cons(2, nil())), 2),
+        (cons.from_xs(range(1000)), 1000),
+        (cons.from_xs(x for x in range(10)), 10),
+        (cons.lift({"a": 1, "b": 2, "c": [1, 2]}), 3),
+        (cons(0, cons.from_xs(range(10))), 11),
+    ],
+)
+def test_len(xs, expected):
+    assert len(xs) == expected
+    assert len(xs.tail) == expected - 1
+
+
+@pytest.mark.parametrize("xs", [cons(1, 2), cons(1, cons(2, 3)), cons(1, cons(2, nil()).head)])
+def test_len_improper_raises(xs):
+    with pytest.raises(TypeError):
+        len(xs)
+
+
+def test_improper_is_truthy():
+    assert cons(1, 2)
+    assert cons(1, nil())
+
+
+def test_iter():
+    xs = cons.from_xs(range(10))
+    assert list(xs) == list(range(10))
+    assert [x for x in xs] == list(range(10))
+    assert sum(xs) == 45
+
+
+def test_iter_unpacking():
+    a, b, c = cons.from_xs("abc")
+    assert (a, b, c) == ("a", "b", "c")
+    first, *rest = cons.from_xs(range(4))
+    assert first == 0
+    assert rest == [1, 2, 3]
+
+
+def test_iter_length_hint():
+    it = iter(cons.from_xs(range(5)))
+    assert operator.length_hint(it) == 5
+    next(it)
+    next(it)
+    assert operator.length_hint(it) == 3
+    assert list(it) == [2, 3, 4]
+    assert operator.length_hint(it) == 0
+    with pytest.raises(StopIteration):
+        next(it)
+
+
+def test_iter_keeps_list_alive():
+    it = iter(cons.from_xs([object() for _ in range(3)]))
+    gc.collect()
+    assert len(list(it)) == 3
+
+
+def test_iter_improper_raises():
+    with pytest.raises(TypeError):
+        iter(cons(1, 2))
+    with pytest.raises(TypeError):
+        list(cons(1, cons(2, 3)))
+
+
 def test_cons_invalid_operations():
     """Test invalid operations raise appropriate exceptions."""
     c = cons(1, nil())
@@ -370,7 +732,7 @@ def test_cons_invalid_operations():
         c.invalid_attr
 
     with pytest.raises(TypeError):
-        len(c)
+        len(cons(1, 2))
 
     with pytest.raises(TypeError):
         c + 1
@@ -386,3 +748,88 @@ def test_cons_type_mixing():
     assert mixed.tail.tail.tail.head is None
     assert mixed.tail.tail.tail.tail.head is True
     assert mixed.tail.tail.tail.tail.tail is nil()
+
+
+needs_freelist = pytest.mark.skipif(
+    freelist_info()["capacity"] == 0, reason="built without a free-list"
+)
+
+
+@needs_freelist
+def test_freelist_reuses_cells():
+    """Test cells released by a dead list are handed out again."""
+    xs = cells(range(100))
+    del xs
+    before = freelist_info()
+    assert before["size"] >= 100
+    ys = cells(range(100))
+    after = freelist_info()
+    assert after["hits"] - before["hits"] == 100
+    assert after["size"] == before["size"] - 100
+    assert ys.to_list() == list(range(100))
+
+
+@needs_freelist
+def test_freelist_is_bounded():
+    xs = cells(range(freelist_info()["capacity"] * 2))
+    del xs
+    info = freelist_info()
+    assert info["size"] == info["capacity"]
+
+
+def test_dealloc_long_list():
+    item = object()
+    before = sys.getrefcount(item)
+    xs = nil()
+    for _ in range(1_000_000):
+        xs = cons(item, xs)
+    del xs
+    assert sys.getrefcount(item) == before
+
+
+def test_dealloc_deeply_nested_heads():
+    xs = nil()
+    for _ in range(200_000):
+        xs = cons(xs, cons(1, nil()))
+    del xs
+
+
+def test_dealloc_keeps_shared_tails():
+    shared = cells(range(100))
+    xs, ys = cons("x", shared), cons(cons("y", shared), shared)
+    del xs, ys
+    assert shared == cells(range(100))
+    assert len(shared) == 100
+
+
+def test_dealloc_cell_revived_through_weakref():
+    kept = []
+
+    class Reviver:
+        def __del__(self):
+            kept.append(ref())
+
+    xs = cons(Reviver(), cells(range(3)))
+    ref = weakref.ref(xs.tail)
+    del xs
+    assert kept == [cells(range(3))]
+    assert len(kept[0]) == 3
+
+
+def test_lift_does_not_leak_items():
+    item = object()
+    before = sys.getrefcount(item)
+    lifted = cons.lift([[item], (item,), (x for x in [item])])
+    assert sys.getrefcount(item) == before + 3
+    del lifted
+    assert sys.getrefcount(item) == before
+
+
+def test_from_xs_generator_error():
+    def gen():
+        yield 1
+        yield 2
+        raise RuntimeError("boom")
+
+    with pytest.raises(RuntimeError):
+        cons.from_xs(gen())
@@ -0,0 +1,106 @@
+import operator
+
+import pytest
+from fastcons import cons, filter, foldl, foldr, map, nil
+
+
+@pytest.mark.parametrize(
+    ("f", "xs", "expected"),
+    [
+        (lambda x: x + 1, nil(), nil()),
+        (lambda x: x + 1, cons.from_xs([1, 2, 3]), cons.from_xs([2, 3, 4])),
+        (str, cons.from_xs(range(3)), cons.from_xs(["0", "1", "2"])),
+        (operator.neg, cons.from_xs(range(1000)), cons.from_xs(range(0, -1000, -1))),
+    ],
+)
+def test_map(f, xs, expected):
+    result = map(f, xs)
+    assert result == expected
+    assert len(result) == len(expected)
+
+
+def test_map_error_midway():
+    def f(x):
+        if x == 5:
+            raise RuntimeError("boom")
+        return [x]
+
+    with pytest.raises(RuntimeError):
+        map(f, cons.from_xs(range(10)))
+
+
+@pytest.mark.parametrize(
+    ("predicate", "xs", "expected"),
+    [
+        (bool, nil(), nil()),
+        (bool, cons.from_xs([0, 1, 0, 2]), cons.from_xs([1, 2])),
+        (lambda x: x % 2, cons.from_xs(range(10)), cons.from_xs(range(1, 10, 2))),
+        (lambda x: False, cons.from_xs(range(10)), nil()),
+    ],
+)
+def test_filter(predicate, xs, expected):
+    result = filter(predicate, xs)
+    assert result == expected
+    assert len(result) == len(expected)
+
+
+def test_filter_error():
+    class Bad:
+        def __bool__(self):
+            raise RuntimeError("boom")
+
+    with pytest.raises(RuntimeError):
+        filter(lambda x: Bad(), cons.from_xs(range(3)))
+
+
+@pytest.mark.parametrize(
+    ("f", "initial", "xs", "expected"),
+    [
+        (operator.add, 0, nil(), 0),
+        (operator.add, 0, cons.from_xs(range(10)), 45),
+        (operator.sub, 0, cons.from_xs([1, 2, 3]), ((0 - 1) - 2) - 3),
+        (lambda acc, x: [*acc, x], [], cons.from_xs("abc"), ["a", "b", "c"]),
+    ],
+)
+def test_foldl(f, initial, xs, expected):
+    assert foldl(f, initial, xs) == expected
+
+
+@pytest.mark.parametrize(
+    ("f", "initial", "xs", "expected"),
+    [
+        (operator.add, 0, nil(), 0),
+        (operator.sub, 0, cons.from_xs([1, 2, 3]), 1 - (2 - (3 - 0))),
+        (cons, nil(), cons.from_xs(range(5)), cons.from_xs(range(5))),
+    ],
+)
+def test_foldr(f, initial, xs, expected):
+    assert foldr(f, initial, xs) == expected
+
+
+def test_foldr_long_list():
+    xs = cons.from_xs(range(1_000_000))
+    assert foldr(lambda x, acc: acc + 1, 0, xs) == 1_000_000
+
+
+@pytest.mark.parametrize("fn", [map, filter])
+@pytest.mark.parametrize(
+    ("args", "exc"),
+    [
+        ((len, cons(1, 2)), ValueError),
+        ((len, [1, 2]), ValueError),
+        ((1, cons(1, nil())), TypeError),
+        ((len,), TypeError),
+    ],
+)
+def test_bad_arguments(fn, args, exc):
+    with pytest.raises(exc):
+        fn(*args)
+
+
+@pytest.mark.parametrize("fn", [foldl, foldr])
+def test_fold_bad_arguments(fn):
+    with pytest.raises(ValueError):
+        fn(operator.add, 0, cons(1, 2))
+    with pytest.raises(TypeError):
+        fn(operator.add, cons(1, nil()))
@@ -0,0 +1,69 @@
+import gc
+import weakref
+
+import fastcons
+import pytest
+from fastcons import cons, hamt, nil
+
+from helpers import cells
+
+
+def spine(xs):
+    result = []
+    while xs is not nil():
+        result.append(xs)
+        xs = xs.tail
+    return result
+
+
+@pytest.mark.parametrize(
+    "build",
+    [
+        cells,
+        cons.from_xs,
+        lambda items: cons.from_xs(iter(items)),
+        cons.lift,
+        lambda items: fastcons.map(int, cons.from_xs(items)),
+        lambda items: fastcons.filter(bool, cons.from_xs([0, *items])),
+    ],
+)
+@pytest.mark.parametrize("n", [3, 100])
+def test_lists_of_atoms_are_untracked(build, n):
+    xs = build([str(i) for i in range(n)] if build is cons.lift else list(range(n)))
+    assert not any(gc.is_tracked(cell) for cell in spine(xs))
+
+
+def test_pairs_of_atoms_are_untracked():
+    assert not gc.is_tracked(cons(1, 2))
+    assert not gc.is_tracked(cons(cons(1, "a"), nil()))
+    assert not any(gc.is_tracked(cell) for cell in spine(hamt({1: 2}).to_alist()))
+
+
+class Box:
+    pass
+
+
+@pytest.mark.parametrize("head", [[], {}, Box(), cons([], nil())])
+def test_containers_are_tracked(head):
+    assert gc.is_tracked(cons(head, nil()))
+    assert gc.is_tracked(cons(1, cons(head, nil())))
+    assert gc.is_tracked(cons(1, head))
+
+
+def test_only_cells_before_a_container_are_tracked():
+    xs = fastcons.filter(bool, cons.from_xs([1, [0], 2, 3]))
+    assert [gc.is_tracked(cell) for cell in spine(xs)] == [True, True, False, False]
+
+
+def test_streams_are_tracked():
+    assert gc.is_tracked(cons.stream(iter(range(3))))
+
+
+def test_cycle_through_untracked_dict_is_collected():
+    d = {}
+    xs = cons(d, nil())
+    d["xs"] = xs
+    ref = weakref.ref(xs)
+    del d, xs
+    gc.collect()
+    assert ref() is None
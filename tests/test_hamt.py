@@ -0,0 +1,174 @@
+import pytest
+from fastcons import cons, hamt, nil
+
+
+class Collider:
+    """Distinct keys that all share one hash."""
+
+    def __init__(self, name, hash_=42):
+        self.name = name
+        self.hash = hash_
+
+    def __hash__(self):
+        return self.hash
+
+    def __eq__(self, other):
+        return isinstance(other, Collider) and self.name == other.name
+
+    def __repr__(self):
+        return f"Collider({self.name!r})"
+
+
+def test_hamt_empty():
+    m = hamt()
+    assert len(m) == 0
+    assert list(m) == []
+    assert "x" not in m
+    assert m.get("x") is None
+    assert m.to_alist() is nil()
+    assert repr(m) == "hamt()"
+    with pytest.raises(KeyError):
+        m["x"]
+
+
+@pytest.mark.parametrize(
+    "source",
+    [
+        {"a": 1, "b": 2},
+        [("a", 1), ("b", 2)],
+        cons.from_xs([cons("a", 1), cons("b", 2)]),
+        hamt({"a": 1, "b": 2}),
+    ],
+)
+def test_hamt_construction(source):
+    m = hamt(source)
+    assert len(m) == 2
+    assert m["a"] == 1
+    assert m["b"] == 2
+    assert dict(m.items()) == {"a": 1, "b": 2}
+
+
+def test_hamt_from_alist_keeps_first_pair():
+    m = hamt(cons.from_xs([cons("a", 1), cons("b", 2), cons("a", 3)]))
+    assert len(m) == 2
+    assert m["a"] == 1
+
+
+@pytest.mark.parametrize(
+    "source",
+    [
+        cons(cons("a", 1), 2),
+        cons.from_xs([1, 2]),
+        [("a", 1, 2)],
+    ],
+)
+def test_hamt_construction_malformed(source):
+    with pytest.raises(ValueError):
+        hamt(source)
+
+
+def test_hamt_set_and_delete_are_persistent():
+    m1 = hamt({"a": 1})
+    m2 = m1.set("b", 2)
+    m3 = m2.set("a", 10)
+    m4 = m3.delete("b")
+    assert dict(m1.items()) == {"a": 1}
+    assert dict(m2.items()) == {"a": 1, "b": 2}
+    assert dict(m3.items()) == {"a": 10, "b": 2}
+    assert dict(m4.items()) == {"a": 10}
+    with pytest.raises(KeyError):
+        m4.delete("b")
+
+
+def test_hamt_set_same_value_returns_self():
+    value = object()
+    m = hamt({"a": value})
+    assert m.set("a", value) is m
+
+
+def test_hamt_large():
+    m = hamt()
+    for i in range(10_000):
+        m = m.set(i, str(i))
+    assert len(m) == 10_000
+    assert all(m[i] == str(i) for i in range(10_000))
+    assert sorted(m) == list(range(10_000))
+    for i in range(0, 10_000, 2):
+        m = m.delete(i)
+    assert len(m) == 5_000
+    assert sorted(m.keys()) == list(range(1, 10_000, 2))
+    assert 2 not in m
+    assert 3 in m
+
+
+def test_hamt_hash_collisions():
+    keys = [Collider(str(i)) for i in range(10)]
+    m = hamt((k, i) for i, k in enumerate(keys))
+    assert len(m) == 10
+    assert all(m[k] == i for i, k in enumerate(keys))
+    # A key with a different hash alongside the collision node
+    m = m.set(Collider("other", 7), "x")
+    assert m[Collider("other", 7)] == "x"
+    for k in keys:
+        m = m.delete(k)
+    assert list(m.items()) == [(Collider("other", 7), "x")]
+
+
+def test_hamt_equality_and_hash():
+    m1 = hamt({i: i * i for i in range(100)})
+    m2 = hamt((i, i * i) for i in reversed(range(100)))
+    assert m1 == m2
+    assert hash(m1) == hash(m2)
+    assert m1 != m2.set(0, 1)
+    assert m1 != {i: i * i for i in range(100)}
+    assert {m1: "found"}[m2] == "found"
+
+
+def test_hamt_unhashable_key():
+    with pytest.raises(TypeError):
+        hamt().set([], 1)
+    with pytest.raises(TypeError):
+        hamt()[[]]
+
+
+def test_hamt_to_alist():
+    m = hamt({"a": 1, "b": 2})
+    alist = m.to_alist()
+    assert len(alist) == 2
+    assert hamt(alist) == m
+
+
+@pytest.mark.parametrize("method", ["keys", "values", "items", "to_alist"])
+def test_hamt_views_take_no_arguments(method):
+    m = hamt({"a": 1})
+    with pytest.raises(TypeError, match="zero arguments"):
+        getattr(m, method)(1)
+    with pytest.raises(TypeError, match="zero arguments"):
+        getattr(m, method)(1, 2)
+
+
+def test_hamt_repr():
+    assert repr(hamt({"a": 1})) == "hamt({'a': 1})"
+    m = hamt({"a": 1})
+    m2 = m.set("b", [m])
+    assert "hamt({'a': 1})" in repr(m2)
+
+
+def test_lift_hamt():
+    lifted = cons.lift({"a": [1, {"b": 2}], "c": (3,)}, hamt=True)
+    assert isinstance(lifted, hamt)
+    assert lifted["a"].head == 1
+    assert lifted["a"].tail.head == hamt({"b": 2})
+    assert lifted["c"] == cons(3, nil())
+    assert cons.lift([{"a": 1}], hamt=True) == cons(hamt({"a": 1}), nil())
+    assert isinstance(cons.lift({"a": 1}, hamt=False), cons)
+
+
+def test_freeing_deeply_nested_maps_does_not_recurse():
+    d = {}
+    for _ in range(200_000):
+        d = {"a": d}
+    lifted = cons.lift(d, hamt=True)
+    del d
+    assert isinstance(lifted["a"], hamt)
+    del lifted
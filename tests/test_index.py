@@ -0,0 +1,103 @@
+import bisect
+
+import pytest
+from fastcons import cons, nil
+
+from helpers import cells, partly_forced
+
+BUILDERS = [
+    cons.from_xs,
+    cells,
+    partly_forced,
+    lambda xs: cons(-1, cons.from_xs(xs)).tail,
+    lambda xs: cons.stream(iter(xs)),
+]
+
+
+@pytest.mark.parametrize("build", BUILDERS)
+def test_indexing_matches_list(build):
+    items = list(range(50))
+    view = build(items).indexed()
+    assert len(view) == 50
+    assert [view[i] for i in range(50)] == items
+    assert [view[-i] for i in range(1, 51)] == [items[-i] for i in range(1, 51)]
+    for i in (50, -51, 10**20):
+        with pytest.raises(IndexError):
+            view[i]
+
+
+@pytest.mark.parametrize("build", BUILDERS)
+@pytest.mark.parametrize(
+    "key",
+    [
+        slice(None),
+        slice(5, None),
+        slice(49, None),
+        slice(60, None),
+        slice(-3, None),
+        slice(2, 40),
+        slice(None, 10),
+        slice(None, None, 3),
+        slice(None, None, -1),
+        slice(40, 2, -5),
+        slice(10, 5),
+    ],
+)
+def test_slices_match_list(build, key):
+    items = list(range(50))
+    assert list(build(items).indexed()[key]) == items[key]
+
+
+def test_suffix_shares_structure():
+    xs = cells(range(10))
+    assert xs.indexed()[2:] is xs.tail.tail
+    assert xs.indexed()[0:] is xs
+    assert xs.indexed()[10:] is nil()
+    ys = cons.from_xs(range(50))
+    assert ys.indexed()[30:] == cons.from_xs(range(30, 50))
+
+
+def test_nil():
+    view = nil().indexed()
+    assert len(view) == 0
+    assert view[:] is nil()
+    assert view.list is nil()
+    with pytest.raises(IndexError):
+        view[0]
+
+
+def test_improper_list():
+    with pytest.raises(TypeError):
+        cons(1, cons(2, 3)).indexed()
+
+
+def test_bad_key():
+    with pytest.raises(TypeError):
+        cons.from_xs(range(3)).indexed()["a"]
+
+
+def test_list_and_repr():
+    xs = cons.from_xs(range(3))
+    view = xs.indexed()
+    assert view.list is xs
+    assert repr(view) == f"{xs!r}.indexed()"
+
+
+def test_bisect():
+    items = list(range(0, 2000, 2))
+    view = cons.from_xs(items).indexed()
+    for x in (-1, 0, 3, 1000, 1998, 2001):
+        assert bisect.bisect_left(view, x) == bisect.bisect_left(items, x)
+
+
+def test_views_share_the_cached_index():
+    xs = cons.from_xs(range(100))
+    first, second = xs.indexed(), xs.indexed()
+    assert first is not second
+    assert first[99] == second[99] == 99
+
+
+def test_index_keeps_list_alive():
+    view = cons.from_xs([str(i) for i in range(100)]).indexed()
+    assert view[99] == "99"
+    assert view.list.head == "0"
@@ -1,5 +1,5 @@
 import pytest
-from fastcons import nil
+from fastcons import cons, nil, sort
 
 
 def test_nil_takes_no_args():
@@ -37,3 +37,31 @@ def test_nil_to_list_new_object():
     lst2 = nil().to_list()
     assert lst1 == lst2
     assert lst1 is not lst2
+
+
+def test_nil_iter():
+    assert list(nil()) == []
+    assert [x for x in nil()] == []
+
+
+def test_nil_len():
+    assert len(nil()) == 0
+
+
+def test_nil_orders_before_lists():
+    xs = cons(1, nil())
+    assert nil() < xs
+    assert nil() <= xs
+    assert xs > nil()
+    assert not nil() > xs
+    assert nil() <= nil()
+    assert not nil() < nil()
+    assert nil() != xs
+    with pytest.raises(TypeError):
+        assert nil() < 1
+
+
+def test_nested_empty_lists_order():
+    assert cons.lift([[1], []]) < cons.lift([[1], [2]])
+    assert cons.lift([[], [1]]) < cons.lift([[1]])
+    assert sort(cons.lift([[2], [], [1]])) == cons.lift([[], [1], [2]])
@@ -116,6 +116,14 @@ def test_to_list_roundtrip(xs):
     assert cast(cons, cons.from_xs(xs)).to_list() == xs
 
 
+@given(st.lists(st.integers()))
+def test_len_matches_list(xs):
+    """
+    A proper cons list has the length of the sequence it was built from.
+    """
+    assert len(cons.from_xs(xs)) == len(xs)
+
+
 @given(proper_cons_lists())
 def test_cons_list_equality_reflexive(xs):
     """
@@ -141,6 +149,37 @@ def test_cons_list_equality_transitive(xs, ys, zs):
         assert xs == zs
 
 
+@given(st.lists(st.integers(max_value=3)), st.lists(st.integers(max_value=3)))
+def test_cons_list_ordering_matches_tuples(xs, ys):
+    """
+    Cons lists order like the tuples they were built from.
+    """
+    a, b = cons.from_xs(xs), cons.from_xs(ys)
+    assert (a < b) is (tuple(xs) < tuple(ys))
+    assert (a <= b) is (tuple(xs) <= tuple(ys))
+    assert (a == b) is (xs == ys)
+
+
+nested_lists = st.recursive(
+    st.lists(st.integers(max_value=3), max_size=3),
+    lambda children: st.lists(children, max_size=3),
+    max_leaves=10,
+)
+
+
+@given(nested_lists, nested_lists)
+def test_nested_cons_list_ordering_matches_lists(xs, ys):
+    """
+    Lifted nested lists, empty ones included, order like the lists they came from.
+    """
+    a, b = cons.lift(xs), cons.lift(ys)
+    try:
+        expected = xs < ys
+    except TypeError:
+        return
+    assert (a < b) is expected
+
+
 @given(st.integers(), st.integers())
 def test_cons_pair_attributes(head, tail):
     """
@@ -0,0 +1,182 @@
+import builtins
+import math
+import random
+import sys
+from decimal import Decimal
+from fractions import Fraction
+
+import pytest
+from fastcons import cons, count, max, mean, min, nil, predicate, sum
+
+from helpers import cells
+
+BIG = sys.maxsize
+
+ITEMS = [
+    [],
+    [1, 2, 3],
+    list(range(1000)),
+    [True, False, True],
+    [BIG, BIG, -BIG],
+    [-BIG, -BIG, -BIG],
+    [BIG, 1, 2.5],
+    [2**100, 1, -(2**100)],
+    [0.1] * 10,
+    [1e100, 1.0, -1e100],
+    [1, 2.5, 3],
+    [1.5, 2, True],
+    [1.0, BIG, 2**70],
+    [math.inf, 1.0],
+    [math.inf, -math.inf],
+    [Decimal("0.1"), Decimal("0.2")],
+    [1, Fraction(1, 3), Fraction(1, 6)],
+    [0.5, Fraction(1, 2)],
+    [1, 2.5, Decimal("1")],
+]
+
+
+@pytest.mark.parametrize("build", [cons.from_xs, cells])
+@pytest.mark.parametrize("items", ITEMS)
+def test_sum_matches_builtin(build, items):
+    try:
+        expected = builtins.sum(items)
+    except TypeError:
+        with pytest.raises(TypeError):
+            sum(build(items))
+        return
+    result = sum(build(items))
+    assert type(result) is type(expected)
+    assert result == expected or (math.isnan(result) and math.isnan(expected))
+
+
+@pytest.mark.parametrize(
+    ("items", "start"),
+    [
+        ([1, 2], 10),
+        ([1, 2], 0.5),
+        ([1, 2], BIG),
+        ([1, 2], 2**70),
+        ([[1], [2]], []),
+        ([(1,), (2,)], ()),
+        ([], Decimal("1.5")),
+    ],
+)
+def test_sum_start(items, start):
+    assert sum(cons.from_xs(items), start) == builtins.sum(items, start)
+
+
+def test_sum_random_floats_match_builtin():
+    rng = random.Random(0)
+    for _ in range(100):
+        items = [
+            rng.choice([rng.random() * 1e10, rng.randint(-100, 100)]) for _ in range(50)
+        ]
+        assert sum(cons.from_xs(items)) == builtins.sum(items)
+
+
+@pytest.mark.parametrize("start", ["", b"", bytearray()])
+def test_sum_rejects_string_start(start):
+    with pytest.raises(TypeError):
+        sum(cons.from_xs(["a"]), start)
+
+
+def test_sum_error_midway():
+    with pytest.raises(TypeError):
+        sum(cons.from_xs([1, 2.5, "x", 3]))
+
+
+@pytest.mark.parametrize(
+    "items",
+    [
+        [1, 2, 3],
+        [2.5, 1],
+        [Fraction(1, 2), 1],
+        [Decimal("0.5"), Decimal("0.25")],
+    ],
+)
+def test_mean(items):
+    assert mean(cons.from_xs(items)) == builtins.sum(items) / len(items)
+
+
+def test_mean_of_empty_list():
+    with pytest.raises(ValueError):
+        mean(nil())
+
+
+@pytest.mark.parametrize("build", [cons.from_xs, cells])
+@pytest.mark.parametrize(
+    "items",
+    [
+        [3, 1, 2],
+        list(range(100, 0, -1)),
+        [2.5, -1.0, 7.25],
+        [1, 0.5, True, -BIG, 2**70],
+        [math.nan, 1.0, 2.0],
+        [1.0, math.nan, 0.5],
+        ["b", "a", "c"],
+        [Decimal("1.5"), 1, Fraction(1, 3)],
+    ],
+)
+def test_min_and_max_match_builtins(build, items):
+    assert min(build(items)) is builtins.min(items)
+    assert max(build(items)) is builtins.max(items)
+
+
+def test_min_and_max_return_first_of_equals():
+    a, b, c = 1.0, 1, True
+    xs = cons.from_xs([a, b, c])
+    assert min(xs) is a
+    assert max(xs) is a
+    x, y = 2**70, 2**70
+    assert min(cons.from_xs([x, y])) is x
+
+
+def test_min_and_max_default():
+    assert min(nil(), default=None) is None
+    assert max(nil(), default="x") == "x"
+    assert min(cons.from_xs([2, 1]), default=0) == 1
+    with pytest.raises(ValueError):
+        min(nil())
+    with pytest.raises(ValueError):
+        max(nil())
+
+
+def test_min_and_max_incomparable():
+    with pytest.raises(TypeError):
+        min(cons.from_xs([1, "a"]))
+    with pytest.raises(TypeError):
+        max(cons.from_xs([None, None]))
+
+
+@pytest.mark.parametrize(
+    ("pred", "xs", "expected"),
+    [
+        (bool, nil(), 0),
+        (bool, cons.from_xs([0, 1, 0, 2]), 2),
+        (lambda x: x % 3 == 0, cons.from_xs(range(100)), 34),
+        (predicate.is_instance(str), cons.from_xs([1, "a", 2, "b"]), 2),
+        (predicate.is_in({1, 2}), cells([1, 2, 3, 1]), 3),
+    ],
+)
+def test_count(pred, xs, expected):
+    assert count(pred, xs) == expected
+
+
+def test_count_error_midway():
+    def f(x):
+        if x == 5:
+            raise RuntimeError("boom")
+        return True
+
+    with pytest.raises(RuntimeError):
+        count(f, cons.from_xs(range(10)))
+
+
+@pytest.mark.parametrize(
+    "reduce",
+    [sum, mean, min, max, lambda xs: count(bool, xs)],
+)
+@pytest.mark.parametrize("xs", [cons(1, 2), cons.stream(range(3)), [1, 2]])
+def test_reductions_require_proper_lists(reduce, xs):
+    with pytest.raises(ValueError):
+        reduce(xs)
@@ -0,0 +1,139 @@
+import io
+import math
+
+import pytest
+from fastcons import cons, nil, write_repr
+
+ATOMS = [
+    0,
+    -1,
+    2**63 - 1,
+    -(2**63),
+    2**64,
+    1.5,
+    -0.0,
+    1e300,
+    1e-7,
+    math.inf,
+    math.nan,
+    "",
+    "abc",
+    "it's",
+    'say "hi"',
+    "back\\slash",
+    "tab\t",
+    "\x7f",
+    "é",
+    True,
+    False,
+    None,
+    b"bytes",
+    (1, "a"),
+    [1, 2],
+    {"a": 1},
+    3 + 4j,
+]
+
+
+@pytest.mark.parametrize("atom", ATOMS)
+def test_atom_repr_matches_builtin(atom):
+    assert repr(cons(atom, nil())) == f"({atom!r})"
+    assert repr(cons(1, atom)) == f"(1 . {atom!r})"
+
+
+def test_nested_repr():
+    xs = cons.lift([[1, [2, "x"]], 3, [], [[[]]]])
+    assert repr(xs) == "((1 (2 'x')) 3 nil() ((nil())))"
+    assert repr(cons(cons(1, 2), cons(cons(3, nil()), 4))) == "((1 . 2) (3) . 4)"
+
+
+def test_deeply_nested_repr_does_not_recurse():
+    xs = nil()
+    for _ in range(100_000):
+        xs = cons(xs, nil())
+    assert repr(xs) == "(" * 100_000 + "nil()" + ")" * 100_000
+
+
+def test_nested_chunks_and_streams():
+    xs = cons.from_xs([cons.from_xs(range(20)), cons.stream("ab"), 1])
+    assert repr(xs) == f"(({' '.join(map(str, range(20)))}) ('a' ...) 1)"
+
+
+def written(obj):
+    file = io.StringIO()
+    assert write_repr(obj, file) is None
+    return file.getvalue()
+
+
+@pytest.mark.parametrize(
+    "obj",
+    [
+        nil(),
+        42,
+        cons(1, 2),
+        cons.from_xs(range(100)),
+        cons.lift({"a": [1, 2.5], "b": (None, True)}),
+        cons.stream(range(3)),
+    ],
+)
+def test_write_repr_matches_repr(obj):
+    assert written(obj) == repr(obj)
+
+
+def test_write_repr_writes_in_pieces():
+    pieces = []
+
+    class File:
+        def write(self, text):
+            pieces.append(text)
+
+    xs = cons.from_xs([str(i) for i in range(100_000)])
+    write_repr(xs, File())
+    assert len(pieces) > 1
+    assert max(len(piece) for piece in pieces) < 70_000
+    assert "".join(pieces) == repr(xs)
+
+
+def test_write_repr_to_binary_file():
+    xs = cons.from_xs(["\u00e9\u4e00", *map(str, range(100_000))])
+    file = io.BytesIO()
+    write_repr(xs, file)
+    assert file.getvalue() == repr(xs).encode()
+
+    pieces = []
+
+    class File:
+        def write(self, data):
+            if not isinstance(data, bytes):
+                raise TypeError("a bytes-like object is required")
+            pieces.append(data)
+
+    write_repr(xs, File())
+    assert len(pieces) > 1
+    assert b"".join(pieces) == repr(xs).encode()
+
+
+def test_write_repr_with_cycle():
+    x = ["x"]
+    p = cons(1, cons(x, nil()))
+    x.append(p)
+    assert written(p) == repr(p) == "(1 ['x', ...])"
+
+
+def test_write_repr_errors():
+    with pytest.raises(AttributeError):
+        write_repr(cons(1, nil()), object())
+
+    class Neither:
+        def write(self, data):
+            raise TypeError(type(data).__name__)
+
+    with pytest.raises(TypeError, match="str"):
+        write_repr(cons(1, nil()), Neither())
+
+    class Bad:
+        def __repr__(self):
+            raise RuntimeError("boom")
+
+    with pytest.raises(RuntimeError):
+        write_repr(cons.from_xs([1, Bad()]), io.StringIO())
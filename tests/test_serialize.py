@@ -0,0 +1,98 @@
+import pickle
+
+import pytest
+from fastcons import cons, dumps, hamt, loads, nil
+
+VALUES = [
+    nil(),
+    cons(1, 2),
+    cons.from_xs(range(5)),
+    cons(cons(1, cons(2, nil())), 3),
+    cons.lift({"a": [1, 2.5, "x", b"y", None, True, False], "b": (2**70, -3)}),
+    cons.from_xs([[1], {"k": frozenset()}, "\ud800"]),
+    cons.from_xs([0, 127, 128, -1, 2**63 - 1, -(2**63), 2**64]),
+    hamt({"a": cons.from_xs([1])}),
+    42,
+]
+
+
+@pytest.mark.parametrize("xs", VALUES)
+def test_dumps_roundtrip(xs):
+    result = loads(dumps(xs))
+    assert result == xs
+    assert type(result) is type(xs)
+
+
+@pytest.mark.parametrize("xs", VALUES)
+def test_pickle_roundtrip(xs):
+    for protocol in range(2, pickle.HIGHEST_PROTOCOL + 1):
+        assert pickle.loads(pickle.dumps(xs, protocol)) == xs
+
+
+def test_roundtrip_keeps_lengths():
+    assert len(loads(dumps(cons.from_xs("abc")))) == 3
+    assert len(pickle.loads(pickle.dumps(cons.from_xs("abc")))) == 3
+
+
+def test_nil_is_preserved():
+    assert loads(dumps(nil())) is nil()
+    assert pickle.loads(pickle.dumps(cons(1, nil()))).tail is nil()
+
+
+@pytest.mark.parametrize(
+    "roundtrip", [lambda x: loads(dumps(x)), lambda x: pickle.loads(pickle.dumps(x))]
+)
+def test_shared_structure_is_preserved(roundtrip):
+    shared = cons.from_xs(range(3))
+    x, y = cons(1, shared), cons(2, shared)
+    result = roundtrip(cons.from_xs([x, y, x]))
+    first, second, third = result
+    assert first.tail is second.tail
+    assert first is third
+    assert result == cons.from_xs([x, y, x])
+
+
+def test_long_list_does_not_recurse():
+    xs = cons.from_xs(range(200_000))
+    assert loads(dumps(xs)) == xs
+    assert pickle.loads(pickle.dumps(xs)) == xs
+
+
+def test_deeply_nested_heads_do_not_recurse():
+    xs = nil()
+    for _ in range(100_000):
+        xs = cons(xs, nil())
+    assert loads(dumps(xs)) == xs
+
+
+def test_dumps_forces_streams():
+    assert loads(dumps(cons.stream(iter("abc")))) == cons.from_xs("abc")
+
+
+def test_dumps_is_compact():
+    xs = cons.from_xs(range(1000))
+    assert len(dumps(xs)) < len(pickle.dumps(xs))
+
+
+def test_loads_accepts_buffers():
+    assert loads(memoryview(dumps(cons(1, nil())))) == cons(1, nil())
+
+
+@pytest.mark.parametrize(
+    "data",
+    [
+        b"",
+        b"XX\x01N",
+        b"FC\x01",
+        b"FC\x01NN",
+        b"FC\x01L\x00",
+        b"FC\x01L\x05N",
+        b"FC\x01R\x00",
+        b"FC\x01M\x01R\x00N",
+        b"FC\x01i\xff",
+        b"FC\x01u\x05ab",
+    ],
+)
+def test_loads_invalid_data(data):
+    with pytest.raises(ValueError):
+        loads(data)
@@ -0,0 +1,97 @@
+import random
+
+import pytest
+from fastcons import cons, nil, sort
+
+from helpers import cells
+
+rng = random.Random(0)
+ITEMS = [
+    [3, 1, 2],
+    [rng.randint(-100, 100) for _ in range(200)],
+    [rng.random() for _ in range(200)],
+    [str(rng.random()) for _ in range(50)],
+    [(rng.randint(0, 3), i) for i in range(50)],
+    [1, 2.5, True, -3],
+    [2**70, 1, -(2**70)],
+]
+
+
+@pytest.mark.parametrize("build", [cons.from_xs, cells])
+@pytest.mark.parametrize("items", ITEMS)
+@pytest.mark.parametrize("reverse", [False, True])
+def test_sort_matches_sorted(build, items, reverse):
+    result = sort(build(items), reverse=reverse)
+    assert list(result) == sorted(items, reverse=reverse)
+    assert len(result) == len(items)
+
+
+def test_sort_is_stable():
+    items = [(rng.randint(0, 5), i) for i in range(100)]
+    xs = cons.from_xs(items)
+    assert list(sort(xs, key=lambda p: p[0])) == sorted(items, key=lambda p: p[0])
+    assert list(sort(xs, key=lambda p: p[0], reverse=True)) == sorted(
+        items, key=lambda p: p[0], reverse=True
+    )
+
+
+def test_sort_keeps_identity_of_equal_elements():
+    a, b = 1.0, 1
+    result = sort(cons.from_xs([2, a, b]))
+    assert result.head is a
+    assert result.tail.head is b
+
+
+def test_already_sorted_list_is_shared():
+    xs = cons.from_xs(range(100))
+    assert sort(xs) is xs
+    assert sort(nil()) is nil()
+    ys = cons(1, nil())
+    assert sort(ys) is ys
+    assert sort(xs, reverse=True) is not xs
+
+
+def test_sort_alist_by_key():
+    alist = cons.lift({"b": 2, "a": 3, "c": 1})
+    assert sort(alist, alist=True) == cons.lift({"a": 3, "b": 2, "c": 1})
+    assert sort(alist, alist=True, reverse=True) == cons.lift({"c": 1, "b": 2, "a": 3})
+    by_ord = sort(alist, alist=True, key=lambda k: -ord(k))
+    assert [pair.head for pair in by_ord] == ["c", "b", "a"]
+
+
+def test_sort_alist_compares_only_keys():
+    # The values can't be compared, and equal keys keep their order
+    alist = cells([cons(2, object()), cons(1, object()), cons(2, object())])
+    result = sort(alist, alist=True)
+    assert [pair.head for pair in result] == [1, 2, 2]
+    assert result.tail.head is alist.head
+
+
+def test_sort_alist_requires_pairs():
+    with pytest.raises(ValueError, match="association list"):
+        sort(cons.from_xs([cons(1, 2), 3]), alist=True)
+
+
+def test_sort_errors():
+    with pytest.raises(TypeError):
+        sort(cons.from_xs([1, "a"]))
+    with pytest.raises(TypeError):
+        sort(cons.from_xs([1, 2]), key=1)
+    with pytest.raises(TypeError):
+        sort(cons.from_xs([1, 2]), cmp=None)
+
+
+def test_sort_key_error():
+    def key(_):
+        raise RuntimeError("boom")
+
+    with pytest.raises(RuntimeError):
+        sort(cons.from_xs([1, 2]), key=key)
+    with pytest.raises(RuntimeError):
+        sort(cons.lift({"a": 1, "b": 2}), alist=True, key=key)
+
+
+@pytest.mark.parametrize("xs", [cons(1, 2), cons.stream(range(3)), [1, 2]])
+def test_sort_requires_proper_lists(xs):
+    with pytest.raises(ValueError, match="proper cons list"):
+        sort(xs)
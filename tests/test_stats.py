@@ -0,0 +1,105 @@
+import gc
+
+import pytest
+from fastcons import assoc, assp, cons, nil, stats
+
+pytestmark = pytest.mark.skipif(
+    not stats()["enabled"], reason="built with CONS_STATS=0"
+)
+
+
+@pytest.fixture(autouse=True)
+def fresh_stats():
+    gc.collect()
+    stats(reset=True)
+
+
+def test_snapshot_is_a_copy():
+    before = stats()
+    cons(1, nil())
+    assert stats()["cells_allocated"] == before["cells_allocated"] + 1
+
+
+def test_reset():
+    cons(1, nil())
+    assert stats(reset=True)["cells_allocated"] == 1
+    after = stats()
+    assert after["cells_allocated"] == 0
+    assert after["peak_live_cells"] == after["live_cells"]
+
+
+def test_live_cells():
+    live = stats()["live_cells"]
+    xs = cons(1, cons(2, cons(3, nil())))
+    now = stats()
+    assert now["live_cells"] == live + 3
+    assert now["peak_live_cells"] >= live + 3
+    del xs
+    now = stats()
+    assert now["live_cells"] == live
+    assert now["cells_freed"] == 3
+    assert now["peak_live_cells"] >= live + 3
+
+
+def test_single_and_bulk_allocations():
+    cons(1, nil())
+    cons.from_xs(range(3))
+    xs = cons.from_xs(range(100))
+    now = stats()
+    assert now["single_allocs"] == 2
+    assert now["bulk_allocs"] == 1
+    assert now["bulk_cells"] == 3
+    assert now["chunked_lists"] == 1
+    xs.tail
+    assert stats()["single_allocs"] == 3
+
+
+def test_untracked_cells():
+    cons(1, cons(2, nil()))
+    cons([], nil())
+    cons.from_xs(range(100))
+    assert stats()["untracked_cells"] == 3
+
+
+def test_assoc_and_assp_probes():
+    alist = cons.from_xs([cons(i, str(i)) for i in range(20)])
+    assoc(9, alist)
+    assoc(-1, alist)
+    assp(lambda k: k == 4, alist)
+    now = stats()
+    assert (now["assoc_calls"], now["assoc_probes"]) == (2, 30)
+    assert (now["assp_calls"], now["assp_probes"]) == (1, 5)
+
+
+def test_indexed_assoc_is_one_probe():
+    alist = cons.from_xs([cons(i, str(i)) for i in range(20)])
+    assoc(9, alist, indexed=True)
+    stats(reset=True)
+    assoc(19, alist, indexed=True)
+    assert stats()["assoc_probes"] == 1
+
+
+def test_compare_and_hash_calls():
+    xs, ys = cons.from_xs([1, 2]), cons.from_xs([1, 2])
+    assert xs == ys
+    assert xs < cons.from_xs([1, 3])
+    hash(xs)
+    hash(xs)
+    now = stats()
+    assert now["compare_calls"] == 2
+    assert now["hash_calls"] == 2
+
+
+def test_max_depths():
+    obj = [1]
+    for _ in range(9):
+        obj = [obj]
+    xs = cons.lift(obj)
+    hash(xs)
+    now = stats()
+    assert now["lift_max_depth"] == 10
+    assert now["hash_max_depth"] == 10
+    hash(xs)
+    stats(reset=True)
+    hash(xs)
+    assert stats()["hash_max_depth"] == 0
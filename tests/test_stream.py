@@ -0,0 +1,129 @@
+import itertools
+
+import pytest
+from fastcons import cons, drop, hamt, nil, take
+
+
+def counting(xs, pulled):
+    for x in xs:
+        pulled.append(x)
+        yield x
+
+
+def test_stream_is_lazy():
+    pulled = []
+    xs = cons.stream(counting(range(5), pulled))
+    assert pulled == [0]
+    assert xs.head == 0
+    assert xs.tail.head == 1
+    assert pulled == [0, 1]
+
+
+def test_stream_tail_is_memoized():
+    pulled = []
+    xs = cons.stream(counting(range(3), pulled))
+    assert xs.tail is xs.tail
+    assert xs.tail.tail.tail is nil()
+    assert pulled == [0, 1, 2]
+
+
+def test_stream_of_empty_iterable_is_nil():
+    assert cons.stream([]) is nil()
+    assert cons.stream(iter(())) is nil()
+
+
+def test_stream_iteration_forces_one_item_at_a_time():
+    pulled = []
+    it = iter(cons.stream(counting(range(4), pulled)))
+    assert next(it) == 0
+    assert pulled == [0]
+    assert next(it) == 1
+    assert pulled == [0, 1]
+    assert list(it) == [2, 3]
+
+
+def test_stream_repr_shows_forced_items_only():
+    xs = cons.stream("abc")
+    assert repr(xs) == "('a' ...)"
+    xs.tail
+    assert repr(xs) == "('a' 'b' ...)"
+    xs.to_list()
+    assert repr(xs) == "('a' 'b' 'c')"
+
+
+def test_stream_equals_list():
+    xs = cons.stream(range(100))
+    assert xs == cons.from_xs(range(100))
+    assert xs != cons.from_xs(range(99))
+    assert hash(xs) == hash(cons.from_xs(range(100)))
+    assert len(xs) == 100
+
+
+def test_infinite_streams_compare_lexicographically():
+    assert cons.stream(itertools.count()) < cons.stream(itertools.count(1))
+    assert cons.stream(itertools.count()) != cons.stream(itertools.count(1))
+
+
+def test_cons_onto_stream_is_stream():
+    xs = cons(0, cons.stream("ab"))
+    assert repr(xs) == "(0 'a' ...)"
+    assert list(xs) == [0, "a", "b"]
+    assert len(xs) == 3
+
+
+def test_stream_pattern_matching():
+    match cons.stream("ab"):
+        case cons(a, cons(b, rest)):
+            assert (a, b, rest) == ("a", "b", nil())
+        case _:
+            pytest.fail("no match")
+
+
+def test_stream_error_propagates_and_retries():
+    def failing():
+        yield 1
+        raise KeyError("boom")
+
+    xs = cons.stream(failing())
+    with pytest.raises(KeyError):
+        xs.tail
+    assert repr(xs) == "(1 ...)"
+    assert xs.tail is nil()
+
+
+def test_stream_forced_recursively_raises():
+    box = []
+
+    def reentrant():
+        yield 1
+        box[0].tail
+        yield 2
+
+    box.append(cons.stream(reentrant()))
+    with pytest.raises(RuntimeError):
+        box[0].tail
+
+
+def test_stream_pair_values_are_forced():
+    alist = cons.from_xs([cons("a", cons.stream("bc"))])
+    assert hamt(alist)["a"] == cons.from_xs("bc")
+
+
+def test_take_forces_only_n_items():
+    pulled = []
+    xs = take(3, cons.stream(counting(itertools.count(), pulled)))
+    assert list(xs) == [0, 1, 2]
+    assert pulled == [0, 1, 2]
+
+    def failing():
+        yield from range(2)
+        raise RuntimeError("boom")
+
+    assert list(take(2, cons.stream(failing()))) == [0, 1]
+
+
+def test_drop_forces_up_to_the_new_head():
+    pulled = []
+    xs = drop(3, cons.stream(counting(itertools.count(), pulled)))
+    assert xs.head == 3
+    assert pulled == [0, 1, 2, 3]
@@ -0,0 +1,67 @@
+import threading
+
+import fastcons
+import pytest
+from fastcons import cons, nil
+
+THREADS = 8
+
+
+def run_together(target, *args):
+    """Run target(*args) in several threads at once, returning their results."""
+    barrier = threading.Barrier(THREADS)
+    results = [None] * THREADS
+    errors = []
+
+    def run(i):
+        barrier.wait()
+        try:
+            results[i] = target(*args)
+        except BaseException as e:
+            errors.append(e)
+
+    threads = [threading.Thread(target=run, args=(i,)) for i in range(THREADS)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    if errors:
+        raise errors[0]
+    return results
+
+
+def tails(xs):
+    cells = []
+    while xs is not nil():
+        cells.append(xs)
+        xs = xs.tail
+    return cells
+
+
+@pytest.mark.parametrize(
+    "build", [lambda: cons.from_xs(range(1000)), lambda: cons.stream(iter(range(1000)))]
+)
+def test_threads_share_forced_tails(build):
+    xs = build()
+    results = run_together(tails, xs)
+    assert len(results[0]) == 1000
+    for cells in results[1:]:
+        assert all(a is b for a, b in zip(cells, results[0], strict=True))
+    assert [cell.head for cell in results[0]] == list(range(1000))
+
+
+def test_threads_read_shared_chunk():
+    xs = cons.from_xs(range(1000))
+    expected = list(range(1000))
+    results = run_together(lambda: (list(xs), xs.to_list(), hash(xs), repr(xs)))
+    assert all(result == results[0] for result in results)
+    assert results[0][:2] == (expected, expected)
+
+
+def test_threads_share_indexed_assoc():
+    alist = cons.from_xs([cons(i, str(i)) for i in range(100)])
+    results = run_together(
+        lambda: [fastcons.assoc(i, alist, indexed=True) for i in range(100)]
+    )
+    for result in results:
+        assert result == [cons(i, str(i)) for i in range(100)]